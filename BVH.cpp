@@ -0,0 +1,326 @@
+#include "BVH.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+//items per leaf:
+static constexpr uint32_t MaxLeafItems = 8;
+//number of bins to use when evaluating SAH splits:
+static constexpr uint32_t SplitBins = 16;
+
+static float surface_area(glm::vec3 const &min, glm::vec3 const &max) {
+	glm::vec3 e = glm::max(max - min, glm::vec3(0.0f));
+	return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+void BVH::clear() {
+	nodes.clear();
+	items.clear();
+	item_mins.clear();
+	item_maxs.clear();
+	built_area = 0.0f;
+}
+
+void BVH::build(size_t count, glm::vec3 const *mins, glm::vec3 const *maxs) {
+	clear();
+	if (count == 0) return;
+
+	item_mins.assign(mins, mins + count);
+	item_maxs.assign(maxs, maxs + count);
+
+	items.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		items[i] = i;
+	}
+
+	std::vector< glm::vec3 > centroids(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		centroids[i] = 0.5f * (item_mins[i] + item_maxs[i]);
+	}
+
+	//(rough guess at the final node count, to avoid most re-allocation)
+	nodes.reserve(2 * count / (MaxLeafItems / 2) + 1);
+
+	//build node for items [begin,end), appending it (and its children) to nodes:
+	std::function< void(uint32_t, uint32_t) > build_node = [&](uint32_t begin, uint32_t end) {
+		uint32_t index = uint32_t(nodes.size());
+		nodes.emplace_back();
+
+		glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+		glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
+		glm::vec3 cmin = min, cmax = max;
+		for (uint32_t i = begin; i < end; ++i) {
+			min = glm::min(min, item_mins[items[i]]);
+			max = glm::max(max, item_maxs[items[i]]);
+			cmin = glm::min(cmin, centroids[items[i]]);
+			cmax = glm::max(cmax, centroids[items[i]]);
+		}
+		nodes[index].min = min;
+		nodes[index].max = max;
+
+		auto make_leaf = [&]() {
+			nodes[index].index = begin;
+			nodes[index].count = end - begin;
+		};
+
+		uint32_t count = end - begin;
+		if (count <= 2) {
+			make_leaf();
+			return;
+		}
+
+		//evaluate binned SAH splits along each axis:
+		float best_cost = std::numeric_limits< float >::infinity();
+		uint32_t best_axis = 0;
+		uint32_t best_split = 0; //items in bins [0,best_split) go left
+		for (uint32_t axis = 0; axis < 3; ++axis) {
+			float extent = cmax[axis] - cmin[axis];
+			if (!(extent > 0.0f)) continue;
+			float scale = SplitBins / extent;
+
+			struct Bin {
+				glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+				glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
+				uint32_t count = 0;
+			} bins[SplitBins];
+			for (uint32_t i = begin; i < end; ++i) {
+				uint32_t item = items[i];
+				uint32_t b = std::min(SplitBins - 1, uint32_t((centroids[item][axis] - cmin[axis]) * scale));
+				bins[b].min = glm::min(bins[b].min, item_mins[item]);
+				bins[b].max = glm::max(bins[b].max, item_maxs[item]);
+				bins[b].count += 1;
+			}
+
+			//sweep from the right to get area * count of everything right of each split:
+			float right_cost[SplitBins];
+			{
+				glm::vec3 rmin = glm::vec3( std::numeric_limits< float >::infinity());
+				glm::vec3 rmax = glm::vec3(-std::numeric_limits< float >::infinity());
+				uint32_t rcount = 0;
+				for (uint32_t b = SplitBins - 1; b > 0; --b) {
+					rmin = glm::min(rmin, bins[b].min);
+					rmax = glm::max(rmax, bins[b].max);
+					rcount += bins[b].count;
+					right_cost[b] = (rcount ? surface_area(rmin, rmax) * rcount : 0.0f);
+				}
+			}
+			//...and sweep from the left to combine:
+			glm::vec3 lmin = glm::vec3( std::numeric_limits< float >::infinity());
+			glm::vec3 lmax = glm::vec3(-std::numeric_limits< float >::infinity());
+			uint32_t lcount = 0;
+			for (uint32_t split = 1; split < SplitBins; ++split) {
+				lmin = glm::min(lmin, bins[split-1].min);
+				lmax = glm::max(lmax, bins[split-1].max);
+				lcount += bins[split-1].count;
+				if (lcount == 0 || lcount == count) continue;
+				float cost = surface_area(lmin, lmax) * lcount + right_cost[split];
+				if (cost < best_cost) {
+					best_cost = cost;
+					best_axis = axis;
+					best_split = split;
+				}
+			}
+		}
+
+		//leaf if no useful split was found (or splitting isn't worth it):
+		float leaf_cost = surface_area(min, max) * count;
+		if (count <= MaxLeafItems && (best_split == 0 || best_cost >= leaf_cost)) {
+			make_leaf();
+			return;
+		}
+
+		uint32_t mid;
+		if (best_split != 0) {
+			float extent = cmax[best_axis] - cmin[best_axis];
+			float scale = SplitBins / extent;
+			uint32_t axis = best_axis, split = best_split;
+			mid = uint32_t(std::partition(items.begin() + begin, items.begin() + end, [&](uint32_t item) {
+				return std::min(SplitBins - 1, uint32_t((centroids[item][axis] - cmin[axis]) * scale)) < split;
+			}) - items.begin());
+		} else {
+			//all centroids coincide (or aren't finite); just split in half:
+			mid = begin + count / 2;
+		}
+		assert(begin < mid && mid < end);
+
+		build_node(begin, mid); //left child is always index + 1
+		nodes[index].index = uint32_t(nodes.size());
+		nodes[index].count = 0;
+		build_node(mid, end);
+	};
+	build_node(0, uint32_t(count));
+
+	built_area = surface_area(nodes[0].min, nodes[0].max);
+}
+
+void BVH::refit(glm::vec3 const *mins, glm::vec3 const *maxs) {
+	item_mins.assign(mins, mins + item_mins.size());
+	item_maxs.assign(maxs, maxs + item_maxs.size());
+
+	//children always come after their parents, so a reverse sweep visits children first:
+	for (uint32_t n = uint32_t(nodes.size()); n > 0; --n) {
+		Node &node = nodes[n-1];
+		if (node.count) {
+			node.min = glm::vec3( std::numeric_limits< float >::infinity());
+			node.max = glm::vec3(-std::numeric_limits< float >::infinity());
+			for (uint32_t i = node.index; i < node.index + node.count; ++i) {
+				node.min = glm::min(node.min, item_mins[items[i]]);
+				node.max = glm::max(node.max, item_maxs[items[i]]);
+			}
+		} else {
+			Node const &left = nodes[n];
+			Node const &right = nodes[node.index];
+			node.min = glm::min(left.min, right.min);
+			node.max = glm::max(left.max, right.max);
+		}
+	}
+}
+
+bool BVH::should_rebuild() const {
+	if (nodes.empty()) return false;
+	//refitting as things move apart makes boxes grow and overlap; rebuild once the root has grown a lot:
+	return surface_area(nodes[0].min, nodes[0].max) > 2.0f * built_area;
+}
+
+void BVH::query(Frustum const &frustum, std::vector< uint32_t > *out_) const {
+	assert(out_);
+	auto &out = *out_;
+	if (nodes.empty()) return;
+
+	//classify a box as outside (-1), crossing (0), or inside (1) the frustum:
+	auto classify = [&frustum](glm::vec3 const &min, glm::vec3 const &max) {
+		glm::vec3 center = 0.5f * (max + min);
+		glm::vec3 radius = 0.5f * (max - min);
+		int ret = 1;
+		for (auto const &plane : frustum.planes) {
+			glm::vec3 normal = glm::vec3(plane);
+			float d = glm::dot(normal, center) + plane.w;
+			float r = glm::dot(glm::abs(normal), radius);
+			if (d + r < 0.0f) return -1;
+			if (d - r < 0.0f) ret = 0;
+		}
+		return ret;
+	};
+
+	std::vector< uint32_t > stack;
+	stack.reserve(64);
+	stack.emplace_back(0);
+	while (!stack.empty()) {
+		uint32_t n = stack.back();
+		stack.pop_back();
+		Node const &node = nodes[n];
+
+		int c = classify(node.min, node.max);
+		if (c < 0) continue;
+		if (c > 0) {
+			//entirely inside -- take every item below this node without further tests;
+			// items of a subtree are contiguous, running from its leftmost leaf to its rightmost leaf:
+			uint32_t first = n;
+			while (nodes[first].count == 0) first = first + 1;
+			uint32_t last = n;
+			while (nodes[last].count == 0) last = nodes[last].index;
+			out.insert(out.end(), items.begin() + nodes[first].index, items.begin() + nodes[last].index + nodes[last].count);
+			continue;
+		}
+		if (node.count) {
+			for (uint32_t i = node.index; i < node.index + node.count; ++i) {
+				if (classify(item_mins[items[i]], item_maxs[items[i]]) >= 0) out.emplace_back(items[i]);
+			}
+		} else {
+			stack.emplace_back(node.index);
+			stack.emplace_back(n + 1);
+		}
+	}
+}
+
+void BVH::query(glm::vec3 const &min, glm::vec3 const &max, std::vector< uint32_t > *out_) const {
+	assert(out_);
+	auto &out = *out_;
+	if (nodes.empty()) return;
+
+	auto overlaps = [&min, &max](glm::vec3 const &bmin, glm::vec3 const &bmax) {
+		return bmin.x <= max.x && min.x <= bmax.x
+		    && bmin.y <= max.y && min.y <= bmax.y
+		    && bmin.z <= max.z && min.z <= bmax.z;
+	};
+
+	std::vector< uint32_t > stack;
+	stack.reserve(64);
+	stack.emplace_back(0);
+	while (!stack.empty()) {
+		uint32_t n = stack.back();
+		stack.pop_back();
+		Node const &node = nodes[n];
+		if (!overlaps(node.min, node.max)) continue;
+		if (node.count) {
+			for (uint32_t i = node.index; i < node.index + node.count; ++i) {
+				if (overlaps(item_mins[items[i]], item_maxs[items[i]])) out.emplace_back(items[i]);
+			}
+		} else {
+			stack.emplace_back(node.index);
+			stack.emplace_back(n + 1);
+		}
+	}
+}
+
+bool BVH::raycast(glm::vec3 const &origin, glm::vec3 const &direction, float max_t, uint32_t *item_, float *t_) const {
+	if (nodes.empty()) return false;
+
+	glm::vec3 inv_dir = glm::vec3(1.0f) / direction; //(infinities for zero components are fine for slab tests)
+
+	//returns the entry distance of the ray into the box, or infinity if it misses:
+	auto hit = [&](glm::vec3 const &min, glm::vec3 const &max) {
+		float t0 = 0.0f, t1 = max_t;
+		for (uint32_t a = 0; a < 3; ++a) {
+			float n = (min[a] - origin[a]) * inv_dir[a];
+			float f = (max[a] - origin[a]) * inv_dir[a];
+			if (n > f) std::swap(n, f);
+			//(NaN from 0 * inf means the ray lies in the slab's plane; treat as not limiting)
+			if (n == n) t0 = std::max(t0, n);
+			if (f == f) t1 = std::min(t1, f);
+		}
+		return (t0 <= t1 ? t0 : std::numeric_limits< float >::infinity());
+	};
+
+	float best_t = std::numeric_limits< float >::infinity();
+	uint32_t best_item = -1U;
+
+	//(node, entry distance) pairs; nearer children are pushed last so they are visited first:
+	std::vector< std::pair< uint32_t, float > > stack;
+	stack.reserve(64);
+	float root_t = hit(nodes[0].min, nodes[0].max);
+	if (root_t < best_t) stack.emplace_back(0, root_t);
+	while (!stack.empty()) {
+		auto [n, node_t] = stack.back();
+		stack.pop_back();
+		if (node_t >= best_t) continue;
+		Node const &node = nodes[n];
+		if (node.count) {
+			for (uint32_t i = node.index; i < node.index + node.count; ++i) {
+				float t = hit(item_mins[items[i]], item_maxs[items[i]]);
+				if (t < best_t) {
+					best_t = t;
+					best_item = items[i];
+				}
+			}
+		} else {
+			uint32_t left = n + 1, right = node.index;
+			float left_t = hit(nodes[left].min, nodes[left].max);
+			float right_t = hit(nodes[right].min, nodes[right].max);
+			if (left_t < right_t) {
+				std::swap(left, right);
+				std::swap(left_t, right_t);
+			}
+			if (left_t < best_t) stack.emplace_back(left, left_t);
+			if (right_t < best_t) stack.emplace_back(right, right_t);
+		}
+	}
+
+	if (best_item == -1U) return false;
+	if (item_) *item_ = best_item;
+	if (t_) *t_ = best_t;
+	return true;
+}
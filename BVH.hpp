@@ -0,0 +1,58 @@
+#pragma once
+
+/*
+ * A BVH ("bounding volume hierarchy") is a binary tree of axis-aligned boxes
+ * over a set of items (each with its own box), used to quickly find the items
+ * in a view frustum, hit by a ray, or overlapping a box.
+ *
+ * Trees are built top-down using binned SAH ("surface area heuristic") splits,
+ * and can be refit (bounds updated without changing the tree) when items move.
+ *
+ */
+
+#include "Frustum.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct BVH {
+	//(re)build the tree over 'count' items with boxes [mins[i], maxs[i]]:
+	void build(size_t count, glm::vec3 const *mins, glm::vec3 const *maxs);
+
+	//update item boxes (same count as build) and node bounds, without changing the tree:
+	void refit(glm::vec3 const *mins, glm::vec3 const *maxs);
+
+	//has refitting made the tree enough worse than a fresh build that rebuilding is worth it?
+	bool should_rebuild() const;
+
+	void clear();
+
+	//append the indices of items whose boxes (possibly) intersect the frustum to *out:
+	void query(Frustum const &frustum, std::vector< uint32_t > *out) const;
+
+	//append the indices of items whose boxes overlap the box [min,max] to *out:
+	void query(glm::vec3 const &min, glm::vec3 const &max, std::vector< uint32_t > *out) const;
+
+	//find the first item box hit by the ray origin + t * direction for 0 <= t <= max_t:
+	// returns false if no box is hit, otherwise sets *item and *t (t == 0 if origin is inside the box)
+	bool raycast(glm::vec3 const &origin, glm::vec3 const &direction, float max_t, uint32_t *item, float *t) const;
+
+	//-- internals --
+
+	//nodes are stored depth-first, so a node's left child (if any) directly follows it:
+	struct Node {
+		glm::vec3 min;
+		uint32_t index; //interior: index of right child; leaf: first entry in 'items'
+		glm::vec3 max;
+		uint32_t count; //interior: 0; leaf: number of items
+	};
+	static_assert(sizeof(Node) == 32, "Node is packed.");
+	std::vector< Node > nodes;
+
+	std::vector< uint32_t > items; //item indices, grouped by leaf
+	std::vector< glm::vec3 > item_mins, item_maxs; //item boxes (indexed by item)
+
+	float built_area = 0.0f; //surface area of root at last build (used by should_rebuild)
+};
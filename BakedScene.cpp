@@ -0,0 +1,338 @@
+#include "BakedScene.hpp"
+#include "MappedFile.hpp"
+#include "Mesh.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+uint64_t BakedScene::checksum(char const *begin, char const *end) {
+	//four independent lanes, so the multiplies can overlap:
+	uint64_t lanes[4] = { 0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL, 0x9e3779b97f4a7c15ULL, 0x7f4a7c159e3779b9ULL };
+	auto mix = [](uint64_t h, uint64_t word) {
+		h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+		return h ^ (h >> 29);
+	};
+	char const *at = begin;
+	for (; end - at >= 32; at += 32) {
+		uint64_t words[4];
+		std::memcpy(words, at, 32);
+		for (uint32_t l = 0; l < 4; ++l) {
+			lanes[l] = mix(lanes[l], words[l]);
+		}
+	}
+	uint64_t h = 0;
+	for (uint32_t l = 0; l < 4; ++l) {
+		h = mix(h, lanes[l]);
+	}
+	for (; at < end; at += 8) {
+		uint64_t word = 0;
+		std::memcpy(&word, at, std::min< ptrdiff_t >(8, end - at));
+		h = mix(h, word);
+	}
+	return mix(h, uint64_t(end - begin));
+}
+
+std::vector< char > BakedScene::bake(std::string const &scene_file, MeshBuffer const &meshes) {
+	//load the scene, resolving every mesh as it goes (and recording each distinct mesh once):
+	std::vector< BakedScene::Mesh > baked_meshes;
+	std::vector< std::string > mesh_names;
+	std::unordered_map< std::string, uint32_t > mesh_index;
+	std::vector< std::pair< Scene::Transform const *, uint32_t > > drawables; //(transform, mesh)
+	Scene scene;
+	scene.load(scene_file, [&](Scene &, Scene::Transform *transform, std::string const &mesh_name) {
+		auto f = mesh_index.find(mesh_name);
+		if (f == mesh_index.end()) {
+			::Mesh const &mesh = meshes.lookup(mesh_name);
+
+			BakedScene::Mesh b;
+			b.name_begin = b.name_end = 0; //(filled in below)
+			b.type = mesh.type;
+			b.start = mesh.start;
+			b.count = mesh.count;
+			b.index_type = mesh.index_type;
+			for (uint32_t l = 0; l < Scene::Drawable::Pipeline::LODCount; ++l) {
+				if (l < mesh.lods.size()) {
+					b.lods[l].start = mesh.lods[l].start;
+					b.lods[l].count = mesh.lods[l].count;
+					b.lods[l].error = mesh.lods[l].error;
+				} else {
+					b.lods[l].start = b.lods[l].count = 0;
+					b.lods[l].error = 0.0f;
+				}
+			}
+			b.min = mesh.min;
+			b.max = mesh.max;
+			b.position_offset = mesh.position_offset;
+			b.position_scale = mesh.position_scale;
+
+			f = mesh_index.emplace(mesh_name, uint32_t(baked_meshes.size())).first;
+			baked_meshes.emplace_back(b);
+			mesh_names.emplace_back(mesh_name);
+		}
+		drawables.emplace_back(transform, f->second);
+	});
+
+	//names block:
+	std::string names;
+	auto add_name = [&names](std::string_view name, uint32_t *begin, uint32_t *end) {
+		*begin = uint32_t(names.size());
+		names += name;
+		*end = uint32_t(names.size());
+	};
+
+	//transforms (load() keeps the file's order, which is parents-first):
+	std::unordered_map< Scene::Transform const *, uint32_t > transform_index;
+	std::vector< BakedScene::Transform > transforms;
+	transforms.reserve(scene.transforms.size());
+	for (auto const &t : scene.transforms) {
+		BakedScene::Transform b;
+		if (t.parent) {
+			auto f = transform_index.find(t.parent);
+			if (f == transform_index.end()) throw std::runtime_error("transform '" + std::string(t.name) + "' comes before its parent.");
+			b.parent = f->second;
+		} else {
+			b.parent = -1U;
+		}
+		add_name(t.name, &b.name_begin, &b.name_end);
+		b.position = t.position;
+		b.rotation = t.rotation;
+		b.scale = t.scale;
+		transform_index.emplace(&t, uint32_t(transforms.size()));
+		transforms.emplace_back(b);
+	}
+	auto index_of = [&transform_index](Scene::Transform const *transform) {
+		auto f = transform_index.find(transform);
+		if (f == transform_index.end()) throw std::runtime_error("scene refers to a transform that isn't in the scene.");
+		return f->second;
+	};
+
+	for (uint32_t i = 0; i < baked_meshes.size(); ++i) {
+		add_name(mesh_names[i], &baked_meshes[i].name_begin, &baked_meshes[i].name_end);
+	}
+
+	std::vector< BakedScene::Drawable > baked_drawables;
+	baked_drawables.reserve(drawables.size());
+	for (auto const &d : drawables) {
+		BakedScene::Drawable b;
+		b.transform = index_of(d.first);
+		b.mesh = d.second;
+		baked_drawables.emplace_back(b);
+	}
+
+	std::vector< BakedScene::Camera > cameras;
+	for (auto const &c : scene.cameras) {
+		BakedScene::Camera b;
+		b.transform = index_of(c.transform);
+		b.fovy = c.fovy;
+		b.aspect = c.aspect;
+		b.near = c.near;
+		cameras.emplace_back(b);
+	}
+
+	std::vector< BakedScene::Light > lights;
+	for (auto const &l : scene.lights) {
+		BakedScene::Light b;
+		b.transform = index_of(l.transform);
+		b.type = uint32_t(l.type);
+		b.energy = l.energy;
+		b.spot_fov = l.spot_fov;
+		lights.emplace_back(b);
+	}
+
+	//lay out the file:
+	std::vector< char > data(sizeof(BakedScene::Header), '\0');
+	auto append = [&data](void const *records, size_t bytes, size_t count) {
+		data.resize((data.size() + 15) / 16 * 16, '\0');
+		if (data.size() + bytes > 0xffffffffULL) throw std::runtime_error("scene is too large to bake.");
+		BakedScene::Section section;
+		section.offset = uint32_t(data.size());
+		section.count = uint32_t(count);
+		data.insert(data.end(), reinterpret_cast< char const * >(records), reinterpret_cast< char const * >(records) + bytes);
+		return section;
+	};
+
+	BakedScene::Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, "bsc0", 4);
+	header.version = BakedScene::Version;
+	header.meshes_size = meshes.file_size;
+	header.meshes_vertices = meshes.vertex_total;
+	header.meshes_indices = meshes.index_total;
+	header.transforms = append(transforms.data(), transforms.size() * sizeof(BakedScene::Transform), transforms.size());
+	header.meshes = append(baked_meshes.data(), baked_meshes.size() * sizeof(BakedScene::Mesh), baked_meshes.size());
+	header.drawables = append(baked_drawables.data(), baked_drawables.size() * sizeof(BakedScene::Drawable), baked_drawables.size());
+	header.cameras = append(cameras.data(), cameras.size() * sizeof(BakedScene::Camera), cameras.size());
+	header.lights = append(lights.data(), lights.size() * sizeof(BakedScene::Light), lights.size());
+	header.names = append(names.data(), names.size(), names.size());
+	data.resize((data.size() + 15) / 16 * 16, '\0');
+
+	header.size = data.size();
+	header.checksum = BakedScene::checksum(data.data() + sizeof(header), data.data() + data.size());
+	std::memcpy(data.data(), &header, sizeof(header));
+
+	return data;
+}
+
+BakedScene::BakedScene(std::string const &filename_) : file(std::make_shared< MappedFile >(filename_)), filename(filename_) {
+	char const *data = file->data;
+	size_t size = file->size;
+
+	if (size < sizeof(Header)) {
+		throw std::runtime_error("baked scene '" + filename + "' is too small to have a header.");
+	}
+	header = reinterpret_cast< Header const * >(data);
+	if (std::string(header->magic, 4) != "bsc0") {
+		throw std::runtime_error("baked scene '" + filename + "' doesn't start with 'bsc0' -- is it a baked scene?");
+	}
+	if (header->version != Version) {
+		throw std::runtime_error("baked scene '" + filename + "' is version " + std::to_string(header->version) + ", not " + std::to_string(Version) + " -- re-bake it.");
+	}
+	if (header->size != size) {
+		throw std::runtime_error("baked scene '" + filename + "' is " + std::to_string(size) + " bytes, but its header says " + std::to_string(header->size) + ".");
+	}
+	if (checksum(data + sizeof(Header), data + size) != header->checksum) {
+		throw std::runtime_error("baked scene '" + filename + "' failed its checksum.");
+	}
+
+	//(records are checked against each other -- and against the mesh buffer -- by instantiate())
+	auto section = [&](Section const &s, size_t record_size, char const *what) -> char const * {
+		if (s.offset % 16 != 0 || s.offset < sizeof(Header) || s.offset > size || (size - s.offset) / record_size < s.count) {
+			throw std::runtime_error("baked scene '" + filename + "' has an invalid " + what + " section.");
+		}
+		return data + s.offset;
+	};
+	transforms = reinterpret_cast< Transform const * >(section(header->transforms, sizeof(Transform), "transforms"));
+	transforms_count = header->transforms.count;
+	meshes = reinterpret_cast< Mesh const * >(section(header->meshes, sizeof(Mesh), "meshes"));
+	meshes_count = header->meshes.count;
+	drawables = reinterpret_cast< Drawable const * >(section(header->drawables, sizeof(Drawable), "drawables"));
+	drawables_count = header->drawables.count;
+	cameras = reinterpret_cast< Camera const * >(section(header->cameras, sizeof(Camera), "cameras"));
+	cameras_count = header->cameras.count;
+	lights = reinterpret_cast< Light const * >(section(header->lights, sizeof(Light), "lights"));
+	lights_count = header->lights.count;
+	names = std::string_view(section(header->names, 1, "names"), header->names.count);
+}
+
+void BakedScene::instantiate(Scene *scene_, MeshBuffer const *buffer, Scene::Drawable::Pipeline const &pipeline,
+	std::function< void(Scene::Drawable &, std::string_view mesh_name) > const &on_drawable) const {
+	assert(scene_);
+	Scene &scene = *scene_;
+
+	//check everything first, so a bad file (or the wrong mesh buffer) doesn't leave a half-built scene:
+	auto fail = [this](std::string const &what) {
+		throw std::runtime_error("baked scene '" + filename + "' " + what);
+	};
+	auto check_name = [&](uint32_t begin, uint32_t end) {
+		if (!(begin <= end && end <= names.size())) fail("has a record with invalid name indices.");
+	};
+	for (uint32_t i = 0; i < transforms_count; ++i) {
+		if (!(transforms[i].parent == -1U || transforms[i].parent < i)) fail("has a transform listed before its parent.");
+		check_name(transforms[i].name_begin, transforms[i].name_end);
+	}
+	if (buffer) {
+		if (header->meshes_size != buffer->file_size || header->meshes_vertices != buffer->vertex_total || header->meshes_indices != buffer->index_total) {
+			fail("was baked against a mesh file with " + std::to_string(header->meshes_vertices) + " vertices and " + std::to_string(header->meshes_indices) + " indices ("
+				+ std::to_string(header->meshes_size) + " bytes), not this one (" + std::to_string(buffer->vertex_total) + " vertices, "
+				+ std::to_string(buffer->index_total) + " indices, " + std::to_string(buffer->file_size) + " bytes) -- re-bake it.");
+		}
+		auto in = [](uint32_t start, uint32_t count, uint32_t total) {
+			return uint64_t(start) + count <= total;
+		};
+		for (uint32_t i = 0; i < meshes_count; ++i) {
+			Mesh const &mesh = meshes[i];
+			check_name(mesh.name_begin, mesh.name_end);
+			bool indexed = (mesh.index_type == GL_UNSIGNED_INT);
+			if (!(indexed || mesh.index_type == 0)
+			 || !in(mesh.start, mesh.count, indexed ? buffer->index_total : buffer->vertex_total)) {
+				fail("has a mesh whose range is outside its mesh buffer.");
+			}
+			for (uint32_t l = 0; l < Scene::Drawable::Pipeline::LODCount; ++l) {
+				if (mesh.lods[l].count != 0 && !(indexed && in(mesh.lods[l].start, mesh.lods[l].count, buffer->index_total))) {
+					fail("has a level of detail whose range is outside its mesh buffer.");
+				}
+			}
+		}
+		for (uint32_t i = 0; i < drawables_count; ++i) {
+			if (drawables[i].transform >= transforms_count || drawables[i].mesh >= meshes_count) fail("has a drawable with an invalid transform or mesh index.");
+		}
+	}
+	for (uint32_t i = 0; i < cameras_count; ++i) {
+		if (cameras[i].transform >= transforms_count) fail("has a camera with an invalid transform index.");
+	}
+	for (uint32_t i = 0; i < lights_count; ++i) {
+		if (lights[i].transform >= transforms_count) fail("has a light with an invalid transform index.");
+		uint32_t type = lights[i].type;
+		if (!(type == Scene::Light::Point || type == Scene::Light::Hemisphere || type == Scene::Light::Spot || type == Scene::Light::Directional)) {
+			fail("has a light of unknown type.");
+		}
+	}
+
+	//transform names point into the mapping, so keep it as long as the names are:
+	scene.name_table->external.emplace_back(file);
+
+	std::vector< Scene::Transform * > made;
+	made.reserve(transforms_count);
+	for (uint32_t i = 0; i < transforms_count; ++i) {
+		Transform const &b = transforms[i];
+		scene.transforms.emplace_back();
+		Scene::Transform &t = scene.transforms.back();
+		t.parent = (b.parent == -1U ? nullptr : made[b.parent]);
+		t.name = name(b.name_begin, b.name_end);
+		t.position = b.position;
+		t.rotation = b.rotation;
+		t.scale = b.scale;
+		made.emplace_back(&t);
+	}
+
+	for (uint32_t i = 0; buffer && i < drawables_count; ++i) {
+		Drawable const &b = drawables[i];
+		Mesh const &mesh = meshes[b.mesh];
+		scene.drawables.emplace_back(made[b.transform]);
+		Scene::Drawable &drawable = scene.drawables.back();
+
+		drawable.pipeline = pipeline;
+		drawable.pipeline.type = mesh.type;
+		drawable.pipeline.start = mesh.start;
+		drawable.pipeline.count = mesh.count;
+		drawable.pipeline.index_type = mesh.index_type;
+		for (uint32_t l = 0; l < Scene::Drawable::Pipeline::LODCount; ++l) {
+			drawable.pipeline.lods[l].start = mesh.lods[l].start;
+			drawable.pipeline.lods[l].count = mesh.lods[l].count;
+			drawable.pipeline.lods[l].error = mesh.lods[l].error;
+		}
+		drawable.pipeline.position_offset = mesh.position_offset;
+		drawable.pipeline.position_scale = mesh.position_scale;
+
+		drawable.min = mesh.min;
+		drawable.max = mesh.max;
+
+		if (on_drawable) on_drawable(drawable, name(mesh.name_begin, mesh.name_end));
+	}
+
+	for (uint32_t i = 0; i < cameras_count; ++i) {
+		Camera const &b = cameras[i];
+		scene.cameras.emplace_back(made[b.transform]);
+		Scene::Camera &camera = scene.cameras.back();
+		camera.fovy = b.fovy;
+		camera.aspect = b.aspect;
+		camera.near = b.near;
+	}
+
+	for (uint32_t i = 0; i < lights_count; ++i) {
+		Light const &b = lights[i];
+		scene.lights.emplace_back(made[b.transform]);
+		Scene::Light &light = scene.lights.back();
+		light.type = static_cast< Scene::Light::Type >(b.type);
+		light.energy = b.energy;
+		light.spot_fov = b.spot_fov;
+	}
+
+	//new transforms (and names), so the name index is out of date:
+	scene.clear_name_index();
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+/*
+ * A BakedScene is a scene (plus the mesh data its drawables need) in a form
+ * that can be used straight out of a memory-mapped file:
+ * every record is fixed-size, refers to others by index rather than by pointer,
+ * and has already been resolved by the baking tool (see bake-scene.cpp).
+ *
+ * So loading one is: map the file, check the header + checksum, and
+ * instantiate() the records into a Scene -- with no parsing and no mesh name lookups
+ * (just a pass over the records' indices first, so a bad file can't point outside the scene or the mesh buffer).
+ *
+ * File layout (offsets are from the start of the file; sections start on 16-byte boundaries):
+ *   Header
+ *   Transform[transforms.count]  -- parents before children
+ *   Mesh[meshes.count]           -- each mesh the drawables use, once
+ *   Drawable[drawables.count]
+ *   Camera[cameras.count]
+ *   Light[lights.count]
+ *   char[names.count]            -- transform and mesh names (ranges are [begin,end) of this block)
+ *
+ * Mesh ranges are only meaningful for the '.pnct' file the scene was baked against, so the header records
+ * that file's size and vertex/index totals, and instantiate() refuses any other buffer.
+ */
+
+#include "Scene.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct MappedFile;
+struct MeshBuffer;
+
+struct BakedScene {
+	//-- file format --
+
+	struct Section {
+		uint32_t offset; //of first record
+		uint32_t count; //number of records (bytes, for names)
+	};
+	static_assert(sizeof(Section) == 8, "Section is packed.");
+
+	struct Header {
+		char magic[4]; //"bsc0"
+		uint32_t version; //BakedScene::Version
+		uint64_t size; //of the whole file
+		uint64_t checksum; //BakedScene::checksum() of everything after the header
+		//the '.pnct' file the mesh ranges were resolved against (instantiate() checks that it's the one it is given):
+		uint64_t meshes_size; //bytes in the file
+		uint32_t meshes_vertices, meshes_indices; //vertices and indices in it
+		Section transforms, meshes, drawables, cameras, lights, names;
+	};
+	static_assert(sizeof(Header) == 4 + 4 + 8 + 8 + 8 + 4 + 4 + 6 * 8, "Header is packed.");
+	enum : uint32_t { Version = 2 };
+
+	struct Transform {
+		uint32_t parent; //index of parent transform (always less than own index), or -1U
+		uint32_t name_begin, name_end;
+		glm::vec3 position;
+		glm::quat rotation;
+		glm::vec3 scale;
+	};
+	static_assert(sizeof(Transform) == 4 + 4 + 4 + 4*3 + 4*4 + 4*3, "Transform is packed.");
+
+	//a mesh, already looked up in the '.pnct' file (fields as in ::Mesh):
+	struct Mesh {
+		uint32_t name_begin, name_end;
+		uint32_t type, start, count, index_type;
+		struct LOD {
+			uint32_t start, count;
+			float error;
+		} lods[Scene::Drawable::Pipeline::LODCount]; //unused levels have count == 0
+		glm::vec3 min, max;
+		glm::vec3 position_offset, position_scale;
+	};
+	static_assert(sizeof(Mesh) == 4 * 6 + 12 * Scene::Drawable::Pipeline::LODCount + 4*3 * 4, "Mesh is packed.");
+
+	struct Drawable {
+		uint32_t transform; //index of transform
+		uint32_t mesh; //index of mesh
+	};
+	static_assert(sizeof(Drawable) == 4 + 4, "Drawable is packed.");
+
+	//cameras and lights, already converted to Scene's units (radians, energy * color):
+	struct Camera {
+		uint32_t transform;
+		float fovy, aspect, near;
+	};
+	static_assert(sizeof(Camera) == 4 * 4, "Camera is packed.");
+
+	struct Light {
+		uint32_t transform;
+		uint32_t type; //Scene::Light::Type
+		glm::vec3 energy;
+		float spot_fov;
+	};
+	static_assert(sizeof(Light) == 4 + 4 + 4*3 + 4, "Light is packed.");
+
+	//checksum used for Header::checksum (mixes in eight bytes at a time, so checking even a large file is quick):
+	static uint64_t checksum(char const *begin, char const *end);
+
+	//-- baking --
+
+	//load a '.scene' file, look up each of its meshes in 'meshes' (loaded from the scene's '.pnct' file), and
+	// return the contents of the baked scene file (used by bake-scene.cpp):
+	// note: will throw if the scene can't be loaded or refers to a mesh that isn't in 'meshes'.
+	static std::vector< char > bake(std::string const &scene_file, MeshBuffer const &meshes);
+
+	//-- loading --
+
+	//map a baked scene file:
+	// note: will throw if the file can't be read, isn't a (current-version) baked scene, or fails its checksum.
+	BakedScene(std::string const &filename);
+
+	//add the baked transforms, drawables, cameras, and lights to a scene:
+	// 'meshes' is the buffer loaded from the '.pnct' file the scene was baked against (or nullptr to leave out the drawables);
+	// each drawable's pipeline is a copy of 'pipeline' (program, vao, uniform locations, textures, ...) with the
+	// baked mesh range, levels of detail, and position decoding filled in, and its bounds are set from the mesh's;
+	// 'on_drawable' (if given) can then adjust each one, given its mesh name.
+	// (transform names point into the mapped file, which the scene's name table keeps around)
+	//NOTE: throws (before adding anything to the scene) if 'meshes' isn't the buffer the scene was baked against,
+	// or if any record refers to a transform, mesh, or vertex range that doesn't exist.
+	void instantiate(Scene *scene, MeshBuffer const *meshes, Scene::Drawable::Pipeline const &pipeline,
+		std::function< void(Scene::Drawable &, std::string_view mesh_name) > const &on_drawable = nullptr) const;
+
+	//records, in place in the mapped file:
+	Header const *header = nullptr;
+	Transform const *transforms = nullptr;
+	uint32_t transforms_count = 0;
+	Mesh const *meshes = nullptr;
+	uint32_t meshes_count = 0;
+	Drawable const *drawables = nullptr;
+	uint32_t drawables_count = 0;
+	Camera const *cameras = nullptr;
+	uint32_t cameras_count = 0;
+	Light const *lights = nullptr;
+	uint32_t lights_count = 0;
+	std::string_view names;
+
+	std::string_view name(uint32_t begin, uint32_t end) const { return names.substr(begin, end - begin); }
+
+	//-- internals --
+	std::shared_ptr< MappedFile > file;
+	std::string filename; //(for error messages)
+};
@@ -0,0 +1,190 @@
+#include "Collision.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+uint32_t Collision::add(Scene::Transform *transform, glm::vec3 const &min, glm::vec3 const &max) {
+	assert(transform);
+	uint32_t id;
+	if (!free_ids.empty()) {
+		id = free_ids.back();
+		free_ids.pop_back();
+		colliders[id] = Collider();
+	} else {
+		id = uint32_t(colliders.size());
+		colliders.emplace_back();
+	}
+	colliders[id].transform = transform;
+	colliders[id].min = min;
+	colliders[id].max = max;
+	return id;
+}
+
+void Collision::remove(uint32_t id) {
+	assert(id < colliders.size() && colliders[id].transform);
+	colliders[id].transform = nullptr;
+	free_ids.emplace_back(id);
+}
+
+bool Collision::overlap(Collider const &a, Collider const &b, Contact *contact) {
+	//separating axis test: the boxes are disjoint iff some axis -- a face normal of either box, or the
+	// cross product of an edge direction from each -- has their projections not overlapping.
+	glm::vec3 offset = b.center - a.center;
+
+	float best_depth = std::numeric_limits< float >::infinity();
+	glm::vec3 best_normal = glm::vec3(0.0f, 0.0f, 1.0f);
+
+	//returns false if axis separates the boxes:
+	auto test_axis = [&](glm::vec3 axis) {
+		float length2 = glm::dot(axis, axis);
+		if (length2 < 1e-8f) return true; //(cross product of parallel edges; covered by face axes)
+		axis /= std::sqrt(length2);
+
+		float ra = a.radius.x * std::abs(glm::dot(a.axes[0], axis))
+		         + a.radius.y * std::abs(glm::dot(a.axes[1], axis))
+		         + a.radius.z * std::abs(glm::dot(a.axes[2], axis));
+		float rb = b.radius.x * std::abs(glm::dot(b.axes[0], axis))
+		         + b.radius.y * std::abs(glm::dot(b.axes[1], axis))
+		         + b.radius.z * std::abs(glm::dot(b.axes[2], axis));
+		float dist = glm::dot(offset, axis);
+		float depth = ra + rb - std::abs(dist);
+		if (depth < 0.0f) return false;
+		if (depth < best_depth) {
+			best_depth = depth;
+			best_normal = (dist < 0.0f ? -axis : axis);
+		}
+		return true;
+	};
+
+	for (uint32_t i = 0; i < 3; ++i) {
+		if (!test_axis(a.axes[i])) return false;
+	}
+	for (uint32_t i = 0; i < 3; ++i) {
+		if (!test_axis(b.axes[i])) return false;
+	}
+	for (uint32_t i = 0; i < 3; ++i) {
+		for (uint32_t j = 0; j < 3; ++j) {
+			if (!test_axis(glm::cross(a.axes[i], b.axes[j]))) return false;
+		}
+	}
+
+	if (contact) {
+		contact->normal = best_normal;
+		contact->depth = best_depth;
+	}
+	return true;
+}
+
+void Collision::update() {
+	stats = Stats();
+	contacts.clear();
+
+	auto in_use = [this](uint32_t id) {
+		return colliders[id].transform != nullptr && colliders[id].enabled;
+	};
+
+	//compute world-space boxes:
+	uint64_t pass = Scene::Transform::new_world_pass();
+	for (uint32_t id = 0; id < colliders.size(); ++id) {
+		if (!in_use(id)) continue;
+		Collider &c = colliders[id];
+
+		glm::mat4x3 local_to_world = c.transform->make_local_to_world(pass);
+		glm::vec3 center = 0.5f * (c.max + c.min);
+		glm::vec3 radius = 0.5f * (c.max - c.min);
+
+		c.center = local_to_world * glm::vec4(center, 1.0f);
+		glm::vec3 world_radius = glm::vec3(0.0f);
+		for (uint32_t i = 0; i < 3; ++i) {
+			//(transforms with non-uniform scale under rotated parents are sheared; their box axes are treated as if perpendicular)
+			float length = glm::length(local_to_world[i]);
+			if (length > 0.0f) {
+				c.axes[i] = local_to_world[i] / length;
+			} else {
+				c.axes[i] = glm::vec3(0.0f);
+				c.axes[i][i] = 1.0f;
+			}
+			c.radius[i] = radius[i] * length;
+			world_radius += glm::abs(c.axes[i]) * c.radius[i];
+		}
+		c.world_min = c.center - world_radius;
+		c.world_max = c.center + world_radius;
+
+		stats.colliders += 1;
+	}
+
+	//update sweep list -- drop colliders no longer in use, then add new ones:
+	size_t kept = 0;
+	in_sweep.assign(colliders.size(), 0);
+	for (uint32_t id : sweep) {
+		if (id < colliders.size() && in_use(id) && !in_sweep[id]) {
+			sweep[kept++] = id;
+			in_sweep[id] = 1;
+		}
+	}
+	sweep.resize(kept);
+	for (uint32_t id = 0; id < colliders.size(); ++id) {
+		if (in_use(id) && !in_sweep[id]) sweep.emplace_back(id);
+	}
+
+	//sort by world_min.x (ids break ties, so the order is fully determined by the boxes):
+	auto before = [this](uint32_t a, uint32_t b) {
+		float ax = colliders[a].world_min.x, bx = colliders[b].world_min.x;
+		return ax < bx || (ax == bx && a < b);
+	};
+	if (sweep.size() > kept) {
+		std::sort(sweep.begin(), sweep.end(), before);
+	} else {
+		//colliders move only a bit each update, so last update's order is nearly sorted -- insertion sort is fast here:
+		for (size_t i = 1; i < sweep.size(); ++i) {
+			uint32_t id = sweep[i];
+			size_t j = i;
+			while (j > 0 && before(id, sweep[j-1])) {
+				sweep[j] = sweep[j-1];
+				--j;
+			}
+			sweep[j] = id;
+		}
+	}
+
+	//sweep along x, keeping a list of colliders whose x range hasn't ended yet:
+	active.clear();
+	for (uint32_t id : sweep) {
+		Collider const &c = colliders[id];
+
+		for (size_t i = 0; i < active.size(); /* later */) {
+			Collider const &o = colliders[active[i]];
+			if (o.world_max.x < c.world_min.x) {
+				//ended before this collider started, so it can't touch anything later in the sweep:
+				active[i] = active.back();
+				active.pop_back();
+				continue;
+			}
+			uint32_t other = active[i];
+			++i;
+
+			if (!(c.layers & o.mask) || !(o.layers & c.mask)) continue;
+			if (c.world_min.y > o.world_max.y || c.world_max.y < o.world_min.y) continue;
+			if (c.world_min.z > o.world_max.z || c.world_max.z < o.world_min.z) continue;
+			stats.candidates += 1;
+
+			uint32_t a = std::min(id, other);
+			uint32_t b = std::max(id, other);
+			Contact contact;
+			if (overlap(colliders[a], colliders[b], &contact)) {
+				contact.a = a;
+				contact.b = b;
+				contacts.emplace_back(contact);
+			}
+		}
+
+		active.emplace_back(id);
+	}
+
+	std::sort(contacts.begin(), contacts.end(), [](Contact const &x, Contact const &y) {
+		return x.a < y.a || (x.a == y.a && x.b < y.b);
+	});
+	stats.contacts = uint32_t(contacts.size());
+}
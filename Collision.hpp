@@ -0,0 +1,76 @@
+#pragma once
+
+/*
+ * Collision tracks box colliders attached to Scene transforms and finds the
+ * pairs that overlap.
+ *
+ * Each collider is a box in its transform's local space, so it follows the
+ * transform's full world matrix (rotation, scale, and parents included).
+ * update() finds candidate pairs by sweep-and-prune over world-space bounding
+ * boxes, then tests candidates exactly as oriented boxes.
+ *
+ * Nothing here touches OpenGL, so it also runs without a window.
+ *
+ */
+
+#include "Scene.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct Collision {
+	struct Collider {
+		Scene::Transform *transform = nullptr; //nullptr => slot is free
+		//box in the transform's local space:
+		// (the default is a unit cube, so a transform's scale gives the collider's size)
+		glm::vec3 min = glm::vec3(-0.5f);
+		glm::vec3 max = glm::vec3( 0.5f);
+		//two colliders are tested only if each one's 'layers' overlaps the other's 'mask':
+		uint32_t layers = 1;
+		uint32_t mask = ~0U;
+		bool enabled = true; //disabled colliders never touch anything
+
+		//world-space oriented box, computed by update():
+		glm::vec3 center = glm::vec3(0.0f);
+		glm::vec3 axes[3] = {glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f)}; //unit length
+		glm::vec3 radius = glm::vec3(0.0f); //half-extent along each of the axes
+		//...and the world-space bounding box of that:
+		glm::vec3 world_min = glm::vec3(0.0f), world_max = glm::vec3(0.0f);
+	};
+	//colliders are referred to by index ("id") in this list; ids stay valid until removed:
+	std::vector< Collider > colliders;
+
+	//add a collider (returns its id; ids of removed colliders are re-used):
+	uint32_t add(Scene::Transform *transform, glm::vec3 const &min = glm::vec3(-0.5f), glm::vec3 const &max = glm::vec3(0.5f));
+	void remove(uint32_t id);
+
+	struct Contact {
+		uint32_t a, b; //collider ids, with a < b
+		glm::vec3 normal; //direction to push b to separate it from a
+		float depth; //distance to push b along normal to separate it from a
+	};
+
+	//compute world-space boxes for all colliders and find all overlapping pairs:
+	// contacts are sorted by (a, b), so results don't depend on collider motion history
+	void update();
+	std::vector< Contact > contacts;
+
+	//what the most recent update() did:
+	struct Stats {
+		uint32_t colliders = 0; //enabled colliders
+		uint32_t candidates = 0; //pairs whose bounding boxes overlapped (and whose layers matched)
+		uint32_t contacts = 0; //pairs whose oriented boxes overlapped
+	} stats;
+
+	//do two colliders' world-space oriented boxes (as of the last update()) overlap?
+	// (on overlap, fills in contact with the separating direction of least penetration)
+	static bool overlap(Collider const &a, Collider const &b, Contact *contact = nullptr);
+
+	//-- internals --
+	std::vector< uint32_t > free_ids; //removed slots in 'colliders'
+	std::vector< uint32_t > sweep; //enabled colliders, sorted by world_min.x (kept between updates, since order changes slowly)
+	std::vector< uint32_t > active; //scratch space for the sweep
+	std::vector< uint8_t > in_sweep; //scratch space for updating 'sweep'
+};
@@ -1,23 +1,43 @@
 #include "DrawLines.hpp"
 #include "PathFont.hpp"
 #include "ColorProgram.hpp"
+#include "Profiler.hpp"
 
 #include "gl_errors.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
 //All DrawLines instances share a vertex array object and vertex buffer, initialized at load time:
 
 //n.b. declared static so they don't conflict with similarly named global variables elsewhere:
 static GLuint vertex_buffer = 0;
 static GLuint vertex_buffer_for_color_program = 0;
 
+//vertex_buffer is used as a ring:
+// each DrawLines writes its vertices just after the previous one's with an unsynchronized map
+// (so the driver never reallocates storage or waits for earlier draws to finish),
+// and a fence after each draw marks when that part of the ring may be overwritten.
+static GLsizeiptr ring_size = 4 << 20; //bytes (grows if a single DrawLines needs more)
+static GLsizeiptr ring_head = 0; //next byte to write
+struct RingFence {
+	GLsizeiptr begin, end; //bytes [begin,end) are in use until 'sync' is signaled
+	GLsync sync;
+};
+static std::deque< RingFence > ring_fences; //oldest first
+
 static Load< void > setup_buffers(LoadTagDefault, [](){
 	//you may recognize this init code from DrawSprites.cpp:
 
 	{ //set up vertex buffer:
 		glGenBuffers(1, &vertex_buffer);
-		//for now, buffer will be un-filled.
+		//allocate storage for the ring (filled as DrawLines are drawn):
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+		glBufferData(GL_ARRAY_BUFFER, ring_size, nullptr, GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
 	{ //vertex array mapping buffer for color_program:
@@ -90,26 +110,30 @@ void DrawLines::draw_box(glm::mat4x3 const &mat, glm::u8vec4 const &color) {
 	draw(mat * glm::vec4( 1.0f, 1.0f,-1.0f, 1.0f), mat * glm::vec4( 1.0f, 1.0f, 1.0f, 1.0f), color);
 }
 
-void DrawLines::draw_text(std::string const &text, glm::vec3 const &anchor_in, glm::vec3 const &x, glm::vec3 const &y, glm::u8vec4 const &color, glm::vec3 *anchor_out) {
-
-	glm::vec3 anchor = anchor_in;
-
-	uint32_t start = 0;
-	while (start < text.size()) {
-		uint32_t end = start;
-		uint32_t glyph = -1U;
-		while (end < text.size()) {
-			end += 1;
-			auto f = PathFont::font.glyph_map.find(text.substr(start, end-start));
-			if (f == PathFont::font.glyph_map.end()) {
-				end -= 1;
-				break;
-			}
-			glyph = f->second;
-		}
+//Text layouts, in glyph space (x along the baseline, y up, 1 unit per character box),
+// cached by string so that text drawn every frame is only laid out once:
+struct TextLayout {
+	std::vector< glm::vec2 > coords; //line endpoints, in pairs
+	float width = 0.0f; //advance past the last glyph
+};
+static std::unordered_map< std::string, TextLayout > layout_cache;
+//(the cache is simply emptied when it gets this big -- e.g., when drawing lots of changing numbers)
+static constexpr size_t MaxCachedLayouts = 1024;
+
+static TextLayout const &layout_text(std::string const &text) {
+	auto f = layout_cache.find(text);
+	if (f != layout_cache.end()) return f->second;
+
+	if (layout_cache.size() >= MaxCachedLayouts) layout_cache.clear();
+	TextLayout &layout = layout_cache[text];
+
+	char const *start = text.data();
+	char const *end = text.data() + text.size();
+	while (start < end) {
+		uint32_t length = 0;
+		uint32_t glyph = PathFont::font.match(start, end, &length);
 		if (glyph == -1U) {
-			assert(start == end);
-			end += 1;
+			length = 1;
 			//missing! draw a tofu:
 			for (const auto &pt : {
 				glm::vec2(0.1f, 0.1f), glm::vec2(0.6f, 0.1f),
@@ -117,19 +141,40 @@ void DrawLines::draw_text(std::string const &text, glm::vec3 const &anchor_in, g
 				glm::vec2(0.9f, 0.6f), glm::vec2(0.1f, 0.9f),
 				glm::vec2(0.1f, 0.9f), glm::vec2(0.1f, 0.1f)
 			}) {
-				attribs.emplace_back(anchor + pt.x * x + pt.y * y, color);
+				layout.coords.emplace_back(layout.width + pt.x, pt.y);
 			}
-			anchor += x * 0.6f;
+			layout.width += 0.6f;
 		} else {
 			for (uint32_t c = PathFont::font.glyph_coord_starts[glyph]; c + 1 < PathFont::font.glyph_coord_starts[glyph+1]; c += 2) {
-				attribs.emplace_back(anchor + x * PathFont::font.coords[c] + y * PathFont::font.coords[c+1], color);
+				layout.coords.emplace_back(layout.width + PathFont::font.coords[c], PathFont::font.coords[c+1]);
 			}
-			anchor += x * PathFont::font.glyph_widths[glyph];
+			layout.width += PathFont::font.glyph_widths[glyph];
 		}
-		start = end;
+		start += length;
 	}
 
-	if (anchor_out) *anchor_out = anchor;
+	return layout;
+}
+
+void DrawLines::draw_text(std::string const &text, glm::vec3 const &anchor, glm::vec3 const &x, glm::vec3 const &y, glm::u8vec4 const &color, glm::vec3 *anchor_out) {
+	TextLayout const &layout = layout_text(text);
+
+	for (auto const &c : layout.coords) {
+		attribs.emplace_back(anchor + x * c.x + y * c.y, color);
+	}
+
+	if (anchor_out) *anchor_out = anchor + x * layout.width;
+}
+
+//wait until the GPU is done with the part of the ring guarded by 'fence':
+static void wait_for(RingFence const &fence) {
+	if (glClientWaitSync(fence.sync, 0, 0) == GL_TIMEOUT_EXPIRED) {
+		profiler.count("DrawLines ring waits", 1);
+		while (glClientWaitSync(fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000 /* 1s */) == GL_TIMEOUT_EXPIRED) {
+			//keep waiting
+		}
+	}
+	glDeleteSync(fence.sync);
 }
 
 DrawLines::~DrawLines() {
@@ -137,10 +182,44 @@ DrawLines::~DrawLines() {
 
 	//based on DrawSprites.cpp :
 
-	//upload vertices to vertex_buffer:
+	//upload vertices to the next free part of vertex_buffer:
+	GLsizeiptr size = GLsizeiptr(attribs.size() * sizeof(attribs[0]));
 	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer); //set vertex_buffer as current
-	glBufferData(GL_ARRAY_BUFFER, attribs.size() * sizeof(attribs[0]), attribs.data(), GL_STREAM_DRAW); //upload attribs array
+
+	if (size > ring_size) {
+		//too big for the ring -- grow it (after everything in flight is done with it):
+		for (auto const &fence : ring_fences) {
+			wait_for(fence);
+		}
+		ring_fences.clear();
+		while (ring_size < size) ring_size *= 2;
+		glBufferData(GL_ARRAY_BUFFER, ring_size, nullptr, GL_STREAM_DRAW);
+		ring_head = 0;
+	}
+	if (ring_head + size > ring_size) ring_head = 0; //(wrap around)
+
+	//make sure no draw in flight is still reading [ring_head, ring_head + size):
+	for (auto fence = ring_fences.begin(); fence != ring_fences.end(); ) {
+		if (fence->begin < ring_head + size && ring_head < fence->end) {
+			wait_for(*fence);
+			fence = ring_fences.erase(fence);
+		} else {
+			++fence;
+		}
+	}
+
+	void *dst = glMapBufferRange(GL_ARRAY_BUFFER, ring_head, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (dst) {
+		std::memcpy(dst, attribs.data(), size);
+		if (!glUnmapBuffer(GL_ARRAY_BUFFER)) {
+			//(contents were lost while mapped -- rare, but allowed by the spec)
+			glBufferSubData(GL_ARRAY_BUFFER, ring_head, size, attribs.data());
+		}
+	} else {
+		glBufferSubData(GL_ARRAY_BUFFER, ring_head, size, attribs.data());
+	}
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	profiler.count("DrawLines bytes", uint64_t(size));
 
 	//set color_program as current program:
 	glUseProgram(color_program->program);
@@ -152,7 +231,11 @@ DrawLines::~DrawLines() {
 	glBindVertexArray(vertex_buffer_for_color_program);
 
 	//run the OpenGL pipeline:
-	glDrawArrays(GL_LINES, 0, GLsizei(attribs.size()));
+	glDrawArrays(GL_LINES, GLint(ring_head / sizeof(attribs[0])), GLsizei(attribs.size()));
+
+	//this part of the ring is in use until the draw finishes:
+	ring_fences.emplace_back(RingFence{ ring_head, ring_head + size, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+	ring_head += size;
 
 	//reset vertex array to none:
 	glBindVertexArray(0);
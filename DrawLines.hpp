@@ -34,6 +34,7 @@ struct DrawLines {
 		glm::vec3 *anchor_out = nullptr);
 
 	//Finish drawing (push attribs to GPU):
+	// (all DrawLines stream their vertices through one ring buffer; bytes streamed are counted by the Profiler)
 	~DrawLines();
 
 
@@ -0,0 +1,77 @@
+#include "Frustum.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FRUSTUM_SSE
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(glm::vec3) == 3*4, "vec3 is packed.");
+
+Frustum::Frustum(glm::mat4 const &world_to_clip) {
+	//clip-space point (x,y,z,w) is inside when -w <= x,y,z <= w,
+	// each half of which is a plane in world space: (row3 +/- row_i) . (p,1) >= 0
+	glm::vec4 rows[4];
+	for (uint32_t r = 0; r < 4; ++r) {
+		rows[r] = glm::vec4(world_to_clip[0][r], world_to_clip[1][r], world_to_clip[2][r], world_to_clip[3][r]);
+	}
+	planes[0] = rows[3] + rows[0]; //left
+	planes[1] = rows[3] - rows[0]; //right
+	planes[2] = rows[3] + rows[1]; //bottom
+	planes[3] = rows[3] - rows[1]; //top
+	planes[4] = rows[3] + rows[2]; //near
+	planes[5] = rows[3] - rows[2]; //far
+}
+
+bool Frustum::intersects(glm::vec3 const &center, glm::vec3 const &radius) const {
+	for (auto const &plane : planes) {
+		glm::vec3 normal = glm::vec3(plane);
+		//distance of the box's closest-to-inside corner:
+		float d = glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), radius);
+		if (d < 0.0f) return false;
+	}
+	return true;
+}
+
+void Frustum::cull(size_t count, glm::vec3 const *centers, glm::vec3 const *radii, uint8_t *visible) const {
+	size_t i = 0;
+
+	#ifdef FRUSTUM_SSE
+	//four boxes at a time:
+	// (strictly less-than so that the one-float over-read when loading vec3's stays in bounds)
+	auto load_vec3x4 = [](float const *from, __m128 *x, __m128 *y, __m128 *z) {
+		__m128 r0 = _mm_loadu_ps(from + 0);
+		__m128 r1 = _mm_loadu_ps(from + 3);
+		__m128 r2 = _mm_loadu_ps(from + 6);
+		__m128 r3 = _mm_loadu_ps(from + 9);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		*x = r0; *y = r1; *z = r2;
+	};
+	__m128 const zero = _mm_setzero_ps();
+	for (; i + 4 < count; i += 4) {
+		__m128 cx, cy, cz, rx, ry, rz;
+		load_vec3x4(&centers[i].x, &cx, &cy, &cz);
+		load_vec3x4(&radii[i].x, &rx, &ry, &rz);
+
+		__m128 outside = zero;
+		for (auto const &plane : planes) {
+			__m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z);
+			__m128 ax = _mm_set1_ps(std::abs(plane.x)), ay = _mm_set1_ps(std::abs(plane.y)), az = _mm_set1_ps(std::abs(plane.z));
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(plane.w)));
+			__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, rx), _mm_mul_ps(ay, ry)), _mm_mul_ps(az, rz));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+		}
+		int mask = _mm_movemask_ps(outside);
+		visible[i+0] = (mask & 1) ? 0 : 1;
+		visible[i+1] = (mask & 2) ? 0 : 1;
+		visible[i+2] = (mask & 4) ? 0 : 1;
+		visible[i+3] = (mask & 8) ? 0 : 1;
+	}
+	#endif
+
+	//leftovers (or everything, without SSE):
+	for (; i < count; ++i) {
+		visible[i] = intersects(centers[i], radii[i]) ? 1 : 0;
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+/*
+ * A Frustum holds the six planes bounding the visible volume of a
+ * world_to_clip matrix, and can test (many) axis-aligned boxes against it.
+ *
+ */
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+struct Frustum {
+	//extract planes from a world-to-clip matrix:
+	// (works with infinite projections -- the far plane just never rejects anything)
+	Frustum(glm::mat4 const &world_to_clip);
+
+	//planes are stored as (normal, offset); points p with dot(normal, p) + offset >= 0 are inside:
+	glm::vec4 planes[6];
+
+	//does the box with the given center and half-extents (possibly) overlap the frustum?
+	// (conservative: may return true for some boxes near the frustum's corners)
+	bool intersects(glm::vec3 const &center, glm::vec3 const &radius) const;
+
+	//test 'count' boxes at once, setting visible[i] to 1 if box i intersects, 0 if not:
+	// (uses SSE to test four boxes at a time where available)
+	void cull(size_t count, glm::vec3 const *centers, glm::vec3 const *radii, uint8_t *visible) const;
+};
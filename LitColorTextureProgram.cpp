@@ -1,5 +1,6 @@
 #include "LitColorTextureProgram.hpp"
 
+#include "Mesh.hpp"
 #include "gl_compile_program.hpp"
 #include "gl_errors.hpp"
 
@@ -43,16 +44,33 @@ Load< LitColorTextureProgram > lit_color_texture_program(LoadTagEarly, []() -> L
 	return ret;
 });
 
-LitColorTextureProgram::LitColorTextureProgram() {
+Load< LitColorTextureProgram > lit_color_texture_instanced_program(LoadTagEarly, []() -> LitColorTextureProgram const * {
+	LitColorTextureProgram *ret = new LitColorTextureProgram(true);
+
+	lit_color_texture_program_pipeline.instanced_program = ret->program;
+
+	return ret;
+});
+
+LitColorTextureProgram::LitColorTextureProgram(bool instanced) {
 	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
 	program = gl_compile_program(
 		//vertex shader:
-		"#version 330\n"
-		"uniform mat4 OBJECT_TO_CLIP;\n"
-		"uniform mat4x3 OBJECT_TO_LIGHT;\n"
-		"uniform mat3 NORMAL_TO_LIGHT;\n"
-		"in vec4 Position;\n"
-		"in vec3 Normal;\n"
+		std::string("#version 330\n")
+		+ (instanced ?
+			//per-instance matrices come in as attributes:
+			"in mat4 INSTANCE_OBJECT_TO_CLIP;\n"
+			"in mat4x3 INSTANCE_OBJECT_TO_LIGHT;\n"
+			"in mat3 INSTANCE_NORMAL_TO_LIGHT;\n"
+			"#define OBJECT_TO_CLIP INSTANCE_OBJECT_TO_CLIP\n"
+			"#define OBJECT_TO_LIGHT INSTANCE_OBJECT_TO_LIGHT\n"
+			"#define NORMAL_TO_LIGHT INSTANCE_NORMAL_TO_LIGHT\n"
+		:
+			"uniform mat4 OBJECT_TO_CLIP;\n"
+			"uniform mat4x3 OBJECT_TO_LIGHT;\n"
+			"uniform mat3 NORMAL_TO_LIGHT;\n"
+		)
+		+ mesh_vertex_glsl +
 		"in vec4 Color;\n"
 		"in vec2 TexCoord;\n"
 		"out vec3 position;\n"
@@ -60,9 +78,9 @@ LitColorTextureProgram::LitColorTextureProgram() {
 		"out vec4 color;\n"
 		"out vec2 texCoord;\n"
 		"void main() {\n"
-		"	gl_Position = OBJECT_TO_CLIP * Position;\n"
-		"	position = OBJECT_TO_LIGHT * Position;\n"
-		"	normal = NORMAL_TO_LIGHT * Normal;\n"
+		"	gl_Position = OBJECT_TO_CLIP * mesh_position();\n"
+		"	position = OBJECT_TO_LIGHT * mesh_position();\n"
+		"	normal = NORMAL_TO_LIGHT * mesh_normal();\n"
 		"	color = Color;\n"
 		"	texCoord = TexCoord;\n"
 		"}\n"
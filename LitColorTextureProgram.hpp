@@ -5,8 +5,10 @@
 #include "Scene.hpp"
 
 //Shader program that draws transformed, lit, textured vertices tinted with vertex colors:
+// the 'instanced' variant reads its OBJECT_TO_CLIP / OBJECT_TO_LIGHT / NORMAL_TO_LIGHT matrices from
+// per-instance attributes (see Scene::add_instance_attributes) instead of uniforms.
 struct LitColorTextureProgram {
-	LitColorTextureProgram();
+	LitColorTextureProgram(bool instanced = false);
 	~LitColorTextureProgram();
 
 	GLuint program = 0;
@@ -34,7 +36,9 @@ struct LitColorTextureProgram {
 };
 
 extern Load< LitColorTextureProgram > lit_color_texture_program;
+extern Load< LitColorTextureProgram > lit_color_texture_instanced_program;
 
 //For convenient scene-graph setup, copy this object:
 // NOTE: by default, has texture bound to 1-pixel white texture -- so it's okay to use with vertex-color-only meshes.
+// NOTE: instanced_program is set to lit_color_texture_instanced_program, but you will need to set instanced_vao to use it.
 extern Scene::Drawable::Pipeline lit_color_texture_program_pipeline;
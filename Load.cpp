@@ -1,32 +1,220 @@
 #include "Load.hpp"
 
-#include <array>
-#include <list>
+#include "ThreadPool.hpp"
+
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <memory>
+#include <mutex>
 
 namespace {
-	std::array< std::list< std::function< void() > >, MaxLoadTag > &get_load_lists() {
-		static std::array< std::list< std::function< void() > >, MaxLoadTag > load_lists;
-		return load_lists;
+	//every load, in order of creation:
+	std::vector< LoadBase * > &get_loads() {
+		static std::vector< LoadBase * > loads;
+		return loads;
+	}
+	//loads created by add_load_function:
+	std::vector< std::unique_ptr< LoadBase > > &get_owned_loads() {
+		static std::vector< std::unique_ptr< LoadBase > > owned;
+		return owned;
+	}
+
+	//background steps report back through these:
+	std::mutex &get_mutex() {
+		static std::mutex mutex;
+		return mutex;
+	}
+	std::condition_variable &get_prepared_cv() {
+		static std::condition_variable cv;
+		return cv;
+	}
+
+	bool started = false;
+	float load_seconds = 0.0f; //wall time from start to finish
+	std::chrono::high_resolution_clock::time_point start_time;
+
+	bool dependencies_ready(std::vector< LoadBase const * > const &deps) {
+		for (auto dep : deps) {
+			if (!dep->ready()) return false;
+		}
+		return true;
 	}
+
+	float seconds_since(std::chrono::high_resolution_clock::time_point const &before) {
+		return std::chrono::duration< float >(std::chrono::high_resolution_clock::now() - before).count();
+	}
+}
+
+LoadBase::LoadBase(LoadTag tag_, std::function< void() > const &foreground_, std::string const &name_)
+	: name(name_), tag(tag_), foreground(foreground_) {
+	assert(tag < MaxLoadTag);
+	assert(!started && "loads should be created *before* loading starts");
+	get_loads().emplace_back(this);
+}
+
+LoadBase::LoadBase(std::string const &name_, std::vector< LoadBase const * > const &dependencies_,
+	std::function< void() > const &background_, std::function< void() > const &foreground_,
+	std::vector< LoadBase const * > const &finish_dependencies_)
+	: name(name_), dependencies(dependencies_), finish_dependencies(finish_dependencies_), background(background_), foreground(foreground_) {
+	assert(!started && "loads should be created *before* loading starts");
+	get_loads().emplace_back(this);
 }
 
 void add_load_function(LoadTag tag, std::function< void() > const &fn) {
-	auto &load_lists = get_load_lists();
-	assert(tag < load_lists.size());
-	load_lists[tag].emplace_back(fn);
+	get_owned_loads().emplace_back(std::make_unique< LoadBase >(tag, fn));
 }
 
-void call_load_functions() {
-	static bool has_been_called = false;
-	assert(!has_been_called && "call_load_functions should only be called *once*");
-	has_been_called = true;
-
-	auto &load_lists = get_load_lists();
-	for (auto &fn_list : load_lists) {
-		while (!fn_list.empty()) {
-			(*fn_list.begin())(); //call first function in the list
-			fn_list.pop_front(); //remove from list
+void start_load_functions() {
+	assert(!started && "start_load_functions should only be called *once*");
+	started = true;
+	start_time = std::chrono::high_resolution_clock::now();
+
+	auto &loads = get_loads();
+
+	//tagged loads run one after another, ordered by tag and then by creation:
+	std::vector< LoadBase * > tagged;
+	for (auto load : loads) {
+		if (load->tag != MaxLoadTag) tagged.emplace_back(load);
+	}
+	std::stable_sort(tagged.begin(), tagged.end(), [](LoadBase const *a, LoadBase const *b) {
+		return a->tag < b->tag;
+	});
+	for (size_t i = 1; i < tagged.size(); ++i) {
+		tagged[i]->dependencies.emplace_back(tagged[i-1]);
+	}
+
+	//name unnamed loads so they can be reported:
+	uint32_t tag_counts[MaxLoadTag] = {0};
+	for (auto load : tagged) {
+		uint32_t index = tag_counts[load->tag]++;
+		if (load->name.empty()) {
+			static char const *tag_names[MaxLoadTag] = { "LoadTagEarly", "LoadTagDefault", "LoadTagLate" };
+			load->name = std::string(tag_names[load->tag]) + " #" + std::to_string(index);
+		}
+	}
+	for (auto load : loads) {
+		for (auto const *deps : {&load->dependencies, &load->finish_dependencies}) {
+			for (auto dep : *deps) {
+				if (std::find(loads.begin(), loads.end(), dep) == loads.end()) {
+					throw std::runtime_error("Load '" + load->name + "' depends on something that isn't a load.");
+				}
+			}
+		}
+	}
+}
+
+bool update_load_functions() {
+	assert(started && "start_load_functions should be called before update_load_functions");
+	auto &loads = get_loads();
+
+	bool progress = true;
+	while (progress) {
+		progress = false;
+
+		//start every background step that can start, so workers are busy while the main thread runs foreground steps:
+		bool all_ready = true;
+		for (auto load : loads) {
+			if (load->state == LoadBase::Ready) continue;
+			all_ready = false;
+			if (load->state != LoadBase::Waiting || !load->background) continue;
+			if (!dependencies_ready(load->dependencies)) continue;
+
+			load->state = LoadBase::Preparing;
+			ThreadPool::shared().run([load](){
+				auto before = std::chrono::high_resolution_clock::now();
+				try {
+					load->background();
+				} catch (...) {
+					load->error = std::current_exception();
+				}
+				load->background_seconds = seconds_since(before);
+				{
+					std::unique_lock< std::mutex > lock(get_mutex());
+					load->state = LoadBase::Prepared;
+				}
+				get_prepared_cv().notify_all();
+			});
 		}
+
+		if (all_ready) {
+			load_seconds = seconds_since(start_time);
+			return true;
+		}
+
+		//run one foreground step (then go back around, since it may have unblocked background steps):
+		for (auto load : loads) {
+			LoadBase::State state = load->state;
+			if (state == LoadBase::Waiting && !load->background && dependencies_ready(load->dependencies)) {
+				load->state = state = LoadBase::Prepared;
+			}
+			if (state != LoadBase::Prepared) continue;
+
+			if (load->error) std::rethrow_exception(load->error);
+			if (!dependencies_ready(load->finish_dependencies)) continue;
+			auto before = std::chrono::high_resolution_clock::now();
+			if (load->foreground) load->foreground();
+			load->foreground_seconds = seconds_since(before);
+			load->state = LoadBase::Ready;
+			progress = true;
+			break;
+		}
+	}
+
+	//nothing more can happen on this thread; make sure something is still happening elsewhere:
+	for (auto load : loads) {
+		if (load->state == LoadBase::Preparing) return false;
+	}
+	throw std::runtime_error("Loads are waiting on each other (dependency cycle?).");
+}
+
+void call_load_functions() {
+	start_load_functions();
+	while (!update_load_functions()) {
+		//wait for some background step to finish:
+		// (loads that are prepared but still waiting on finish_dependencies don't count -- those only change on this thread;
+		//  once nothing is preparing, though, the next update will either make progress or report a cycle)
+		std::unique_lock< std::mutex > lock(get_mutex());
+		get_prepared_cv().wait(lock, [](){
+			bool preparing = false;
+			for (auto load : get_loads()) {
+				if (load->state == LoadBase::Preparing) preparing = true;
+				if (load->state == LoadBase::Prepared && (load->error || dependencies_ready(load->finish_dependencies))) return true;
+			}
+			return !preparing;
+		});
+	}
+}
+
+float load_progress() {
+	auto &loads = get_loads();
+	if (loads.empty()) return 1.0f;
+	uint32_t ready = 0;
+	for (auto load : loads) {
+		if (load->ready()) ready += 1;
+	}
+	return float(ready) / float(loads.size());
+}
+
+void print_load_timings(std::ostream &to) {
+	auto &loads = get_loads();
+	float background = 0.0f, foreground = 0.0f;
+	for (auto load : loads) {
+		background += load->background_seconds;
+		foreground += load->foreground_seconds;
+	}
+	auto flags = to.flags();
+	auto precision = to.precision();
+	to << "Loaded " << loads.size() << " things in " << std::fixed << std::setprecision(1) << load_seconds * 1000.0f << "ms"
+	   << " (" << background * 1000.0f << "ms on worker threads, " << foreground * 1000.0f << "ms on main thread):\n";
+	for (auto load : loads) {
+		to << "  " << std::setw(8) << (load->background_seconds + load->foreground_seconds) * 1000.0f << "ms  " << load->name;
+		if (load->background) to << " (" << load->background_seconds * 1000.0f << "ms worker, " << load->foreground_seconds * 1000.0f << "ms main)";
+		to << "\n";
 	}
+	to.flags(flags);
+	to.precision(precision);
+	to.flush();
 }
@@ -20,10 +20,39 @@
  * These functions are grouped by 'tags', which allow some sequencing of calls.
  * (particularly, this is useful for loading large data blobs [e.g. Meshes] before looking up individual elements within them.)
  *
+ * Loads can also name the other loads they depend on instead of using a tag, and split their work into
+ * a "prepare" step that runs on a worker thread (reading + parsing files; no OpenGL allowed!)
+ * and a "finish" step that runs on the main thread (uploading to OpenGL):
+ *
+ * Load< MeshBuffer > meshes("meshes", {}, []() -> MeshBuffer * {
+ *     return new MeshBuffer(data_path("meshes.pnct"), MeshBuffer::DeferUpload);
+ * }, [](MeshBuffer *buffer) {
+ *     buffer->upload();
+ * });
+ *
+ * When only the finish step needs another load (e.g., making a vertex array for a program), name it as a
+ * "finish dependency" so the prepare step can start right away:
+ *
+ * Load< MeshBuffer > meshes("meshes", {}, {&some_program}, []() -> MeshBuffer * {
+ *     return new MeshBuffer(data_path("meshes.pnct"), MeshBuffer::DeferUpload);
+ * }, [](MeshBuffer *buffer) {
+ *     buffer->upload();
+ *     meshes_vao = buffer->make_vao_for_program(some_program->program);
+ * });
+ *
+ * Independent loads prepare in parallel, and each load's ready() says whether it is done,
+ * so a loading screen can keep drawing while things stream in (see update_load_functions()).
+ *
  */
 
+#include <atomic>
+#include <cstdint>
+#include <exception>
 #include <functional>
+#include <iostream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 enum LoadTag : uint32_t {
 	LoadTagEarly,
@@ -32,6 +61,44 @@ enum LoadTag : uint32_t {
 	MaxLoadTag //<-- just used to track # of load tags
 };
 
+//Every load (Load< T >, or a function passed to add_load_function) is tracked by a LoadBase:
+struct LoadBase {
+	//loads with a tag run on the main thread, one after another, in order of tag (then order of creation):
+	LoadBase(LoadTag tag, std::function< void() > const &foreground, std::string const &name = "");
+	//loads with dependencies run their 'background' step on a worker thread once dependencies are ready,
+	// then their 'foreground' step on the main thread once finish_dependencies are also ready:
+	LoadBase(std::string const &name, std::vector< LoadBase const * > const &dependencies,
+		std::function< void() > const &background, std::function< void() > const &foreground,
+		std::vector< LoadBase const * > const &finish_dependencies = {});
+
+	LoadBase(LoadBase const &) = delete;
+	LoadBase &operator=(LoadBase const &) = delete;
+
+	//has this load finished?
+	bool ready() const { return state == Ready; }
+
+	std::string name; //used when reporting timings
+	//how long each step took (in seconds), for reporting:
+	float background_seconds = 0.0f;
+	float foreground_seconds = 0.0f;
+
+	//-- internals --
+	LoadTag tag = MaxLoadTag; //MaxLoadTag => uses dependencies instead
+	std::vector< LoadBase const * > dependencies;
+	std::vector< LoadBase const * > finish_dependencies; //only hold back the foreground step
+	std::function< void() > background;
+	std::function< void() > foreground;
+
+	enum State : uint32_t {
+		Waiting, //waiting on dependencies
+		Preparing, //background step is queued or running
+		Prepared, //background step is done, foreground step hasn't run (may be waiting on finish_dependencies)
+		Ready //done
+	};
+	std::atomic< State > state{Waiting};
+	std::exception_ptr error; //exception thrown by background step (rethrown on the main thread)
+};
+
 //Add a function to an internal list of loading functions:
 // (only call *before* "call_load_functions()")
 void add_load_function(LoadTag tag, std::function< void() > const &fn);
@@ -41,21 +108,57 @@ void add_load_function(LoadTag tag, std::function< void() > const &fn);
 // (only call *once*)
 void call_load_functions();
 
+//...or, to keep doing other things (e.g., drawing a loading screen) while loading:
+// call start_load_functions() once, then update_load_functions() (on the main thread) until it returns true.
+// each update runs any main-thread steps that are ready; it returns without waiting for worker threads.
+// (exceptions thrown by loading functions, on any thread, are rethrown from update_load_functions())
+void start_load_functions();
+bool update_load_functions();
+
+//fraction of loads that are ready, in [0,1]:
+float load_progress();
+
+//print how long each load took:
+void print_load_timings(std::ostream &to);
+
 
 //work-around for MSVC not accepting this as a lambda:
 template< typename T >
 T const *new_T() { return new T; }
 
 template< typename T >
-struct Load {
+struct Load : LoadBase {
 	//Constructing a Load< T > adds the passed function to the list of functions to call:
-	Load(LoadTag tag, const std::function< T const *() > &load_fn = new_T< T >) : value(nullptr) {
-		add_load_function(tag, [this,load_fn](){
+	Load(LoadTag tag, const std::function< T const *() > &load_fn = new_T< T >) : LoadBase(tag, nullptr), value(nullptr) {
+		foreground = [this,load_fn](){
 			this->value = load_fn();
 			if (!(this->value)) {
 				throw std::runtime_error("Loading failed.");
 			}
-		});
+		};
+	}
+
+	//Constructing with dependencies prepares the value on a worker thread, then finishes it on the main thread:
+	Load(std::string const &name_, std::vector< LoadBase const * > const &dependencies_,
+		const std::function< T *() > &prepare_fn, const std::function< void(T *) > &finish_fn = nullptr)
+		: Load(name_, dependencies_, {}, prepare_fn, finish_fn) {
+	}
+
+	//...with finish_dependencies_ holding back only finish_fn (prepare_fn starts once dependencies_ are ready):
+	Load(std::string const &name_, std::vector< LoadBase const * > const &dependencies_,
+		std::vector< LoadBase const * > const &finish_dependencies_,
+		const std::function< T *() > &prepare_fn, const std::function< void(T *) > &finish_fn)
+		: LoadBase(name_, dependencies_, nullptr, nullptr, finish_dependencies_), value(nullptr) {
+		background = [this,prepare_fn](){
+			this->prepared = prepare_fn();
+			if (!(this->prepared)) {
+				throw std::runtime_error("Loading failed.");
+			}
+		};
+		foreground = [this,finish_fn](){
+			if (finish_fn) finish_fn(this->prepared);
+			this->value = this->prepared;
+		};
 	}
 
 	//Make a "Load< T >" behave like a "T const *":
@@ -65,17 +168,15 @@ struct Load {
 	T const *operator->() { return value; }
 
 	T const *value;
+	T *prepared = nullptr; //(result of prepare_fn, waiting for finish_fn)
 };
 
 
 //Specialization:
 //Load< void > just calls a function:
 template< >
-struct Load< void > {
+struct Load< void > : LoadBase {
 	//Constructing a Load< T > adds the passed function to the list of functions to call:
-	Load( LoadTag tag, const std::function< void() > &load_fn) {
-		add_load_function(tag, load_fn);
+	Load( LoadTag tag, const std::function< void() > &load_fn) : LoadBase(tag, load_fn) {
 	}
 };
-
-
@@ -30,6 +30,7 @@ if (maek.OS === "windows") {
 		`/I${NEST_LIBS}/SDL2/include`,
 		`/I${NEST_LIBS}/glm/include`,
 		`/I${NEST_LIBS}/libpng/include`,
+		`/I${NEST_LIBS}/zlib/include`,
 		//#disable a few warnings:
 		`/wd4146`, //-1U is still unsigned
 		`/wd4297`, //unforunately SDLmain is nothrow
@@ -49,7 +50,8 @@ if (maek.OS === "windows") {
 		//include paths for nest libraries:
 		`-I${NEST_LIBS}/SDL2/include/SDL2`, `-D_THREAD_SAFE`, //the output of sdl-config --cflags
 		`-I${NEST_LIBS}/glm/include`,
-		`-I${NEST_LIBS}/libpng/include`
+		`-I${NEST_LIBS}/libpng/include`,
+		`-I${NEST_LIBS}/zlib/include`
 	);
 	maek.options.LINKLibs.push(
 		//linker flags for nest libraries:
@@ -63,7 +65,8 @@ if (maek.OS === "windows") {
 		//include paths for nest libraries:
 		`-I${NEST_LIBS}/SDL2/include/SDL2`, `-D_THREAD_SAFE`, //the output of sdl-config --cflags
 		`-I${NEST_LIBS}/glm/include`,
-		`-I${NEST_LIBS}/libpng/include`
+		`-I${NEST_LIBS}/libpng/include`,
+		`-I${NEST_LIBS}/zlib/include`
 	);
 	maek.options.LINKLibs.push(
 		//linker flags for nest libraries:
@@ -103,10 +106,17 @@ if (maek.OS === 'windows') {
 const game_names = [
 	maek.CPP('PlayMode.cpp'),
 	maek.CPP('main.cpp'),
-	maek.CPP('LitColorTextureProgram.cpp')
+	maek.CPP('LitColorTextureProgram.cpp'),
+	maek.CPP('Spawner.cpp')
 	//, maek.CPP('ColorTextureProgram.cpp')  //not used right now, but you might want it
 ];
 
+//(MappedFile finds files in mounted Packs; used by common code and pack-assets)
+const pack_names = [
+	maek.CPP('Pack.cpp'),
+	maek.CPP('MappedFile.cpp')
+];
+
 const common_names = [
 	maek.CPP('data_path.cpp'),
 	maek.CPP('PathFont.cpp'),
@@ -114,24 +124,41 @@ const common_names = [
 	maek.CPP('DrawLines.cpp'),
 	maek.CPP('ColorProgram.cpp'),
 	maek.CPP('Scene.cpp'),
+	maek.CPP('BakedScene.cpp'),
+	maek.CPP('transform_batch.cpp'),
+	maek.CPP('Frustum.cpp'),
+	maek.CPP('BVH.cpp'),
+	maek.CPP('Collision.cpp'),
 	maek.CPP('Mesh.cpp'),
+	...pack_names,
+	maek.CPP('ThreadPool.cpp'),
 	maek.CPP('load_save_png.cpp'),
 	maek.CPP('gl_compile_program.cpp'),
 	maek.CPP('Mode.cpp'),
 	maek.CPP('GL.cpp'),
-	maek.CPP('Load.cpp')
+	maek.CPP('Load.cpp'),
+	maek.CPP('Profiler.cpp')
 ];
 
+//(used by show-meshes and index-meshes)
+const vertex_cache_name = maek.CPP('vertex_cache.cpp');
+
+//(used by show-meshes, show-scene, and checks / benchmarks that draw offscreen)
+const headless_name = maek.CPP('headless.cpp');
+
 const show_mesh_names = [
 	maek.CPP('show-meshes.cpp'),
 	maek.CPP('ShowMeshesProgram.cpp'),
-	maek.CPP('ShowMeshesMode.cpp')
+	maek.CPP('ShowMeshesMode.cpp'),
+	vertex_cache_name,
+	headless_name
 ];
 
 const show_scene_names = [
 	maek.CPP('show-scene.cpp'),
 	maek.CPP('ShowSceneProgram.cpp'),
-	maek.CPP('ShowSceneMode.cpp')
+	maek.CPP('ShowSceneMode.cpp'),
+	headless_name
 ];
 
 //the '[exeFile =] LINK(objFiles, exeFileBase, [, options])' links an array of objects into an executable:
@@ -141,9 +168,59 @@ const show_scene_names = [
 const game_exe = maek.LINK([...game_names, ...common_names], 'dist/game');
 const show_meshes_exe = maek.LINK([...show_mesh_names, ...common_names], 'scenes/show-meshes');
 const show_scene_exe = maek.LINK([...show_scene_names, ...common_names], 'scenes/show-scene');
+//(converts .pnct files to the compact quantized vertex format; doesn't need any of the common code)
+const quantize_meshes_exe = maek.LINK([maek.CPP('quantize-meshes.cpp')], 'scenes/quantize-meshes');
+//(welds vertices and builds vertex-cache-ordered index buffers for .pnct files)
+const index_meshes_exe = maek.LINK([maek.CPP('index-meshes.cpp'), vertex_cache_name], 'scenes/index-meshes');
+//(builds simplified levels of detail for indexed .pnct files)
+const lod_meshes_exe = maek.LINK([maek.CPP('lod-meshes.cpp'), vertex_cache_name], 'scenes/lod-meshes');
+//(resolves a .scene against its .pnct into a baked scene that loads without parsing; see BakedScene.hpp)
+const bake_scene_exe = maek.LINK([maek.CPP('bake-scene.cpp'), ...common_names], 'scenes/bake-scene');
+//(gathers assets into a single compressed pack that the game mounts at startup; see Pack.hpp)
+const pack_assets_exe = maek.LINK([maek.CPP('pack-assets.cpp'), ...pack_names], 'scenes/pack-assets');
+
+//checks: windowless programs that exercise parts of the engine and return non-zero if something is wrong
+// (built by default; 'node Maekfile.js :test' builds and runs them all)
+const checks = [
+	//(copy-on-write scene sharing: Scene::share / edit / resolve)
+	maek.LINK([maek.CPP('check-scene-share.cpp'), ...common_names], 'tests/check-scene-share'),
+	//(sweep-and-prune + oriented box collisions vs brute force)
+	maek.LINK([maek.CPP('check-collision.cpp'), ...common_names], 'tests/check-collision'),
+	//(ThreadPool::parallel_for coverage, and exceptions waiting for running work)
+	maek.LINK([maek.CPP('check-thread-pool.cpp'), ...common_names], 'tests/check-thread-pool'),
+	//(instanced vs one-at-a-time drawing of the game's scene, offscreen, with matching-image check)
+	maek.LINK([maek.CPP('check-instancing.cpp'), maek.CPP('LitColorTextureProgram.cpp'), headless_name, ...common_names], 'tests/check-instancing'),
+];
+
+//benchmarks: windowless programs that time parts of the engine (and may check that, e.g., nothing allocates)
+// (not built by default; 'node Maekfile.js :bench' builds and runs them all)
+const benchmarks = [
+	//(Spawner churn, with zero allocations once the pool is filled)
+	maek.LINK([maek.CPP('bench-spawner.cpp'), maek.CPP('Spawner.cpp'), ...common_names], 'bench/bench-spawner'),
+	//(world matrices per frame: lazy vs per-pass make_local_to_world() vs Scene::update_transforms(), at several hierarchy depths, with all or a few transforms moving)
+	maek.LINK([maek.CPP('bench-world-cache.cpp'), ...common_names], 'bench/bench-world-cache'),
+	//(copying a 200k-transform scene: the old hash-map set() vs Scene::set() vs Scene::share(); time and heap bytes)
+	maek.LINK([maek.CPP('bench-scene-clone.cpp'), ...common_names], 'bench/bench-scene-clone'),
+	//(loading a 150k-transform scene, then exact / prefix / suffix / substring name lookups: Scene's name index vs scanning; time and heap bytes)
+	maek.LINK([maek.CPP('bench-name-index.cpp'), ...common_names], 'bench/bench-name-index'),
+	//(getting a 150k-transform scene ready to draw: .scene + mesh lookups vs .bscene map, checksum, and instantiate)
+	maek.LINK([maek.CPP('bench-baked-scene.cpp'), ...common_names], 'bench/bench-baked-scene'),
+	//(make_local_to_parent_batch kernels -- scalar, SSE, AVX2 -- vs per-transform glm, for 10k-1M transforms)
+	maek.LINK([maek.CPP('bench-transform-batch.cpp'), ...common_names], 'bench/bench-transform-batch'),
+	//(BVH build, refit, frustum queries, and raycasts vs brute force, for 10k-1M boxes)
+	maek.LINK([maek.CPP('bench-bvh.cpp'), ...common_names], 'bench/bench-bvh'),
+	//(loading a multi-hundred-megabyte .pnct through MappedFile vs the old std::ifstream path: wall time and memory)
+	maek.LINK([maek.CPP('bench-mapped-file.cpp'), ...common_names], 'bench/bench-mapped-file'),
+	//(loading many small files plus the game's assets loose vs from a stored pack vs from a deflated pack; time and memory)
+	maek.LINK([maek.CPP('bench-pack.cpp'), ...common_names], 'bench/bench-pack'),
+	//(compute_mesh_bounds -- chunked, threaded, SSE -- vs a serial glm pass, checked bit-for-bit, for 1M-16M vertices)
+	maek.LINK([maek.CPP('bench-bounds.cpp'), ...common_names], 'bench/bench-bounds'),
+	//(drawing a dense mesh from plain vs quantized vertex buffers, offscreen, with matching-image check)
+	maek.LINK([maek.CPP('bench-vertex-fetch.cpp'), maek.CPP('ShowSceneProgram.cpp'), headless_name, ...common_names], 'bench/bench-vertex-fetch'),
+];
 
 //set the default target to the game (and copy the readme files):
-maek.TARGETS = [game_exe, show_meshes_exe, show_scene_exe, ...copies];
+maek.TARGETS = [game_exe, show_meshes_exe, show_scene_exe, quantize_meshes_exe, index_meshes_exe, lod_meshes_exe, bake_scene_exe, pack_assets_exe, ...checks, ...copies];
 
 //the '[targets =] RULE(targets, prerequisites[, recipe])' rule defines a Makefile-style task
 // targets: array of targets the task produces (can include both files and ':abstract targets')
@@ -154,6 +231,9 @@ maek.RULE([':run'], [game_exe], [
 	[game_exe, '--some-command-line-option']
 ]);
 
+maek.RULE([':test'], checks, checks.map(check => [check]));
+maek.RULE([':bench'], benchmarks, benchmarks.map(benchmark => [benchmark]));
+
 //Note that tasks that produce ':abstract targets' are never cached.
 // This is similar to how .PHONY targets behave in make.
 
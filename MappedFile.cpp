@@ -0,0 +1,132 @@
+#include "MappedFile.hpp"
+#include "Pack.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//where data points for empty files, so that it is never nullptr:
+// (loaders then report an empty file through their usual size checks, e.g. find_chunk's "Failed to read chunk header")
+static char const empty_contents[1] = { '\0' };
+
+MappedFile::MappedFile(std::string const &filename) {
+	//files in mounted packs are read from there:
+	Pack::Found found = Pack::find_mounted(filename);
+	if (found.entry) {
+		std::string_view contents = found.pack->read(*found.entry, &fallback);
+		data = contents.data();
+		size = contents.size();
+		if (size == 0) data = empty_contents; //(an empty entry may have been "inflated" into an empty fallback)
+		else if (data != fallback.data()) owner = found.pack;
+		return;
+	}
+
+	#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Failed to open file '" + filename + "'.");
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size)) {
+		CloseHandle(file);
+		throw std::runtime_error("Failed to get size of file '" + filename + "'.");
+	}
+	size = size_t(file_size.QuadPart);
+	if (size == 0) {
+		//(empty files can't be mapped, but there's nothing to map anyway)
+		CloseHandle(file);
+		data = empty_contents;
+		return;
+	}
+	HANDLE mapping_ = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping_ != NULL) {
+		mapping = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+		if (mapping) {
+			file_handle = file;
+			mapping_handle = mapping_;
+			data = reinterpret_cast< char const * >(mapping);
+			return;
+		}
+		CloseHandle(mapping_);
+	}
+	CloseHandle(file);
+	#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1) {
+		throw std::runtime_error("Failed to open file '" + filename + "'.");
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		throw std::runtime_error("Failed to get size of file '" + filename + "'.");
+	}
+	size = size_t(st.st_size);
+	if (size == 0) {
+		//(empty files can't be mapped, but there's nothing to map anyway)
+		close(fd);
+		data = empty_contents;
+		return;
+	}
+	void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); //(mapping stays valid after the descriptor is closed)
+	if (addr != MAP_FAILED) {
+		mapping = addr;
+		data = reinterpret_cast< char const * >(mapping);
+		#if defined(MADV_SEQUENTIAL)
+		madvise(addr, size, MADV_SEQUENTIAL); //(loaders read files front-to-back)
+		#endif
+		return;
+	}
+	#endif
+
+	//couldn't map the file, so read it instead:
+	std::ifstream file_stream(filename, std::ios::binary);
+	fallback.resize(size);
+	if (!file_stream.read(fallback.data(), size)) {
+		throw std::runtime_error("Failed to read file '" + filename + "'.");
+	}
+	data = fallback.data();
+}
+
+MappedFile::~MappedFile() {
+	if (!mapping) return;
+	#if defined(_WIN32)
+	UnmapViewOfFile(mapping);
+	CloseHandle(mapping_handle);
+	CloseHandle(file_handle);
+	#else
+	munmap(mapping, size);
+	#endif
+}
+
+//-------------------------
+
+MappedFileStream::MappedFileStream(MappedFile const &file) : std::istream(nullptr), buffer(file.data, file.data + file.size) {
+	rdbuf(&buffer);
+}
+
+MappedFileStream::Buffer::Buffer(char const *begin, char const *end) {
+	//(streambuf wants non-const pointers, but input-only buffers are never written through)
+	setg(const_cast< char * >(begin), const_cast< char * >(begin), const_cast< char * >(end));
+}
+
+MappedFileStream::Buffer::pos_type MappedFileStream::Buffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+	off_type base = 0;
+	if (dir == std::ios_base::cur) base = gptr() - eback();
+	else if (dir == std::ios_base::end) base = egptr() - eback();
+	return seekpos(pos_type(base + off), which);
+}
+
+MappedFileStream::Buffer::pos_type MappedFileStream::Buffer::seekpos(pos_type pos, std::ios_base::openmode which) {
+	if (!(which & std::ios_base::in) || off_type(pos) < 0 || off_type(pos) > egptr() - eback()) return pos_type(off_type(-1));
+	setg(eback(), eback() + off_type(pos), egptr());
+	return pos;
+}
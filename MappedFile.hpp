@@ -0,0 +1,58 @@
+#pragma once
+
+/*
+ * A MappedFile makes the contents of a file available (read-only) in memory
+ * by mapping it into the address space, so data can be used in place without
+ * being copied into a buffer first.
+ *
+ * (If mapping isn't possible, the file is read into memory instead.)
+ *
+ * Files in a mounted Pack (see Pack.hpp) are found there instead of on disk:
+ * stored entries are used in place in the pack's mapping, and compressed ones are inflated into memory.
+ *
+ */
+
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+struct MappedFile {
+	//map a file (or find it in a mounted Pack):
+	// note: will throw if the file can't be opened
+	MappedFile(std::string const &filename);
+	~MappedFile();
+
+	//the mapping is tied to this object, so it can't be copied:
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	//file contents:
+	// (data is never nullptr once constructed -- for an empty file, it points at an empty buffer with size 0)
+	char const *data = nullptr;
+	size_t size = 0;
+
+	//-- internals --
+	void *mapping = nullptr; //address returned by the OS (nullptr if not mapped)
+	#if defined(_WIN32)
+	void *file_handle = nullptr;
+	void *mapping_handle = nullptr;
+	#endif
+	std::vector< char > fallback; //contents, if the file could not be mapped (or was inflated from a Pack)
+	std::shared_ptr< void const > owner; //keeps the storage of contents alive, if they are in a Pack's mapping
+};
+
+//read a mapped file through a std::istream (e.g., with read_chunk), without copying it:
+// (the file must outlive the stream)
+struct MappedFileStream : std::istream {
+	MappedFileStream(MappedFile const &file);
+
+	//-- internals --
+	struct Buffer : std::streambuf {
+		Buffer(char const *begin, char const *end);
+		pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+		pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+	} buffer;
+};
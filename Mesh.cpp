@@ -1,20 +1,150 @@
 #include "Mesh.hpp"
 #include "read_write_chunk.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 
 #include <stdexcept>
-#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <string>
 #include <set>
+#include <unordered_map>
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 
-MeshBuffer::MeshBuffer(std::string const &filename) {
-	glGenBuffers(1, &buffer);
+#if defined(__x86_64__) || defined(_M_X64)
+#define MESH_SSE
+#include <immintrin.h>
+#endif
+
+char const *mesh_vertex_glsl =
+	"in vec4 Position;\n"
+	"in vec3 Normal;\n"
+	//quantized buffers store Position.w == -1 and octahedral-encoded normals (see quantize-meshes.cpp):
+	"vec4 mesh_position() {\n"
+	"	return vec4(Position.xyz, 1.0);\n"
+	"}\n"
+	"vec3 mesh_normal() {\n"
+	"	if (Position.w >= 0.0) return Normal;\n"
+	"	vec3 n = vec3(Normal.xy, 1.0 - abs(Normal.x) - abs(Normal.y));\n"
+	"	if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * mix(vec2(-1.0), vec2(1.0), step(0.0, n.xy));\n"
+	"	return normalize(n);\n"
+	"}\n"
+;
+
+//vertices per work item when computing bounds:
+static constexpr uint32_t BoundsChunk = 1 << 16;
 
-	std::ifstream file(filename, std::ios::binary);
+//compute min/max of the positions of vertices [begin,end), exactly as a serial glm::min / glm::max pass would:
+// positions are the first three floats of each 'stride'-byte vertex (and may not be aligned)
+static void range_bounds(char const *data, size_t stride, uint32_t begin, uint32_t end, glm::vec3 *min_, glm::vec3 *max_) {
+	glm::vec3 min = *min_;
+	glm::vec3 max = *max_;
+
+	#ifdef MESH_SSE
+	//four-wide loads cover x,y,z plus the next float in the vertex, which is ignored:
+	// (so only possible if vertices have something after their positions)
+	if (stride >= 4 * sizeof(float)) {
+		//_mm_min_ps(a, b) is (a < b ? a : b) while glm::min(x, y) is (y < x ? y : x), so new positions go first
+		// to get glm's answer when a coordinate is NaN (skipped) or values tie (-0.0 vs 0.0: the earlier is kept);
+		// likewise for _mm_max_ps / glm::max.
+		//two accumulator pairs, so consecutive vertices don't wait on each other:
+		// each takes one half of the range, so combining them (first half wins ties) still keeps the earliest value
+		uint32_t half = (end - begin) / 2;
+		uint32_t mid = begin + half;
+		__m128 vmin = _mm_set_ps(0.0f, min.z, min.y, min.x);
+		__m128 vmax = _mm_set_ps(0.0f, max.z, max.y, max.x);
+		__m128 vmin2 = vmin, vmax2 = vmax;
+		for (uint32_t i = 0; i < half; ++i) {
+			__m128 p0 = _mm_loadu_ps(reinterpret_cast< float const * >(data + (begin + i) * stride));
+			__m128 p1 = _mm_loadu_ps(reinterpret_cast< float const * >(data + (mid + i) * stride));
+			vmin = _mm_min_ps(p0, vmin);
+			vmax = _mm_max_ps(p0, vmax);
+			vmin2 = _mm_min_ps(p1, vmin2);
+			vmax2 = _mm_max_ps(p1, vmax2);
+		}
+		if (mid + half < end) {
+			//(odd count: the second half has one more vertex)
+			__m128 p1 = _mm_loadu_ps(reinterpret_cast< float const * >(data + (end - 1) * stride));
+			vmin2 = _mm_min_ps(p1, vmin2);
+			vmax2 = _mm_max_ps(p1, vmax2);
+		}
+		vmin = _mm_min_ps(vmin2, vmin);
+		vmax = _mm_max_ps(vmax2, vmax);
+		float lo[4], hi[4];
+		_mm_storeu_ps(lo, vmin);
+		_mm_storeu_ps(hi, vmax);
+		*min_ = glm::vec3(lo[0], lo[1], lo[2]);
+		*max_ = glm::vec3(hi[0], hi[1], hi[2]);
+		return;
+	}
+	#endif
+
+	for (uint32_t v = begin; v < end; ++v) {
+		glm::vec3 position;
+		std::memcpy(&position, data + v * stride, sizeof(position));
+		min = glm::min(min, position);
+		max = glm::max(max, position);
+	}
+
+	*min_ = min;
+	*max_ = max;
+}
+
+void compute_mesh_bounds(char const *data, size_t stride, std::vector< Mesh > *meshes_) {
+	auto &meshes = *meshes_;
+
+	//large meshes are split into chunks, and chunks are spread across threads:
+	struct Chunk {
+		uint32_t mesh;
+		uint32_t begin, end;
+		glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+		glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
+	};
+	std::vector< Chunk > chunks;
+	for (uint32_t m = 0; m < meshes.size(); ++m) {
+		uint32_t end = meshes[m].vertex_start + meshes[m].vertex_count;
+		for (uint32_t begin = meshes[m].vertex_start; begin < end; begin += BoundsChunk) {
+			chunks.emplace_back();
+			chunks.back().mesh = m;
+			chunks.back().begin = begin;
+			chunks.back().end = std::min(end, begin + BoundsChunk);
+		}
+	}
+
+	auto work = [&](size_t i) {
+		range_bounds(data, stride, chunks[i].begin, chunks[i].end, &chunks[i].min, &chunks[i].max);
+	};
+	if (chunks.size() > 1) {
+		ThreadPool::shared().parallel_for(chunks.size(), work);
+	} else {
+		//(not worth waking up other threads)
+		for (size_t i = 0; i < chunks.size(); ++i) work(i);
+	}
+
+	//results are combined in chunk order (so, as within a chunk, the earliest of tied values is kept):
+	for (auto const &chunk : chunks) {
+		meshes[chunk.mesh].min = glm::min(meshes[chunk.mesh].min, chunk.min);
+		meshes[chunk.mesh].max = glm::max(meshes[chunk.mesh].max, chunk.max);
+	}
+}
+
+MeshBuffer::MeshBuffer(std::string const &filename) : MeshBuffer(filename, DeferUpload) {
+	upload();
+}
+
+MeshBuffer::MeshBuffer(std::string const &filename, DeferUploadTag) {
+	//map the file so chunks can be used in place:
+	pending_file = std::make_shared< MappedFile >(filename);
+	MappedFile const &file = *pending_file;
+	char const *at = file.data;
+	char const *end = file.data + file.size;
+	file_size = file.size;
 
 	GLuint total = 0;
 
@@ -25,18 +155,45 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 		glm::vec2 TexCoord;
 	};
 	static_assert(sizeof(Vertex) == 3*4+3*4+4*1+2*4, "Vertex is packed.");
-	std::vector< Vertex > data;
 
-	//read + upload data chunk:
-	if (filename.size() >= 5 && filename.substr(filename.size()-5) == ".pnct") {
-		read_chunk(file, "pnct", &data);
+	//quantized vertex, as written by quantize-meshes:
+	struct QuantizedVertex {
+		glm::i16vec4 Position; //xyz normalized to mesh bounds (see Mesh::position_offset); w == -32767 (flags quantized normals)
+		glm::i16vec2 Normal; //octahedral encoding
+		glm::u8vec4 Color;
+		glm::u16vec2 TexCoord; //half floats
+	};
+	static_assert(sizeof(QuantizedVertex) == 4*2+2*2+4*1+2*2, "QuantizedVertex is packed.");
+
+	char const *data = nullptr; //vertex data (in the mapped file)
+	bool quantized = false;
+
+	//find data chunk (it will be uploaded straight from the mapped file):
+	if (filename.size() >= 5 && filename.substr(filename.size()-5) == ".pnct"
+	 && size_t(end - at) >= 4 && std::memcmp(at, "pnq0", 4) == 0) {
+		quantized = true;
+
+		size_t count = 0;
+		data = find_chunk< QuantizedVertex >(&at, end, "pnq0", &count);
 
-		//upload data:
-		glBindBuffer(GL_ARRAY_BUFFER, buffer);
-		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(Vertex), data.data(), GL_STATIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		pending_data = data;
+		pending_size = count * sizeof(QuantizedVertex);
 
-		total = GLuint(data.size()); //store total for later checks on index
+		total = GLuint(count); //store total for later checks on index
+
+		//store attrib locations:
+		Position = Attrib(4, GL_SHORT, GL_TRUE, sizeof(QuantizedVertex), offsetof(QuantizedVertex, Position));
+		Normal = Attrib(2, GL_SHORT, GL_TRUE, sizeof(QuantizedVertex), offsetof(QuantizedVertex, Normal));
+		Color = Attrib(4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(QuantizedVertex), offsetof(QuantizedVertex, Color));
+		TexCoord = Attrib(2, GL_HALF_FLOAT, GL_FALSE, sizeof(QuantizedVertex), offsetof(QuantizedVertex, TexCoord));
+	} else if (filename.size() >= 5 && filename.substr(filename.size()-5) == ".pnct") {
+		size_t count = 0;
+		data = find_chunk< Vertex >(&at, end, "pnct", &count);
+
+		pending_data = data;
+		pending_size = count * sizeof(Vertex);
+
+		total = GLuint(count); //store total for later checks on index
 
 		//store attrib locations:
 		Position = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Position));
@@ -47,8 +204,19 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 		throw std::runtime_error("Unknown file type '" + filename + "'");
 	}
 
-	std::vector< char > strings;
-	read_chunk(file, "str0", &strings);
+	//(optional) indices follow the vertices:
+	char const *indices = nullptr; //(in the mapped file)
+	size_t index_count = 0;
+	if (size_t(end - at) >= 4 && std::memcmp(at, "ind0", 4) == 0) {
+		indices = find_chunk< uint32_t >(&at, end, "ind0", &index_count);
+		pending_index_data = indices;
+		pending_index_size = index_count * sizeof(uint32_t);
+	}
+	vertex_total = total;
+	index_total = GLuint(index_count);
+
+	size_t strings_size = 0;
+	char const *strings = find_chunk< char >(&at, end, "str0", &strings_size);
 
 	{ //read index chunk, add to meshes:
 		struct IndexEntry {
@@ -58,35 +226,196 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 		static_assert(sizeof(IndexEntry) == 16, "Index entry should be packed");
 
 		std::vector< IndexEntry > index;
-		read_chunk(file, "idx0", &index);
+		read_chunk(&at, end, "idx0", &index);
 
+		std::vector< std::string > names;
+		std::vector< Mesh > index_meshes;
+		names.reserve(index.size());
+		index_meshes.reserve(index.size());
 		for (auto const &entry : index) {
-			if (!(entry.name_begin <= entry.name_end && entry.name_end <= strings.size())) {
+			if (!(entry.name_begin <= entry.name_end && entry.name_end <= strings_size)) {
 				throw std::runtime_error("index entry has out-of-range name begin/end");
 			}
 			if (!(entry.vertex_begin <= entry.vertex_end && entry.vertex_end <= total)) {
 				throw std::runtime_error("index entry has out-of-range vertex start/count");
 			}
-			std::string name(&strings[0] + entry.name_begin, &strings[0] + entry.name_end);
-			Mesh mesh;
+			names.emplace_back(strings + entry.name_begin, strings + entry.name_end);
+			index_meshes.emplace_back();
+			Mesh &mesh = index_meshes.back();
 			mesh.type = GL_TRIANGLES;
 			mesh.start = entry.vertex_begin;
 			mesh.count = entry.vertex_end - entry.vertex_begin;
-			for (uint32_t v = entry.vertex_begin; v < entry.vertex_end; ++v) {
-				mesh.min = glm::min(mesh.min, data[v].Position);
-				mesh.max = glm::max(mesh.max, data[v].Position);
+			mesh.vertex_start = mesh.start;
+			mesh.vertex_count = mesh.count;
+		}
+
+		if (indices) {
+			//indexed meshes come with the range of indices to draw:
+			struct IndexRange {
+				uint32_t index_begin, index_end;
+			};
+			static_assert(sizeof(IndexRange) == 8, "Index range should be packed");
+
+			std::vector< IndexRange > ranges;
+			read_chunk(&at, end, "ixr0", &ranges);
+			if (ranges.size() != index_meshes.size()) {
+				throw std::runtime_error("mesh file has " + std::to_string(ranges.size()) + " index ranges for " + std::to_string(index_meshes.size()) + " meshes");
+			}
+			for (uint32_t i = 0; i < index_meshes.size(); ++i) {
+				Mesh &mesh = index_meshes[i];
+				if (!(ranges[i].index_begin <= ranges[i].index_end && ranges[i].index_end <= index_count)) {
+					throw std::runtime_error("index range has out-of-range begin/end");
+				}
+				//check indices, so a bad file can't make the GPU read outside the mesh's vertices:
+				for (uint32_t j = ranges[i].index_begin; j < ranges[i].index_end; ++j) {
+					uint32_t index;
+					std::memcpy(&index, indices + j * sizeof(uint32_t), sizeof(index));
+					if (!(mesh.vertex_start <= index && index < mesh.vertex_start + mesh.vertex_count)) {
+						throw std::runtime_error("index chunk refers to a vertex outside of its mesh");
+					}
+				}
+				mesh.index_type = GL_UNSIGNED_INT;
+				mesh.start = ranges[i].index_begin;
+				mesh.count = ranges[i].index_end - ranges[i].index_begin;
 			}
-			bool inserted = meshes.insert(std::make_pair(name, mesh)).second;
+
+			//(optional) levels of detail are more ranges of indices:
+			if (size_t(end - at) >= 4 && std::memcmp(at, "lod0", 4) == 0) {
+				struct LODEntry {
+					uint32_t mesh;
+					uint32_t index_begin, index_end;
+					float error;
+				};
+				static_assert(sizeof(LODEntry) == 16, "LOD entry should be packed");
+
+				std::vector< LODEntry > lods;
+				read_chunk(&at, end, "lod0", &lods);
+				for (auto const &lod : lods) {
+					if (lod.mesh >= index_meshes.size()) {
+						throw std::runtime_error("level of detail refers to a mesh that doesn't exist");
+					}
+					Mesh &mesh = index_meshes[lod.mesh];
+					if (!(lod.index_begin <= lod.index_end && lod.index_end <= index_count)) {
+						throw std::runtime_error("level of detail has out-of-range begin/end");
+					}
+					for (uint32_t j = lod.index_begin; j < lod.index_end; ++j) {
+						uint32_t index;
+						std::memcpy(&index, indices + j * sizeof(uint32_t), sizeof(index));
+						if (!(mesh.vertex_start <= index && index < mesh.vertex_start + mesh.vertex_count)) {
+							throw std::runtime_error("level of detail refers to a vertex outside of its mesh");
+						}
+					}
+					mesh.lods.emplace_back();
+					mesh.lods.back().start = lod.index_begin;
+					mesh.lods.back().count = lod.index_end - lod.index_begin;
+					mesh.lods.back().error = lod.error;
+				}
+			}
+		}
+
+		if (quantized) {
+			//quantized meshes come with the decoding for their positions (which spans exactly their bounds):
+			struct Decode {
+				glm::vec3 offset;
+				glm::vec3 scale;
+			};
+			static_assert(sizeof(Decode) == 24, "Decode entry should be packed");
+
+			std::vector< Decode > decode;
+			read_chunk(&at, end, "qdc0", &decode);
+			if (decode.size() != index_meshes.size()) {
+				throw std::runtime_error("quantized mesh file has " + std::to_string(decode.size()) + " decode entries for " + std::to_string(index_meshes.size()) + " meshes");
+			}
+			for (uint32_t i = 0; i < index_meshes.size(); ++i) {
+				Mesh &mesh = index_meshes[i];
+				mesh.position_offset = decode[i].offset;
+				mesh.position_scale = decode[i].scale;
+				if (mesh.vertex_count) {
+					mesh.min = decode[i].offset - glm::abs(decode[i].scale);
+					mesh.max = decode[i].offset + glm::abs(decode[i].scale);
+				}
+			}
+		} else {
+			//bounding boxes are computed from the vertex data in the mapped file:
+			compute_mesh_bounds(data + offsetof(Vertex, Position), sizeof(Vertex), &index_meshes);
+		}
+
+		//exporters write a copy of the vertex data for every object, even when objects are copies of each other,
+		// so point meshes with identical data at the first copy's range (which lets Scene::draw instance them):
+		// (candidates are found by vertex count + first and last vertex, then compared in full)
+		size_t const stride = (quantized ? sizeof(QuantizedVertex) : sizeof(Vertex));
+		auto same_indices = [&](GLuint a, GLuint a_base, GLuint b, GLuint b_base, GLuint count) {
+			for (GLuint j = 0; j < count; ++j) {
+				uint32_t ia, ib;
+				std::memcpy(&ia, indices + (a + j) * sizeof(uint32_t), sizeof(ia));
+				std::memcpy(&ib, indices + (b + j) * sizeof(uint32_t), sizeof(ib));
+				if (ia - a_base != ib - b_base) return false;
+			}
+			return true;
+		};
+		auto same_mesh = [&](Mesh const &a, Mesh const &b) {
+			if (a.vertex_count != b.vertex_count || a.count != b.count || a.lods.size() != b.lods.size()) return false;
+			if (a.position_offset != b.position_offset || a.position_scale != b.position_scale) return false;
+			if (std::memcmp(data + a.vertex_start * stride, data + b.vertex_start * stride, a.vertex_count * stride) != 0) return false;
+			if (!a.index_type) return true;
+			if (!same_indices(a.start, a.vertex_start, b.start, b.vertex_start, a.count)) return false;
+			for (uint32_t l = 0; l < a.lods.size(); ++l) {
+				if (a.lods[l].count != b.lods[l].count || a.lods[l].error != b.lods[l].error) return false;
+				if (!same_indices(a.lods[l].start, a.vertex_start, b.lods[l].start, b.vertex_start, a.lods[l].count)) return false;
+			}
+			return true;
+		};
+		std::unordered_map< uint64_t, std::vector< uint32_t > > firsts; //candidate key => meshes that are the first of their data
+		for (uint32_t i = 0; i < index_meshes.size(); ++i) {
+			Mesh &mesh = index_meshes[i];
+			if (mesh.vertex_count == 0) continue;
+			//FNV-1a of vertex count, first vertex, and last vertex:
+			uint64_t key = 0xcbf29ce484222325ULL ^ mesh.vertex_count;
+			for (char const *v : {data + mesh.vertex_start * stride, data + (mesh.vertex_start + mesh.vertex_count - 1) * stride}) {
+				for (size_t b = 0; b < stride; ++b) {
+					key = (key ^ uint8_t(v[b])) * 0x100000001b3ULL;
+				}
+			}
+			std::vector< uint32_t > &candidates = firsts[key];
+			auto same = std::find_if(candidates.begin(), candidates.end(), [&](uint32_t c) { return same_mesh(index_meshes[c], mesh); });
+			if (same != candidates.end()) {
+				mesh = index_meshes[*same];
+			} else {
+				candidates.emplace_back(i);
+			}
+		}
+
+		for (uint32_t i = 0; i < index_meshes.size(); ++i) {
+			std::string const &name = names[i];
+			bool inserted = meshes.insert(std::make_pair(name, index_meshes[i])).second;
 			if (!inserted) {
 				std::cerr << "WARNING: mesh name '" + name + "' in filename '" + filename + "' collides with existing mesh." << std::endl;
 			}
 		}
 	}
 
-	if (file.peek() != EOF) {
+	if (at != end) {
 		std::cerr << "WARNING: trailing data in mesh file '" << filename << "'" << std::endl;
 	}
 
+	//build id table (at most half full, so probe sequences stay short):
+	uint32_t slot_count = 16;
+	while (slot_count < 2 * meshes.size()) slot_count *= 2;
+	mesh_ids.assign(slot_count, IdSlot());
+	for (auto const &m : meshes) {
+		NameId id(m.first);
+		for (uint32_t s = uint32_t(id.value) & (slot_count - 1); /* later */ ; s = (s + 1) & (slot_count - 1)) {
+			if (mesh_ids[s].mesh == nullptr) {
+				mesh_ids[s].id = id;
+				mesh_ids[s].mesh = &m;
+				break;
+			}
+			if (mesh_ids[s].id == id) {
+				throw std::runtime_error("mesh names '" + mesh_ids[s].mesh->first + "' and '" + m.first + "' in '" + filename + "' have the same NameId; rename one of them");
+			}
+		}
+	}
+
 	/* //DEBUG:
 	std::cout << "File '" << filename << "' contained meshes";
 	for (auto const &m : meshes) {
@@ -98,12 +427,56 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 	*/
 }
 
+void MeshBuffer::upload() {
+	assert(pending_file && "upload() should be called once, after constructing with DeferUpload");
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, pending_size, pending_data, GL_STATIC_DRAW);
+
+	if (pending_index_data) {
+		//(uploaded through GL_ARRAY_BUFFER, since binding GL_ELEMENT_ARRAY_BUFFER would change whatever vertex array is bound)
+		glGenBuffers(1, &index_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, index_buffer);
+		glBufferData(GL_ARRAY_BUFFER, pending_index_size, pending_index_data, GL_STATIC_DRAW);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	//GL has its own copy now, so the file can be unmapped:
+	pending_file.reset();
+	pending_data = nullptr;
+	pending_size = 0;
+	pending_index_data = nullptr;
+	pending_index_size = 0;
+}
+
+MeshBuffer::IdSlot const *MeshBuffer::find_slot(NameId id) const {
+	if (mesh_ids.empty()) return nullptr;
+	uint32_t mask = uint32_t(mesh_ids.size() - 1);
+	for (uint32_t s = uint32_t(id.value) & mask; mesh_ids[s].mesh != nullptr; s = (s + 1) & mask) {
+		if (mesh_ids[s].id == id) return &mesh_ids[s];
+	}
+	return nullptr;
+}
+
 const Mesh &MeshBuffer::lookup(std::string const &name) const {
-	auto f = meshes.find(name);
-	if (f == meshes.end()) {
+	//(ids in the table are unique, so if the slot's name differs, 'name' isn't in this buffer)
+	IdSlot const *slot = find_slot(NameId(name));
+	if (!slot || slot->mesh->first != name) {
 		throw std::runtime_error("Looking up mesh '" + name + "' that doesn't exist.");
 	}
-	return f->second;
+	return slot->mesh->second;
+}
+
+const Mesh &MeshBuffer::lookup(NameId id) const {
+	IdSlot const *slot = find_slot(id);
+	if (!slot) {
+		std::ostringstream str;
+		str << "Looking up mesh with id 0x" << std::hex << id.value << " that doesn't exist.";
+		throw std::runtime_error(str.str());
+	}
+	return slot->mesh->second;
 }
 
 GLuint MeshBuffer::make_vao_for_program(GLuint program) const {
@@ -128,6 +501,8 @@ GLuint MeshBuffer::make_vao_for_program(GLuint program) const {
 	bind_attribute("Color", Color);
 	bind_attribute("TexCoord", TexCoord);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	//(element buffer binding is part of the vertex array's state)
+	if (index_buffer) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
 	glBindVertexArray(0);
 
 	//Check that all active attributes were bound:
@@ -140,6 +515,8 @@ GLuint MeshBuffer::make_vao_for_program(GLuint program) const {
 		GLenum type = 0;
 		glGetActiveAttrib(program, i, 100, NULL, &size, &type, name);
 		name[99] = '\0';
+		//per-instance attributes aren't stored in mesh buffers; they are bound by Scene::add_instance_attributes:
+		if (std::string(name).substr(0, 9) == "INSTANCE_") continue;
 		GLint location = glGetAttribLocation(program, name);
 		if (!bound.count(GLuint(location))) {
 			throw std::runtime_error("ERROR: active attribute '" + std::string(name) + "' in program is not bound.");
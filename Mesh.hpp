@@ -5,15 +5,21 @@
  *  the OpenGL pipeline together.
  * A "MeshBuffer" holds a collection of such meshes (loaded from a file) in
  *  a single OpenGL array buffer. Individual meshes can be looked up by name
+ *  (or by NameId, e.g. "Beak"_id, which skips hashing the name at runtime)
  *  using the MeshBuffer::lookup() function.
  *
  */
 
 #include "GL.hpp"
+#include "NameId.hpp"
 #include <glm/glm.hpp>
 #include <map>
+#include <memory>
 #include <limits>
 #include <string>
+#include <vector>
+
+struct MappedFile;
 
 
 struct Mesh {
@@ -23,33 +29,109 @@ struct Mesh {
 	GLuint start = 0; //index of first vertex
 	GLuint count = 0; //count of vertices
 
+	//Indexed meshes (from files with an index chunk; see index-meshes.cpp) are drawn with glDrawElements:
+	// index_type is then GL_UNSIGNED_INT, and start/count are a range of MeshBuffer::index_buffer instead
+	GLenum index_type = 0;
+
+	//range of vertices the mesh uses (same as start/count for meshes that aren't indexed):
+	GLuint vertex_start = 0;
+	GLuint vertex_count = 0;
+
+	//(optional) simplified levels of detail for indexed meshes (see lod-meshes.cpp), finest first:
+	// (copy these into Scene::Drawable::Pipeline::lods so Scene::draw can pick one)
+	struct LOD {
+		GLuint start = 0; //range of indices
+		GLuint count = 0;
+		float error = 0.0f; //how far simplification moved the surface, relative to the radius of the mesh's bounds
+	};
+	std::vector< LOD > lods;
+
 	//Bounding box.
 	//useful for debug visualization and (perhaps, eventually) collision detection:
 	glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
 	glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
+
+	//Position decoding:
+	// quantized buffers store positions relative to each mesh's bounds, so
+	// object-space position = position_offset + position_scale * (stored position)
+	// (copy these into Scene::Drawable::Pipeline along with type/start/count)
+	glm::vec3 position_offset = glm::vec3(0.0f);
+	glm::vec3 position_scale = glm::vec3(1.0f);
 };
 
+//compute min/max of each mesh's vertex range [vertex_start, vertex_start + vertex_count), as MeshBuffer does for plain (not quantized) files:
+// positions are the first three floats of each 'stride'-byte vertex in 'data' (and may not be aligned)
+// work is spread across ThreadPool::shared() (and uses SSE where available), but results are bit-identical to a serial
+// glm::min / glm::max pass: NaN coordinates are skipped, and of tied values (-0.0 and 0.0) the earliest is kept
+void compute_mesh_bounds(char const *data, size_t stride, std::vector< Mesh > *meshes);
+
+//GLSL declarations for vertex shaders that draw MeshBuffer meshes:
+// declares the Position and Normal attributes, and mesh_position() / mesh_normal() functions that read them;
+// use the functions (instead of the attributes directly) to handle both plain and quantized buffers.
+extern char const *mesh_vertex_glsl;
+
 struct MeshBuffer {
 	//construct from a file:
 	// note: will throw if file fails to read.
+	// '.pnct' files may hold plain ("pnct" chunk) or quantized ("pnq0" chunk; see quantize-meshes.cpp) vertices,
+	// optionally followed by indices ("ind0" chunk; see index-meshes.cpp) and levels of detail ("lod0" chunk; see lod-meshes.cpp).
+	// meshes with identical data (e.g., exported copies of one object) share one range, so Scene::draw can instance them.
 	MeshBuffer(std::string const &filename);
 
+	//...or read the file without touching OpenGL (e.g., on a loading thread),
+	// leaving the upload to a later call to upload() (on the thread with the OpenGL context):
+	enum DeferUploadTag { DeferUpload };
+	MeshBuffer(std::string const &filename, DeferUploadTag);
+	void upload();
+
 	//look up a particular mesh by name:
 	// note: will throw if mesh not found.
 	const Mesh &lookup(std::string const &name) const;
+	//...or by id (a single probe of a hash table; ids of literals are computed at compile time):
+	// note: will throw if mesh not found.
+	const Mesh &lookup(NameId id) const;
+
+	//meshes point into their buffer's tables, so copying a buffer is not advised:
+	MeshBuffer(MeshBuffer const &) = delete;
+	MeshBuffer &operator=(MeshBuffer const &) = delete;
 	
 	//build a vertex array object that links this vbo to attributes to a program:
 	// note: will throw if program defines attributes not contained in this buffer
+	//  (except for per-instance INSTANCE_* attributes, which are left for Scene::add_instance_attributes)
 	GLuint make_vao_for_program(GLuint program) const;
 
 	//This is the OpenGL vertex buffer object containing the mesh data:
 	GLuint buffer = 0;
+	//...and the buffer holding indices for indexed meshes (0 if there aren't any):
+	// (make_vao_for_program binds this as the vertex array's element buffer)
+	GLuint index_buffer = 0;
+
+	//what the buffer holds (e.g., for checking mesh ranges that were resolved ahead of time, as in BakedScene):
+	GLuint vertex_total = 0; //vertices in 'buffer'
+	GLuint index_total = 0; //indices in 'index_buffer'
+	size_t file_size = 0; //bytes in the file the buffer was loaded from
 
 	//-- internals ---
 
-	//used by the lookup() function:
+	//vertex data waiting for upload() (kept in the mapped file):
+	std::shared_ptr< MappedFile > pending_file;
+	char const *pending_data = nullptr;
+	size_t pending_size = 0;
+	char const *pending_index_data = nullptr;
+	size_t pending_index_size = 0;
+
+	//all meshes, by name (in name order):
 	std::map< std::string, Mesh > meshes;
 
+	//used by the lookup() functions -- open-addressing hash table of 'meshes' by id:
+	// built by the constructor, which throws if two mesh names have the same id
+	struct IdSlot {
+		NameId id;
+		std::pair< const std::string, Mesh > const *mesh = nullptr; //nullptr => empty slot
+	};
+	std::vector< IdSlot > mesh_ids; //size is a power of two
+	IdSlot const *find_slot(NameId id) const; //slot for id, or nullptr
+
 	//These 'Attrib' structures describe the location of various attributes within the buffer (in exactly format wanted by glVertexAttribPointer). They are set when the file is loaded and are used by the "make_vao_for_program" call:
 	struct Attrib {
 		GLint size = 0;
@@ -17,6 +17,16 @@ struct Mode : std::enable_shared_from_this< Mode > {
 	// 'elapsed' is time in seconds since the last call to 'update'
 	virtual void update(float elapsed) { }
 
+	//(optional) fixed-step updates:
+	// if fixed_timestep > 0, update(fixed_timestep) is called as many times per frame (including zero)
+	// as needed to keep up with real time, so simulation doesn't depend on frame rate.
+	float fixed_timestep = 0.0f;
+	// if frames take so long that more than this many steps are needed, simulation time is dropped instead:
+	uint32_t max_steps_per_frame = 8;
+	// how far (as a fraction of a step, in [0,1)) real time is past the most recent update; set before draw:
+	// (useful for drawing moving things between their previous and current positions)
+	float draw_alpha = 1.0f;
+
 	//draw is called after update:
 	virtual void draw(glm::uvec2 const &drawable_size) = 0;
 
@@ -0,0 +1,42 @@
+#pragma once
+
+/*
+ * NameId is a 64-bit (FNV-1a) hash of a name, used to look things up without comparing strings.
+ * Ids of string literals are computed at compile time:
+ *
+ *   constexpr NameId BirdId = "bird"_id;
+ *   Mesh const &mesh = meshes->lookup("Beak"_id);
+ *
+ * Ids of runtime strings work too -- NameId(std::string_view(name)) -- but cost a pass over the string.
+ *
+ * Tables keyed by NameId (MeshBuffer's meshes, Scene's name index) check for two different names
+ * with the same id when they are built, so a lookup by id never silently finds the wrong thing.
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+struct NameId {
+	uint64_t value = 0;
+
+	constexpr NameId() = default;
+	constexpr explicit NameId(std::string_view name) : value(hash(name)) { }
+
+	//FNV-1a:
+	static constexpr uint64_t hash(std::string_view name) {
+		uint64_t h = 0xcbf29ce484222325ULL;
+		for (char c : name) {
+			h ^= uint8_t(c);
+			h *= 0x100000001b3ULL;
+		}
+		return h;
+	}
+
+	constexpr bool operator==(NameId const &other) const { return value == other.value; }
+	constexpr bool operator!=(NameId const &other) const { return value != other.value; }
+};
+
+constexpr NameId operator""_id(char const *name, size_t length) {
+	return NameId(std::string_view(name, length));
+}
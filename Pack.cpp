@@ -0,0 +1,211 @@
+#include "Pack.hpp"
+#include "MappedFile.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+Pack::Pack(std::string const &filename_) : file(std::make_shared< MappedFile >(filename_)), filename(filename_) {
+	char const *data = file->data;
+	size_t size = file->size;
+
+	if (size < sizeof(Header)) {
+		throw std::runtime_error("pack '" + filename + "' is too small to have a header.");
+	}
+	Header const &header = *reinterpret_cast< Header const * >(data);
+	if (std::string(header.magic, 4) != "pck0") {
+		throw std::runtime_error("pack '" + filename + "' doesn't start with 'pck0' -- is it a pack?");
+	}
+	if (header.version != Version) {
+		throw std::runtime_error("pack '" + filename + "' is version " + std::to_string(header.version) + ", not " + std::to_string(Version) + " -- re-pack it.");
+	}
+	if ((size - sizeof(Header)) / sizeof(Entry) < header.entries
+	 || size - sizeof(Header) - header.entries * sizeof(Entry) < header.names_size) {
+		throw std::runtime_error("pack '" + filename + "' is too small for its table of contents.");
+	}
+	entries = reinterpret_cast< Entry const * >(data + sizeof(Header));
+	entries_count = header.entries;
+	names = std::string_view(data + sizeof(Header) + header.entries * sizeof(Entry), header.names_size);
+
+	//check the table of contents once, so find() and read() can trust it:
+	for (uint32_t i = 0; i < entries_count; ++i) {
+		Entry const &entry = entries[i];
+		if (!(entry.name_begin <= entry.name_end && entry.name_end <= names.size())) {
+			throw std::runtime_error("pack '" + filename + "' has an entry with invalid name indices.");
+		}
+		if (i > 0 && !(name(entries[i-1]) < name(entry))) {
+			throw std::runtime_error("pack '" + filename + "' has entries out of order (or repeated) at '" + std::string(name(entry)) + "'.");
+		}
+		if (entry.offset > size || size - entry.offset < entry.stored_size) {
+			throw std::runtime_error("pack '" + filename + "' has entry '" + std::string(name(entry)) + "' extending past the end of the file.");
+		}
+		if (!(entry.compression == Stored || entry.compression == Deflate)
+		 || (entry.compression == Stored && entry.size != entry.stored_size)) {
+			throw std::runtime_error("pack '" + filename + "' has entry '" + std::string(name(entry)) + "' with unknown compression.");
+		}
+	}
+}
+
+Pack::Entry const *Pack::find(std::string_view name_) const {
+	Entry const *end = entries + entries_count;
+	Entry const *found = std::lower_bound(entries, end, name_, [this](Entry const &entry, std::string_view n) {
+		return name(entry) < n;
+	});
+	if (found != end && name(*found) == name_) return found;
+	return nullptr;
+}
+
+std::string_view Pack::name(Entry const &entry) const {
+	return names.substr(entry.name_begin, entry.name_end - entry.name_begin);
+}
+
+std::string_view Pack::read(Entry const &entry, std::vector< char > *buffer) const {
+	char const *stored = file->data + entry.offset;
+	if (entry.compression == Stored) {
+		return std::string_view(stored, entry.stored_size);
+	}
+
+	assert(entry.compression == Deflate);
+	assert(buffer);
+	buffer->resize(entry.size);
+	uLongf inflated = uLongf(entry.size);
+	if (uncompress(reinterpret_cast< Bytef * >(buffer->data()), &inflated, reinterpret_cast< Bytef const * >(stored), uLong(entry.stored_size)) != Z_OK
+	 || inflated != entry.size) {
+		throw std::runtime_error("pack '" + filename + "' has entry '" + std::string(name(entry)) + "' that failed to inflate.");
+	}
+	return std::string_view(buffer->data(), buffer->size());
+}
+
+//-------------------------
+
+std::vector< char > Pack::build(std::vector< std::pair< std::string, std::vector< char > > > files, bool deflate) {
+	struct Packed {
+		std::string name;
+		std::vector< char > stored;
+		uint64_t size = 0;
+		uint32_t compression = Stored;
+	};
+	std::vector< Packed > packed;
+	packed.reserve(files.size());
+
+	for (auto &[name, contents] : files) {
+		Packed p;
+		p.name = name;
+		if (p.name.empty() || p.name.find('\\') != std::string::npos) {
+			throw std::runtime_error("file name '" + p.name + "' should be a non-empty path using '/'.");
+		}
+		p.size = contents.size();
+
+		//compress (if asked to), if that helps enough to be worth inflating later:
+		std::vector< char > compressed(deflate ? compressBound(uLong(contents.size())) : 0);
+		uLongf compressed_size = uLongf(compressed.size());
+		if (deflate && !contents.empty()
+		 && compress2(reinterpret_cast< Bytef * >(compressed.data()), &compressed_size, reinterpret_cast< Bytef const * >(contents.data()), uLong(contents.size()), Z_BEST_COMPRESSION) == Z_OK
+		 && compressed_size <= contents.size() - contents.size() / 8) {
+			compressed.resize(compressed_size);
+			p.stored = std::move(compressed);
+			p.compression = Deflate;
+		} else {
+			p.stored = std::move(contents);
+			p.compression = Stored;
+		}
+		if (p.stored.size() > 0xffffffffULL) throw std::runtime_error("file '" + p.name + "' is too large to pack.");
+
+		packed.emplace_back(std::move(p));
+	}
+
+	//table of contents is sorted by name, so entries can be found by binary search:
+	std::sort(packed.begin(), packed.end(), [](Packed const &a, Packed const &b) {
+		return a.name < b.name;
+	});
+	for (uint32_t i = 1; i < packed.size(); ++i) {
+		if (packed[i-1].name == packed[i].name) throw std::runtime_error("file '" + packed[i].name + "' is listed more than once.");
+	}
+
+	std::string names;
+	std::vector< Entry > entries;
+	for (auto const &p : packed) {
+		Entry entry;
+		entry.name_begin = uint32_t(names.size());
+		names += p.name;
+		entry.name_end = uint32_t(names.size());
+		entry.compression = p.compression;
+		entry.stored_size = uint32_t(p.stored.size());
+		entry.offset = 0; //(set below)
+		entry.size = p.size;
+		entries.emplace_back(entry);
+	}
+
+	//lay out the file:
+	Header header;
+	std::memcpy(header.magic, "pck0", 4);
+	header.version = Version;
+	header.entries = uint32_t(entries.size());
+	header.names_size = uint32_t(names.size());
+
+	uint64_t offset = sizeof(header) + entries.size() * sizeof(Entry) + names.size();
+	for (auto &entry : entries) {
+		offset = (offset + 15) / 16 * 16; //(so that, e.g., baked scenes can be used in place)
+		entry.offset = offset;
+		offset += entry.stored_size;
+	}
+
+	std::vector< char > data(offset, '\0');
+	std::memcpy(data.data(), &header, sizeof(header));
+	std::memcpy(data.data() + sizeof(header), entries.data(), entries.size() * sizeof(Entry));
+	std::memcpy(data.data() + sizeof(header) + entries.size() * sizeof(Entry), names.data(), names.size());
+	for (uint32_t i = 0; i < entries.size(); ++i) {
+		std::copy(packed[i].stored.begin(), packed[i].stored.end(), data.begin() + entries[i].offset);
+	}
+	return data;
+}
+
+//mounted packs (most recent last):
+struct Mount {
+	std::string directory;
+	std::shared_ptr< Pack const > pack;
+};
+static std::mutex &mounts_mutex() {
+	static std::mutex mutex;
+	return mutex;
+}
+static std::vector< Mount > &mounts() {
+	static std::vector< Mount > list;
+	return list;
+}
+
+void Pack::mount(std::string const &filename, std::string const &directory) {
+	//(the pack itself is opened outside the lock, since opening it goes through MappedFile -> find_mounted())
+	auto pack = std::make_shared< Pack const >(filename);
+
+	std::lock_guard< std::mutex > lock(mounts_mutex());
+	mounts().emplace_back(Mount{directory, pack});
+}
+
+Pack::Found Pack::find_mounted(std::string const &filename) {
+	Found ret;
+
+	std::lock_guard< std::mutex > lock(mounts_mutex());
+	for (auto m = mounts().rbegin(); m != mounts().rend(); ++m) {
+		if (filename.size() <= m->directory.size() || filename.compare(0, m->directory.size(), m->directory) != 0) continue;
+		std::string_view rest = std::string_view(filename).substr(m->directory.size());
+		#if defined(_WIN32)
+		//(paths on windows may use '\\', but names in packs always use '/')
+		std::string converted(rest);
+		std::replace(converted.begin(), converted.end(), '\\', '/');
+		Entry const *entry = m->pack->find(converted);
+		#else
+		Entry const *entry = m->pack->find(rest);
+		#endif
+		if (entry) {
+			ret.pack = m->pack;
+			ret.entry = entry;
+			break;
+		}
+	}
+	return ret;
+}
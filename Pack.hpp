@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+ * A Pack is a single file holding many assets (made by pack-assets.cpp), so that
+ * loading them takes one open + one mapping instead of one of each per asset.
+ *
+ * Entries are stored as-is and used in place from the mapped pack, or (if packed with --deflate)
+ * compressed with zlib's deflate and inflated when they're opened.
+ *
+ * Mounted packs act as a virtual file system: MappedFile looks for files in them before
+ * going to disk, so anything that reads through MappedFile -- MeshBuffer, Scene::load,
+ * load_png, BakedScene -- reads packed assets without any changes:
+ *
+ *   Pack::mount(data_path("assets.pack"), data_path(""));
+ *   MeshBuffer meshes(data_path("bird.pnct")); //found in assets.pack as "bird.pnct"
+ *
+ * File layout:
+ *   Header
+ *   Entry[header.entries]  -- sorted by name
+ *   char[header.names_size] -- entry names (paths relative to the packed directory, using '/')
+ *   entry data (each entry starts on a 16-byte boundary)
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct MappedFile;
+
+struct Pack {
+	//-- file format --
+
+	struct Header {
+		char magic[4]; //"pck0"
+		uint32_t version; //Pack::Version
+		uint32_t entries; //number of entries
+		uint32_t names_size; //bytes of names
+	};
+	static_assert(sizeof(Header) == 4 * 4, "Header is packed.");
+	enum : uint32_t { Version = 1 };
+
+	struct Entry {
+		uint32_t name_begin, name_end; //range of names block
+		uint32_t compression; //Stored or Deflate
+		uint32_t stored_size; //bytes in the pack
+		uint64_t offset; //of the stored bytes (from the start of the pack)
+		uint64_t size; //bytes once decompressed
+	};
+	static_assert(sizeof(Entry) == 4 * 4 + 8 * 2, "Entry is packed.");
+	enum : uint32_t {
+		Stored = 0, //stored bytes are the contents
+		Deflate = 1, //stored bytes are a zlib stream of the contents
+	};
+
+	//-- reading --
+
+	//map a pack and check its table of contents:
+	// note: will throw if the file can't be read or isn't a (current-version) pack.
+	Pack(std::string const &filename);
+
+	//entry with a given name, or nullptr if there isn't one (binary search):
+	Entry const *find(std::string_view name) const;
+	std::string_view name(Entry const &entry) const;
+
+	//contents of an entry:
+	// stored entries are returned in place; compressed entries are inflated into *buffer
+	// note: will throw if a compressed entry doesn't inflate to its size
+	std::string_view read(Entry const &entry, std::vector< char > *buffer) const;
+
+	//-- writing --
+
+	//lay out a pack holding the given (name, contents) files, returning the contents of the pack file (used by pack-assets.cpp):
+	// with 'deflate', a file is compressed if that saves at least an eighth of its size, and stored as-is otherwise.
+	// note: will throw if a name is empty, contains a backslash, or is listed twice, or if a file is too large to pack.
+	static std::vector< char > build(std::vector< std::pair< std::string, std::vector< char > > > files, bool deflate);
+
+	//-- virtual file system --
+
+	//mount a pack: files under 'directory' (e.g., data_path("")) are looked for in the pack first.
+	// (packs mounted later are searched before ones mounted earlier)
+	// note: mount packs before loading things from them; mounting is thread-safe, but a file opened
+	// before its pack was mounted will have been read from disk.
+	static void mount(std::string const &filename, std::string const &directory);
+
+	//look for a file in the mounted packs; returns the pack and entry, or (nullptr, nullptr):
+	struct Found {
+		std::shared_ptr< Pack const > pack;
+		Entry const *entry = nullptr;
+	};
+	static Found find_mounted(std::string const &filename);
+
+	//-- internals --
+	std::shared_ptr< MappedFile > file;
+	Entry const *entries = nullptr;
+	uint32_t entries_count = 0;
+	std::string_view names;
+	std::string filename; //(for error messages)
+};
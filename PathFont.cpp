@@ -21,4 +21,38 @@ PathFont::PathFont(uint32_t glyphs_,
 			std::cerr << "WARNING: ignoring duplicate glyph for '" << str << "'." << std::endl;
 		}
 	}
+
+	//build trie from the (de-duplicated) glyph map:
+	std::array< uint32_t, 256 > empty;
+	empty.fill(-1U);
+	trie_next.emplace_back(empty);
+	trie_glyph.emplace_back(-1U);
+	for (auto const &entry : glyph_map) {
+		uint32_t node = 0;
+		for (char c : entry.first) {
+			uint8_t byte = uint8_t(c);
+			if (trie_next[node][byte] == -1U) {
+				trie_next[node][byte] = uint32_t(trie_next.size());
+				trie_next.emplace_back(empty);
+				trie_glyph.emplace_back(-1U);
+			}
+			node = trie_next[node][byte];
+		}
+		trie_glyph[node] = entry.second;
+	}
+}
+
+uint32_t PathFont::match(char const *begin, char const *end, uint32_t *length) const {
+	uint32_t glyph = -1U;
+	*length = 0;
+	uint32_t node = 0;
+	for (char const *c = begin; c != end; ++c) {
+		node = trie_next[node][uint8_t(*c)];
+		if (node == -1U) break;
+		if (trie_glyph[node] != -1U) {
+			glyph = trie_glyph[node];
+			*length = uint32_t(c + 1 - begin);
+		}
+	}
+	return glyph;
 }
@@ -10,6 +10,7 @@
 
 #include <glm/glm.hpp>
 
+#include <array>
 #include <string>
 #include <vector>
 #include <map>
@@ -33,6 +34,16 @@ struct PathFont {
 	//computed in constructor:
 	std::map< std::string, uint32_t > glyph_map;
 
+	//find the glyph for the longest prefix of [begin,end) that has one:
+	// returns the glyph index (or -1U if no prefix matches) and sets *length to the matched length.
+	// (walks a byte trie, so costs one table lookup per byte and doesn't allocate)
+	uint32_t match(char const *begin, char const *end, uint32_t *length) const;
+
+	//-- internals --
+	//byte trie of glyph strings; node 0 is the root:
+	std::vector< std::array< uint32_t, 256 > > trie_next; //child for each next byte, or -1U
+	std::vector< uint32_t > trie_glyph; //glyph whose string ends at this node, or -1U
+
 	//the default font:
 	static PathFont font;
 };
@@ -13,13 +13,20 @@
 #include <random>
 
 GLuint game_meshes_for_lit_color_texture_program = 0;
-Load< MeshBuffer > bird_meshes(LoadTagDefault, []() -> MeshBuffer const * {
-	MeshBuffer const *ret = new MeshBuffer(data_path("bird.pnct"));
+GLuint game_meshes_for_lit_color_texture_instanced_program = 0;
+//meshes and scene are read + parsed on loader threads; only the uploads happen on the main thread:
+// (the programs are only needed for the vertex arrays, so the file is read while they compile)
+Load< MeshBuffer > bird_meshes("bird.pnct", {}, { &lit_color_texture_program, &lit_color_texture_instanced_program }, []() -> MeshBuffer * {
+	return new MeshBuffer(data_path("bird.pnct"), MeshBuffer::DeferUpload);
+}, [](MeshBuffer *ret) {
+	ret->upload();
 	game_meshes_for_lit_color_texture_program = ret->make_vao_for_program(lit_color_texture_program->program);
-	return ret;
+	//planes, coins, and clouds share meshes, so they can be drawn with instancing:
+	game_meshes_for_lit_color_texture_instanced_program = ret->make_vao_for_program(lit_color_texture_instanced_program->program);
+	Scene::add_instance_attributes(game_meshes_for_lit_color_texture_instanced_program, lit_color_texture_instanced_program->program);
 });
 
-Load< Scene > bird_scene(LoadTagDefault, []() -> Scene const * {
+Load< Scene > bird_scene("bird.scene", { &bird_meshes }, []() -> Scene * {
 	return new Scene(data_path("bird.scene"), [&](Scene &scene, Scene::Transform *transform, std::string const &mesh_name){
 		Mesh const &mesh = bird_meshes->lookup(mesh_name);
 
@@ -29,9 +36,21 @@ Load< Scene > bird_scene(LoadTagDefault, []() -> Scene const * {
 		drawable.pipeline = lit_color_texture_program_pipeline;
 
 		drawable.pipeline.vao = game_meshes_for_lit_color_texture_program;
+		drawable.pipeline.instanced_vao = game_meshes_for_lit_color_texture_instanced_program;
 		drawable.pipeline.type = mesh.type;
 		drawable.pipeline.start = mesh.start;
 		drawable.pipeline.count = mesh.count;
+		drawable.pipeline.index_type = mesh.index_type;
+		for (uint32_t i = 0; i < Scene::Drawable::Pipeline::LODCount && i < mesh.lods.size(); ++i) {
+			drawable.pipeline.lods[i].start = mesh.lods[i].start;
+			drawable.pipeline.lods[i].count = mesh.lods[i].count;
+			drawable.pipeline.lods[i].error = mesh.lods[i].error;
+		}
+		drawable.pipeline.position_offset = mesh.position_offset;
+		drawable.pipeline.position_scale = mesh.position_scale;
+
+		drawable.min = mesh.min;
+		drawable.max = mesh.max;
 	});
 });
 
@@ -40,91 +59,28 @@ PlayMode::PlayMode() : scene(*bird_scene) {
 	if (scene.cameras.size() != 1) throw std::runtime_error("Expecting scene to have exactly one camera, but it has " + std::to_string(scene.cameras.size()));
 	camera = &scene.cameras.front();
 
-	std::map<Scene::Transform*, object_info*> mapping;
-
-	// Get pointers to meshes:
-	Scene::Transform *hemi_light_pos = nullptr;
-	for (auto &transform : scene.transforms) {
-		if (transform.name == "leftFoot") left_leg = &transform;
-		else if (transform.name == "rightFoot") right_leg = &transform;
-		else if (transform.name == "leftWing") left_wing = &transform;
-		else if (transform.name == "rightWing") right_wing = &transform;
-		else if (transform.name == "beak") beak = &transform;
-		else if (transform.name == "bird") bird = &transform;
-		else if (transform.name == "birdCollider") bird_collider = &transform;
-		else if (transform.name == "hemi_light") hemi_light_pos = &transform;
-		else if (transform.name.find("_plane") != std::string::npos) {
-			// Create a plane
-			Scene::Transform *plane = &transform;
-			plane->position = camera->transform->position + glm::vec3(max_x, 0, 0);
-			plane->scale = glm::vec3(0.5f, 0.5f, 0.5f);
-
-			// Initializing fields in info
-			object_info *plane_info = new object_info;
-			plane_info->max_spawn_time = 7;
-			plane_info->min_spawn_time = 1;
-			plane_info->spawn_time = rand_float(plane_info->min_spawn_time, plane_info->max_spawn_time);
-			plane_info->spawn_timer = 0;
-			plane_info->spawned = false;
-			plane_info->max_speed = 12;
-			plane_info->min_speed = 5;
-			plane_info->transform = plane;
-			plane_info->collider = nullptr;
-
-			plane_infos.push_back(plane_info);
-			mapping[plane] = plane_info;
-		} else if (transform.name.find("_coin") != std::string::npos) {
-			// Create a coin
-			Scene::Transform *coin = &transform;
-			coin->position = camera->transform->position + glm::vec3(max_x, 0, 0);
-			coin->scale = glm::vec3(0.5f, 0.5f, 0.5f);
-
-			// Initializing fields in info
-			object_info *coin_info = new object_info;
-			coin_info->max_spawn_time = 5;
-			coin_info->min_spawn_time = 1;
-			coin_info->spawn_time = rand_float(coin_info->min_spawn_time, coin_info->max_spawn_time);
-			coin_info->spawn_timer = 0;
-			coin_info->spawned = false;
-			coin_info->max_speed = 9;
-			coin_info->min_speed = 6;
-			coin_info->transform = coin;
-			coin_info->collider = nullptr;
-
-			coin_infos.push_back(coin_info);
-			mapping[coin] = coin_info;
-		} else if (transform.name.find("_cloud") != std::string::npos) {
-			// Create a cloud
-			Scene::Transform *cloud = &transform;
-			cloud->position = camera->transform->position + glm::vec3(max_x, 0, 0);
-			cloud->scale = glm::vec3(0.5f, 0.5f, 0.5f);
-
-			// Initializing fields in info
-			object_info *cloud_info = new object_info;
-			cloud_info->max_spawn_time = 10;
-			cloud_info->min_spawn_time = 2;
-			cloud_info->spawn_time = rand_float(cloud_info->min_spawn_time, cloud_info->max_spawn_time);
-			cloud_info->spawn_timer = 0;
-			cloud_info->spawned = false;
-			cloud_info->max_speed = 5;
-			cloud_info->min_speed = 3;
-			cloud_info->transform = cloud;
-			cloud_info->collider = nullptr;
-
-			cloud_infos.push_back(cloud_info);
-			mapping[cloud] = cloud_info;
-		}
-	}
-
-	// Second pass for colliders
-	for (auto &transform : scene.transforms) {
-		if (transform.name.find("planeCollider") != std::string::npos) {
-			Scene::Transform *plane_collider = &transform;
-			mapping[plane_collider->parent]->collider = plane_collider;
-		} else if (transform.name.find("coinCollider") != std::string::npos) {
-			Scene::Transform *coin_collider = &transform;
-			mapping[coin_collider->parent]->collider = coin_collider;
-		}
+	std::vector<Scene::Transform*> planes, coins, clouds;
+	std::map<Scene::Transform*, Scene::Transform*> colliders; // Object transform -> collider transform
+
+	// Get pointers to meshes (through the scene's name index, by ids hashed at compile time):
+	left_leg = scene.find_transform("leftFoot"_id);
+	right_leg = scene.find_transform("rightFoot"_id);
+	left_wing = scene.find_transform("leftWing"_id);
+	right_wing = scene.find_transform("rightWing"_id);
+	beak = scene.find_transform("beak"_id);
+	bird = scene.find_transform("bird"_id);
+	bird_collider = scene.find_transform("birdCollider"_id);
+	Scene::Transform *hemi_light_pos = scene.find_transform("hemi_light"_id);
+	scene.find_transforms_containing("_plane", &planes);
+	scene.find_transforms_containing("_coin", &coins);
+	scene.find_transforms_containing("_cloud", &clouds);
+
+	// Colliders are children of the objects they belong to:
+	std::vector<Scene::Transform*> collider_transforms;
+	scene.find_transforms_containing("planeCollider", &collider_transforms);
+	scene.find_transforms_containing("coinCollider", &collider_transforms);
+	for (auto transform : collider_transforms) {
+		colliders[transform->parent] = transform;
 	}
 
 	if (left_leg == nullptr) throw std::runtime_error("Left Leg not found.");
@@ -135,6 +91,53 @@ PlayMode::PlayMode() : scene(*bird_scene) {
 	if (bird == nullptr) throw std::runtime_error("Bird not found.");
 	if (bird_collider == nullptr) throw std::runtime_error("Bird collider not found.");
 
+	// Set up colliders (the bird touches planes and coins; they don't touch each other)
+	bird_collider_id = collision.add(bird_collider);
+	collision.colliders[bird_collider_id].layers = BirdLayer;
+	collision.colliders[bird_collider_id].mask = PlaneLayer | CoinLayer;
+
+	// Set up spawners
+	{
+		Spawner::Params params;
+		params.direction = glm::vec3(-1.0f, 0.0f, 0.0f);
+		params.parked_position = camera->transform->position + glm::vec3(max_x, 0.0f, 0.0f);
+		params.spawn_min = camera->transform->position + glm::vec3(max_x, min_y, min_z);
+		params.spawn_max = camera->transform->position + glm::vec3(max_x, max_y, max_z);
+		params.live_min.x = min_x;
+
+		plane_spawner.params = params;
+		plane_spawner.params.min_spawn_time = 1;
+		plane_spawner.params.max_spawn_time = 7;
+		plane_spawner.params.min_speed = 5;
+		plane_spawner.params.max_speed = 12;
+		add_objects(&plane_spawner, planes, colliders, PlaneLayer);
+
+		coin_spawner.params = params;
+		coin_spawner.params.min_spawn_time = 1;
+		coin_spawner.params.max_spawn_time = 5;
+		coin_spawner.params.min_speed = 6;
+		coin_spawner.params.max_speed = 9;
+		add_objects(&coin_spawner, coins, colliders, CoinLayer);
+
+		cloud_spawner.params = params;
+		cloud_spawner.params.min_spawn_time = 2;
+		cloud_spawner.params.max_spawn_time = 10;
+		cloud_spawner.params.min_speed = 3;
+		cloud_spawner.params.max_speed = 5;
+		add_objects(&cloud_spawner, clouds, colliders, 0);
+	}
+
+	// Simulate at a fixed rate, interpolating moving objects when drawing
+	fixed_timestep = 1.0f / 120.0f;
+	interpolated.push_back(bird);
+	for (Spawner const *spawner : { &plane_spawner, &coin_spawner, &cloud_spawner }) {
+		interpolated.insert(interpolated.end(), spawner->transforms.begin(), spawner->transforms.end());
+	}
+	for (Scene::Transform *transform : interpolated) {
+		previous_positions.push_back(transform->position);
+	}
+	current_positions.resize(interpolated.size());
+
 	left_leg_base_rotation = left_leg->rotation;
 	right_leg_base_rotation = right_leg->rotation;
 	left_wing_base_rotation = left_wing->rotation;
@@ -190,64 +193,26 @@ bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 	return false;
 }
 
-float PlayMode::rand_float(float lo, float hi) {
-	// Referenced StackOverflow https://stackoverflow.com/questions/5289613/generate-random-float-between-two-floats
-	float rand_val = ((float) rand()) / (float) RAND_MAX; // Generates random between 0 and 1
-	float diff = hi - lo;
-	return lo + diff * rand_val;
-}
-
-bool PlayMode::collision_check(Scene::Transform *parent1, Scene::Transform *collider1, 
-							   Scene::Transform *parent2, Scene::Transform *collider2) {
-	glm::vec3 pos1 = parent1->position + collider1->position;
-	glm::vec3 scale1 = parent1->scale * collider1->scale;
-	glm::vec3 pos2 = parent2->position + collider2->position;
-	glm::vec3 scale2 = parent2->scale * collider2->scale;
-
-	if (pos1.x - scale1.x/2 > pos2.x + scale2.x/2 || pos1.x + scale1.x/2 < pos2.x - scale2.x/2) {
-		return false;
-	}
-
-	if (pos1.y - scale1.y/2 > pos2.y + scale2.y/2 || pos1.y + scale1.y/2 < pos2.y - scale2.y/2) {
-		return false;
-	}
-
-	if (pos1.z - scale1.z/2 > pos2.z + scale2.z/2 || pos1.z + scale1.z/2 < pos2.z - scale2.z/2) {
-		return false;
-	}
-
-	return true;
-}
-
-void PlayMode::process_object(object_info *info, float elapsed, bool *collision) {
-	if (info->spawned) {
-		glm::vec3 forward = glm::vec3(-1, 0, 0);
-		info->transform->position += info->speed * elapsed * forward;
-
-		if (info->transform->position.x <= min_x) {
-			info->transform->position.x = max_x;
-			info->spawned = false;
-			info->spawn_timer = 0;
-			info->spawn_time = rand_float(info->min_spawn_time, info->max_spawn_time);
+void PlayMode::add_objects(Spawner *spawner, std::vector<Scene::Transform*> const &objects,
+						   std::map<Scene::Transform*, Scene::Transform*> const &colliders, uint32_t layer) {
+	spawner->collision = &collision;
+	for (Scene::Transform *object : objects) {
+		object->scale = glm::vec3(0.5f, 0.5f, 0.5f);
+
+		uint32_t collider_id = -1U;
+		auto f = colliders.find(object);
+		if (f != colliders.end()) {
+			collider_id = collision.add(f->second);
+			collision.colliders[collider_id].layers = layer;
+			collision.colliders[collider_id].mask = BirdLayer;
 		}
 
-		if (info->collider == nullptr) return;
-		if (collision_check(info->transform, info->collider, bird, bird_collider)) {
-			if (collision != nullptr) *collision = true;
-			info->transform->position.x = max_x;
-			info->spawned = false;
-			info->spawn_timer = 0;
-			info->spawn_time = rand_float(info->min_spawn_time, info->max_spawn_time);
-		}
-	}
-	else {
-		info->spawn_timer += elapsed;
-		if (info->spawn_timer >= info->spawn_time) {
-			// Spawn object
-			info->transform->position.y = camera->transform->position.y + rand_float(min_y, max_y);
-			info->transform->position.z = camera->transform->position.z + rand_float(min_z, max_z);
-			info->speed = rand_float(info->min_speed, info->max_speed);
-			info->spawned = true;
+		uint32_t handle = spawner->add(object, collider_id);
+
+		if (collider_id != -1U) {
+			if (collider_owners.size() <= collider_id) collider_owners.resize(collider_id + 1);
+			collider_owners[collider_id].spawner = spawner;
+			collider_owners[collider_id].handle = handle;
 		}
 	}
 }
@@ -261,6 +226,10 @@ void PlayMode::end_game() {
 }
 
 void PlayMode::update(float elapsed) {
+	for (size_t i = 0; i < interpolated.size(); ++i) {
+		previous_positions[i] = interpolated[i]->position;
+	}
+
 	// Slowly rotates through [0,1):
 	if (bird_vel_y > 0) {
 		wing_anim_time += elapsed / 2.0f;
@@ -339,38 +308,41 @@ void PlayMode::update(float elapsed) {
 		bird->position.z = min_bird_z_pos + norm_bird_z_pos;
 	}
 
-	// Handle plane movement
+	// Handle plane, coin, and cloud movement
+	plane_spawner.update(elapsed);
+	coin_spawner.update(elapsed);
+	cloud_spawner.update(elapsed);
+
+	// Spin coins
 	{
-		for (object_info *plane_info : plane_infos) {
-			bool plane_collision = false;
-			process_object(plane_info, elapsed, &plane_collision);
-			if (plane_collision && lives > 0) {
-				lives--;
-				if (lives == 0) {
-					end_game();
-				}
-			}
+		glm::quat rotate = glm::angleAxis(
+			glm::radians(20.0f * std::sin(elapsed * 2.0f * float(M_PI))), glm::vec3(1.0f, 0.0f, 0.0f));
+		for (Scene::Transform *coin : coin_spawner.transforms) {
+			coin->rotation = coin->rotation * rotate;
 		}
 	}
 
-	// Handle coin movement
+	// Handle collisions with the bird
 	{
-		for (object_info *coin_info : coin_infos) {
-			bool coin_collision = false;
-			process_object(coin_info, elapsed, &coin_collision);
-			glm::quat rotate = glm::angleAxis(
-				glm::radians(20.0f * std::sin(elapsed * 2.0f * float(M_PI))), glm::vec3(1.0f, 0.0f, 0.0f));
-			coin_info->transform->rotation = coin_info->transform->rotation * rotate;
-			if (coin_collision) {
+		collision.update();
+		for (Collision::Contact const &contact : collision.contacts) {
+			uint32_t other_id;
+			if (contact.a == bird_collider_id) other_id = contact.b;
+			else if (contact.b == bird_collider_id) other_id = contact.a;
+			else continue;
+
+			if (collision.colliders[other_id].layers & PlaneLayer) {
+				if (lives > 0) {
+					lives--;
+					if (lives == 0) {
+						end_game();
+					}
+				}
+			} else if (collision.colliders[other_id].layers & CoinLayer) {
 				score += 10;
 			}
-		}
-	}
-
-	// Handle cloud movement
-	{
-		for (object_info *cloud_info : cloud_infos) {
-			process_object(cloud_info, elapsed, nullptr);
+			ColliderOwner const &owner = collider_owners[other_id];
+			owner.spawner->retire(owner.handle);
 		}
 	}
 
@@ -384,32 +356,34 @@ void PlayMode::draw(glm::uvec2 const &drawable_size) {
 	//update camera aspect ratio for drawable:
 	camera->aspect = float(drawable_size.x) / float(drawable_size.y);
 
-	//set up light type and position for lit_color_texture_program:
-	glUseProgram(lit_color_texture_program->program);
-
+	//set up light type and position for lit_color_texture_program (and its instanced variant):
 	Scene::Light light = scene.lights.front();
-	switch (light.type) {
-		case light.Point: {
-			glUniform1i(lit_color_texture_program->LIGHT_TYPE_int, 0);
-			break;
-		}
-		case light.Hemisphere: {
-			glUniform1i(lit_color_texture_program->LIGHT_TYPE_int, 1);
-			break;
-		}
-		case light.Spot: {
-			glUniform1i(lit_color_texture_program->LIGHT_TYPE_int, 2);
-			break;
-		}
-		case light.Directional: {
-			glUniform1i(lit_color_texture_program->LIGHT_TYPE_int, 3);
-			break;
+	for (LitColorTextureProgram const *program : { lit_color_texture_program.value, lit_color_texture_instanced_program.value }) {
+		glUseProgram(program->program);
+
+		switch (light.type) {
+			case light.Point: {
+				glUniform1i(program->LIGHT_TYPE_int, 0);
+				break;
+			}
+			case light.Hemisphere: {
+				glUniform1i(program->LIGHT_TYPE_int, 1);
+				break;
+			}
+			case light.Spot: {
+				glUniform1i(program->LIGHT_TYPE_int, 2);
+				break;
+			}
+			case light.Directional: {
+				glUniform1i(program->LIGHT_TYPE_int, 3);
+				break;
+			}
+			default: break;
 		}
-		default: break;
-	}
 
-	glUniform3fv(lit_color_texture_program->LIGHT_DIRECTION_vec3, 1, glm::value_ptr(light.transform->rotation * glm::vec3(0.0f, 0.0f,-1.0f)));
-	glUniform3fv(lit_color_texture_program->LIGHT_ENERGY_vec3, 1, glm::value_ptr(light.energy));
+		glUniform3fv(program->LIGHT_DIRECTION_vec3, 1, glm::value_ptr(light.transform->rotation * glm::vec3(0.0f, 0.0f,-1.0f)));
+		glUniform3fv(program->LIGHT_ENERGY_vec3, 1, glm::value_ptr(light.energy));
+	}
 	glUseProgram(0);
 
 	glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
@@ -421,8 +395,24 @@ void PlayMode::draw(glm::uvec2 const &drawable_size) {
 
 	GL_ERRORS(); //print any errors produced by this setup code
 
+	// Draw moving objects between their previous and current positions
+	// (unless they jumped, e.g., by spawning or wrapping around)
+	constexpr float MaxInterpolationDistance = 1.0f;
+	for (size_t i = 0; i < interpolated.size(); ++i) {
+		glm::vec3 &position = interpolated[i]->position;
+		current_positions[i] = position;
+		if (glm::length(position - previous_positions[i]) < MaxInterpolationDistance) {
+			position = glm::mix(previous_positions[i], position, draw_alpha);
+		}
+	}
+
+	scene.update_transforms();
 	scene.draw(*camera);
 
+	for (size_t i = 0; i < interpolated.size(); ++i) {
+		interpolated[i]->position = current_positions[i];
+	}
+
 	{ //use DrawLines to overlay some text:
 		glDisable(GL_DEPTH_TEST);
 		float aspect = float(drawable_size.x) / float(drawable_size.y);
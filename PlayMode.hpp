@@ -1,11 +1,14 @@
 #include "Mode.hpp"
 
 #include "Scene.hpp"
+#include "Collision.hpp"
+#include "Spawner.hpp"
 
 #include <glm/glm.hpp>
 
 #include <vector>
 #include <deque>
+#include <map>
 
 struct PlayMode : Mode {
 	PlayMode();
@@ -56,23 +59,29 @@ private:
 	uint32_t score = 0;
 	uint8_t lives = 3;
 
-	// Spawning
-	typedef struct {
-		float max_spawn_time;    		// Max time between spawns
-		float min_spawn_time;    		// Min time between spawns
-		float spawn_time;		 		// Time before next spawn
-		float spawn_timer;		 		// Timer until next spawn
-		bool spawned;		 	 		// Whether object is spawned
-		float max_speed;		 		// Max speed of object
-		float min_speed;		 		// Min speed of object
-		float speed;		 	 		// Speed of object when spawned
-		Scene::Transform *transform;	// Reference to transform to spawn
-		Scene::Transform *collider;		// Reference to the collider of the object
-	} object_info;
-
-	std::vector<object_info*> plane_infos;
-	std::vector<object_info*> coin_infos;
-	std::vector<object_info*> cloud_infos;
+	// Spawning (each spawner holds a pool of objects that fly past the bird)
+	Spawner plane_spawner = Spawner(1);
+	Spawner coin_spawner = Spawner(2);
+	Spawner cloud_spawner = Spawner(3);
+
+	// Collision detection (bird vs. planes and coins)
+	Collision collision;
+	enum : uint32_t {
+		BirdLayer = 1,
+		PlaneLayer = 2,
+		CoinLayer = 4,
+	};
+	uint32_t bird_collider_id = -1U;
+	struct ColliderOwner {
+		Spawner *spawner = nullptr;
+		uint32_t handle = -1U;
+	};
+	std::vector<ColliderOwner> collider_owners; // Spawned object for each collider id (none for the bird)
+
+	// Render interpolation (update runs at a fixed rate; draw blends between the last two steps)
+	std::vector<Scene::Transform*> interpolated; // Transforms that move every step
+	std::vector<glm::vec3> previous_positions; // ...their positions before the most recent step
+	std::vector<glm::vec3> current_positions; // ...their positions after it (kept while drawing)
 
 	const float min_x = -10;
 	const float max_x = 30;
@@ -83,15 +92,9 @@ private:
 
 	/// Functions ///
 
-	// Generates a random float between lo and hi
-	float rand_float(float lo, float hi);
-
-	// Checks for collision between the two transforms
-	bool collision_check(Scene::Transform *parent1, Scene::Transform *collider1, 
-						 Scene::Transform *parent2, Scene::Transform *collider2);
-
-	// Processes the object info for the given elapsed time
-	void process_object(object_info *info, float elapsed, bool *collision);
+	// Adds objects to a spawner (with colliders on the given layer, if they have any)
+	void add_objects(Spawner *spawner, std::vector<Scene::Transform*> const &objects,
+					 std::map<Scene::Transform*, Scene::Transform*> const &colliders, uint32_t layer);
 
 	// Ends the game
 	void end_game();
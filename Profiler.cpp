@@ -0,0 +1,294 @@
+#include "Profiler.hpp"
+
+#include "DrawLines.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+Profiler profiler;
+
+uint64_t Profiler::now_us() const {
+	return uint64_t(std::chrono::duration_cast< std::chrono::microseconds >(std::chrono::steady_clock::now() - start).count());
+}
+
+void Profiler::begin_frame() {
+	frame_index += 1;
+	Frame &frame = frames[frame_index % FrameCount];
+
+	//results for this slot's queries should have arrived long ago, but make sure before reusing them:
+	if (frame.pending_queries) collect_queries(frame, true);
+
+	frame.index = frame_index;
+	frame.begin_us = now_us();
+	frame.end_us = 0;
+	frame.events.clear();
+	frame.counters.clear();
+	frame.used_queries = 0;
+
+	in_frame = true;
+	depth = 0;
+	gpu_active = false;
+}
+
+void Profiler::end_frame() {
+	Frame &frame = frames[frame_index % FrameCount];
+	frame.end_us = now_us();
+	in_frame = false;
+
+	//pick up any GPU timings that are ready (without waiting for the rest):
+	for (uint64_t i = frame_index + 1; i <= frame_index + FrameCount; ++i) {
+		Frame &older = frames[i % FrameCount];
+		if (older.pending_queries) collect_queries(older, false);
+	}
+}
+
+uint32_t Profiler::begin(char const *name, bool gpu) {
+	if (!in_frame) return -1U;
+
+	Frame &frame = frames[frame_index % FrameCount];
+
+	Event event;
+	event.name = name;
+	event.begin_us = now_us();
+	event.depth = depth;
+	depth += 1;
+
+	if (gpu && !gpu_active) {
+		if (frame.used_queries == frame.queries.size()) {
+			frame.queries.emplace_back(0);
+			glGenQueries(1, &frame.queries.back());
+		}
+		event.query = frame.queries[frame.used_queries];
+		frame.used_queries += 1;
+		frame.pending_queries += 1;
+		glBeginQuery(GL_TIME_ELAPSED, event.query);
+		gpu_active = true;
+	}
+
+	frame.events.emplace_back(event);
+	return uint32_t(frame.events.size() - 1);
+}
+
+void Profiler::end(uint32_t index) {
+	Frame &frame = frames[frame_index % FrameCount];
+	if (!in_frame || index >= frame.events.size()) return; //(scope wasn't recorded, or began in a different frame)
+
+	Event &event = frame.events[index];
+	event.end_us = now_us();
+	if (event.query) {
+		glEndQuery(GL_TIME_ELAPSED);
+		gpu_active = false;
+	}
+	if (depth > 0) depth -= 1;
+}
+
+void Profiler::count(char const *name, uint64_t amount) {
+	if (!in_frame) return;
+	Frame &frame = frames[frame_index % FrameCount];
+	for (auto &counter : frame.counters) {
+		if (counter.first == name) {
+			counter.second += amount;
+			return;
+		}
+	}
+	frame.counters.emplace_back(name, amount);
+}
+
+Profiler::Scope::Scope(char const *name, bool gpu) : event(profiler.begin(name, gpu)) {
+}
+
+Profiler::Scope::~Scope() {
+	profiler.end(event);
+}
+
+void Profiler::collect_queries(Frame &frame, bool wait) {
+	for (auto &event : frame.events) {
+		if (frame.pending_queries == 0) break;
+		if (event.query == 0 || event.gpu_ms >= 0.0f) continue;
+		if (!wait) {
+			GLuint available = GL_FALSE;
+			glGetQueryObjectuiv(event.query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) break; //(queries finish in order, so later ones won't be ready either)
+		}
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(event.query, GL_QUERY_RESULT, &ns);
+		event.gpu_ms = float(ns / 1.0e6);
+		frame.pending_queries -= 1;
+	}
+	//(a query that was begun but whose event was dropped mid-frame will never be read; don't wait on it forever)
+	if (wait) frame.pending_queries = 0;
+}
+
+//value below which fraction 'p' of the (sorted) values fall:
+static float percentile(std::vector< float > const &sorted, float p) {
+	if (sorted.empty()) return 0.0f;
+	size_t i = std::min(sorted.size() - 1, size_t(p * sorted.size()));
+	return sorted[i];
+}
+
+void Profiler::draw_overlay(glm::uvec2 const &drawable_size) const {
+	//--- gather timings from completed frames, oldest first ---
+	std::vector< float > frame_ms; //(in ring order, for the graph)
+	struct ScopeTimes {
+		char const *name;
+		uint32_t depth;
+		std::vector< float > cpu_ms, gpu_ms;
+	};
+	std::vector< ScopeTimes > scopes; //(in the order they were first seen)
+	std::map< std::string, uint32_t > scope_index;
+	struct CounterValues {
+		char const *name;
+		std::vector< float > values; //(zero in frames where nothing was counted)
+	};
+	std::vector< CounterValues > counters;
+	std::map< std::string, uint32_t > counter_index;
+
+	for (uint64_t i = frame_index + 1; i <= frame_index + FrameCount; ++i) {
+		Frame const &frame = frames[i % FrameCount];
+		if (frame.index == 0 || frame.end_us == 0) continue;
+		frame_ms.emplace_back((frame.end_us - frame.begin_us) / 1000.0f);
+		for (auto const &event : frame.events) {
+			if (event.end_us == 0) continue;
+			auto ret = scope_index.emplace(event.name, uint32_t(scopes.size()));
+			if (ret.second) scopes.emplace_back(ScopeTimes{ event.name, event.depth, {}, {} });
+			ScopeTimes &times = scopes[ret.first->second];
+			times.cpu_ms.emplace_back((event.end_us - event.begin_us) / 1000.0f);
+			if (event.gpu_ms >= 0.0f) times.gpu_ms.emplace_back(event.gpu_ms);
+		}
+		for (auto const &counter : frame.counters) {
+			auto ret = counter_index.emplace(counter.first, uint32_t(counters.size()));
+			if (ret.second) counters.emplace_back(CounterValues{ counter.first, {} });
+			CounterValues &values = counters[ret.first->second];
+			values.values.resize(frame_ms.size(), 0.0f);
+			values.values.back() += float(counter.second);
+		}
+	}
+	for (auto &values : counters) {
+		values.values.resize(frame_ms.size(), 0.0f);
+	}
+
+	//--- text ---
+	std::vector< std::string > lines;
+	{
+		std::vector< float > sorted = frame_ms;
+		std::sort(sorted.begin(), sorted.end());
+		std::ostringstream str;
+		str << std::fixed << std::setprecision(2)
+		    << "frame ms: p50 " << percentile(sorted, 0.5f) << "  p95 " << percentile(sorted, 0.95f)
+		    << "  p99 " << percentile(sorted, 0.99f) << "  max " << (sorted.empty() ? 0.0f : sorted.back())
+		    << "  (" << sorted.size() << " frames)";
+		lines.emplace_back(str.str());
+	}
+	for (auto &times : scopes) {
+		std::sort(times.cpu_ms.begin(), times.cpu_ms.end());
+		std::sort(times.gpu_ms.begin(), times.gpu_ms.end());
+		std::ostringstream str;
+		str << std::fixed << std::setprecision(2)
+		    << std::string(2 * (times.depth + 1), ' ') << times.name
+		    << ": cpu p50 " << percentile(times.cpu_ms, 0.5f) << "  p95 " << percentile(times.cpu_ms, 0.95f);
+		if (!times.gpu_ms.empty()) {
+			str << "  |  gpu p50 " << percentile(times.gpu_ms, 0.5f) << "  p95 " << percentile(times.gpu_ms, 0.95f);
+		}
+		lines.emplace_back(str.str());
+	}
+	for (auto &values : counters) {
+		std::sort(values.values.begin(), values.values.end());
+		std::ostringstream str;
+		str << "  " << values.name << " per frame: p50 " << uint64_t(percentile(values.values, 0.5f))
+		    << "  max " << uint64_t(values.values.back());
+		lines.emplace_back(str.str());
+	}
+
+	//--- draw, in pixel coordinates (origin at lower left) ---
+	glDisable(GL_DEPTH_TEST);
+	DrawLines draw_lines(glm::mat4(
+		2.0f / drawable_size.x, 0.0f, 0.0f, 0.0f,
+		0.0f, 2.0f / drawable_size.y, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		-1.0f, -1.0f, 0.0f, 1.0f
+	));
+
+	constexpr float H = 14.0f; //text height, pixels
+	for (uint32_t l = 0; l < lines.size(); ++l) {
+		glm::vec3 anchor = glm::vec3(0.5f * H, drawable_size.y - (l + 1.5f) * 1.4f * H, 0.0f);
+		//(drop shadow, for readability over any background)
+		draw_lines.draw_text(lines[l], anchor + glm::vec3(1.0f, -1.0f, 0.0f),
+			glm::vec3(H, 0.0f, 0.0f), glm::vec3(0.0f, H, 0.0f), glm::u8vec4(0x00, 0x00, 0x00, 0xff));
+		draw_lines.draw_text(lines[l], anchor,
+			glm::vec3(H, 0.0f, 0.0f), glm::vec3(0.0f, H, 0.0f), glm::u8vec4(0xff, 0xff, 0xff, 0xff));
+	}
+
+	//frame time graph: one bar per frame, scaled so 60Hz and 30Hz budgets are always visible:
+	constexpr float Budget60 = 1000.0f / 60.0f;
+	constexpr float Budget30 = 1000.0f / 30.0f;
+	float max_ms = Budget30 * 1.25f;
+	for (float ms : frame_ms) max_ms = std::max(max_ms, ms);
+
+	glm::vec2 origin = glm::vec2(0.5f * H, 0.5f * H);
+	float width = 2.0f * FrameCount;
+	float height = 8.0f * H;
+	auto to_y = [&](float ms) { return origin.y + height * (ms / max_ms); };
+
+	for (uint32_t f = 0; f < frame_ms.size(); ++f) {
+		float ms = frame_ms[f];
+		glm::u8vec4 color = (ms <= Budget60 ? glm::u8vec4(0x44, 0xff, 0x44, 0xff)
+		                   : ms <= Budget30 ? glm::u8vec4(0xff, 0xdd, 0x44, 0xff)
+		                   : glm::u8vec4(0xff, 0x44, 0x44, 0xff));
+		float x = origin.x + 2.0f * (FrameCount - frame_ms.size() + f);
+		draw_lines.draw(glm::vec3(x, origin.y, 0.0f), glm::vec3(x, to_y(ms), 0.0f), color);
+	}
+	for (float ms : { Budget60, Budget30 }) {
+		draw_lines.draw(glm::vec3(origin.x, to_y(ms), 0.0f), glm::vec3(origin.x + width, to_y(ms), 0.0f), glm::u8vec4(0xaa, 0xaa, 0xaa, 0xff));
+		std::ostringstream label;
+		label << std::fixed << std::setprecision(1) << ms << " ms";
+		draw_lines.draw_text(label.str(), glm::vec3(origin.x + width + 0.5f * H, to_y(ms) - 0.4f * H, 0.0f),
+			glm::vec3(0.8f * H, 0.0f, 0.0f), glm::vec3(0.0f, 0.8f * H, 0.0f), glm::u8vec4(0xaa, 0xaa, 0xaa, 0xff));
+	}
+	draw_lines.draw(glm::vec3(origin.x, origin.y, 0.0f), glm::vec3(origin.x + width, origin.y, 0.0f), glm::u8vec4(0xaa, 0xaa, 0xaa, 0xff));
+}
+
+void Profiler::write_trace(std::string const &filename) const {
+	std::ofstream out(filename, std::ios::binary);
+	if (!out) throw std::runtime_error("failed to open '" + filename + "' for writing");
+
+	auto quoted = [](char const *name) {
+		std::string ret = "\"";
+		for (char const *c = name; *c; ++c) {
+			if (*c == '"' || *c == '\\') ret += '\\';
+			ret += *c;
+		}
+		return ret + "\"";
+	};
+
+	//CPU scopes go on track 1 and GPU timings on track 2.
+	//GPU timings are placed at the time their commands were issued, since only their durations are measured.
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+	out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+	for (uint64_t i = frame_index + 1; i <= frame_index + FrameCount; ++i) {
+		Frame const &frame = frames[i % FrameCount];
+		if (frame.index == 0 || frame.end_us == 0) continue;
+		out << ",\n{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << frame.begin_us
+		    << ",\"dur\":" << (frame.end_us - frame.begin_us) << ",\"args\":{\"index\":" << frame.index << "}}";
+		for (auto const &event : frame.events) {
+			if (event.end_us == 0) continue;
+			out << ",\n{\"name\":" << quoted(event.name) << ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << event.begin_us
+			    << ",\"dur\":" << (event.end_us - event.begin_us) << "}";
+			if (event.gpu_ms >= 0.0f) {
+				out << ",\n{\"name\":" << quoted(event.name) << ",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":" << event.begin_us
+				    << ",\"dur\":" << uint64_t(event.gpu_ms * 1000.0f) << "}";
+			}
+		}
+		for (auto const &counter : frame.counters) {
+			out << ",\n{\"name\":" << quoted(counter.first) << ",\"ph\":\"C\",\"pid\":1,\"ts\":" << frame.begin_us
+			    << ",\"args\":{\"value\":" << counter.second << "}}";
+		}
+	}
+	out << "\n]}\n";
+
+	if (!out) throw std::runtime_error("failed to write '" + filename + "'");
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+/*
+ * Lightweight frame profiler:
+ *  - PROFILE_SCOPE("name") times the rest of the enclosing block on the CPU.
+ *  - PROFILE_GPU_SCOPE("name") also times the GL commands issued in the block with a GL_TIME_ELAPSED query.
+ *    (GL doesn't allow these queries to overlap, so a GPU scope inside another GPU scope is timed on the CPU only.)
+ *  - profiler.count("name", amount) adds to a per-frame counter (e.g., bytes uploaded).
+ *  - The main loop calls begin_frame() / end_frame() around each frame; the last FrameCount frames
+ *    are kept in a ring buffer.
+ *
+ * The recorded frames can be shown with draw_overlay() (percentiles + a frame time graph)
+ * or written with write_trace() as Chrome trace JSON (open in chrome://tracing or ui.perfetto.dev).
+ *
+ * Scope names are stored as pointers, so they should be string literals.
+ */
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct Profiler {
+	enum : uint32_t { FrameCount = 240 };
+
+	//one timed scope:
+	struct Event {
+		char const *name = nullptr;
+		uint64_t begin_us = 0, end_us = 0; //CPU time, microseconds since profiler creation
+		uint32_t depth = 0; //nesting depth (0 for scopes directly inside the frame)
+		GLuint query = 0; //GL_TIME_ELAPSED query (GPU scopes only)
+		float gpu_ms = -1.0f; //GPU time once the query has a result (-1 until then, or for CPU-only scopes)
+	};
+
+	struct Frame {
+		uint64_t index = 0; //(frames are numbered from 1; 0 marks an unused slot)
+		uint64_t begin_us = 0, end_us = 0;
+		std::vector< Event > events; //in begin order
+		std::vector< std::pair< char const *, uint64_t > > counters; //in first-count order
+		std::vector< GLuint > queries; //query objects owned by this slot, reused when the slot comes around again
+		uint32_t used_queries = 0;
+		uint32_t pending_queries = 0; //queries without results yet
+	};
+
+	//ring buffer of frames; the current frame is frames[frame_index % FrameCount]:
+	std::array< Frame, FrameCount > frames;
+	uint64_t frame_index = 0;
+
+	void begin_frame();
+	void end_frame(); //also collects any GPU query results that have become available
+
+	//begin a scope in the current frame; returns a handle for end():
+	// (scopes outside of begin_frame() / end_frame() aren't recorded -- e.g., in tools that don't call them)
+	uint32_t begin(char const *name, bool gpu = false);
+	void end(uint32_t event);
+
+	//add to a counter in the current frame (not recorded outside of a frame, like scopes):
+	void count(char const *name, uint64_t amount);
+
+	struct Scope {
+		Scope(char const *name, bool gpu = false);
+		~Scope();
+		uint32_t event;
+	};
+
+	//overlay with frame time percentiles, per-scope times, and a frame time graph:
+	bool show_overlay = false;
+	void draw_overlay(glm::uvec2 const &drawable_size) const;
+
+	//write the frames in the ring buffer as Chrome trace JSON:
+	//NOTE: throws on error
+	void write_trace(std::string const &filename) const;
+
+	//-- internals --
+	uint64_t now_us() const;
+	void collect_queries(Frame &frame, bool wait);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool in_frame = false;
+	uint32_t depth = 0;
+	bool gpu_active = false; //is a GPU scope's query running?
+};
+
+//the profiler used by the main loop and PROFILE_* macros:
+extern Profiler profiler;
+
+#define PROFILE_CONCAT2(A, B) A ## B
+#define PROFILE_CONCAT(A, B) PROFILE_CONCAT2(A, B)
+#define PROFILE_SCOPE(NAME) Profiler::Scope PROFILE_CONCAT(profile_scope_, __LINE__)(NAME)
+#define PROFILE_GPU_SCOPE(NAME) Profiler::Scope PROFILE_CONCAT(profile_scope_, __LINE__)(NAME, true)
@@ -1,11 +1,18 @@
 #include "Scene.hpp"
 
+#include "Frustum.hpp"
+#include "MappedFile.hpp"
+#include "Profiler.hpp"
 #include "gl_errors.hpp"
 #include "read_write_chunk.hpp"
+#include "transform_batch.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <cstring>
+#include <cstddef>
 
 //-------------------------
 
@@ -56,18 +63,344 @@ glm::mat4x3 Scene::Transform::make_parent_to_local() const {
 	);
 }
 
-glm::mat4x3 Scene::Transform::make_local_to_world() const {
+//every world cache recomputation gets a fresh stamp so that children can tell their cached parent matrix is stale:
+// (shared by all scenes, which may be updated on different threads; read passes are numbered from the same counter)
+static std::atomic< uint64_t > next_world_cache_stamp{1};
+
+static uint64_t new_world_cache_stamp() {
+	return next_world_cache_stamp.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Scene::Transform::new_world_pass() {
+	return new_world_cache_stamp();
+}
+
+void Scene::Transform::update_world_cache(uint64_t pass) const {
+	if (pass != 0 && checked_pass.load(std::memory_order_relaxed) == pass) return; //(already checked during this pass)
+
+	uint64_t parent_stamp = 0;
+	if (parent) {
+		parent->update_world_cache(pass);
+		parent_stamp = parent->world_cache.stamp;
+	}
+
+	if (world_cache.stamp != 0
+	 && world_cache.position == position
+	 && world_cache.rotation == rotation
+	 && world_cache.scale == scale
+	 && world_cache.parent == parent
+	 && world_cache.parent_stamp == parent_stamp) {
+		//cache is still valid:
+		if (pass != 0) checked_pass.store(pass, std::memory_order_relaxed);
+		return;
+	}
+
+	world_cache.position = position;
+	world_cache.rotation = rotation;
+	world_cache.scale = scale;
+	world_cache.parent = parent;
+	world_cache.parent_stamp = parent_stamp;
+	world_cache.stamp = new_world_cache_stamp();
+
 	if (!parent) {
-		return make_local_to_parent();
+		world_cache.local_to_world = make_local_to_parent();
 	} else {
-		return parent->make_local_to_world() * glm::mat4(make_local_to_parent()); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
+		world_cache.local_to_world = parent->world_cache.local_to_world * glm::mat4(make_local_to_parent()); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
 	}
+	world_cache.has_world_to_local = false;
+	if (pass != 0) checked_pass.store(pass, std::memory_order_relaxed);
+}
+
+glm::mat4x3 Scene::Transform::make_local_to_world() const {
+	update_world_cache();
+	return world_cache.local_to_world;
+}
+glm::mat4x3 Scene::Transform::make_local_to_world(uint64_t pass) const {
+	update_world_cache(pass);
+	return world_cache.local_to_world;
 }
 glm::mat4x3 Scene::Transform::make_world_to_local() const {
-	if (!parent) {
-		return make_parent_to_local();
-	} else {
-		return make_parent_to_local() * glm::mat4(parent->make_world_to_local()); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
+	update_world_cache();
+	if (!world_cache.has_world_to_local) {
+		if (!parent) {
+			world_cache.world_to_local = make_parent_to_local();
+		} else {
+			world_cache.world_to_local = make_parent_to_local() * glm::mat4(parent->make_world_to_local()); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
+		}
+		world_cache.has_world_to_local = true;
+	}
+	return world_cache.world_to_local;
+}
+
+//-------------------------
+
+void Scene::TransformArrays::build(std::list< Transform > &transforms) {
+	clear();
+
+	handles.reserve(transforms.size());
+	parents.reserve(transforms.size());
+
+	std::unordered_map< Transform const *, uint32_t > index;
+	index.reserve(transforms.size());
+
+	//place each transform after all of its ancestors:
+	std::vector< Transform * > chain;
+	for (auto &transform : transforms) {
+		//walk up to the first already-placed ancestor (or the root):
+		chain.clear();
+		for (Transform *t = &transform; t && !index.count(t); t = t->parent) {
+			chain.emplace_back(t);
+			if (chain.size() > transforms.size()) {
+				throw std::runtime_error("transform hierarchy contains a cycle");
+			}
+		}
+		//place the chain from the top down:
+		for (auto t = chain.rbegin(); t != chain.rend(); ++t) {
+			uint32_t parent = -1U;
+			if ((*t)->parent) {
+				auto f = index.find((*t)->parent);
+				if (f == index.end()) {
+					throw std::runtime_error("transform has a parent that isn't in the scene");
+				}
+				parent = f->second;
+			}
+			index.emplace(*t, uint32_t(handles.size()));
+			handles.emplace_back(*t);
+			parents.emplace_back(parent);
+		}
+	}
+	assert(handles.size() == transforms.size());
+
+	positions.resize(handles.size());
+	rotations.resize(handles.size());
+	scales.resize(handles.size());
+	stamps.assign(handles.size(), 0);
+	local_to_parent.resize(handles.size());
+	local_to_world.resize(handles.size());
+}
+
+bool Scene::TransformArrays::update() {
+	//gather local transformations (and check that hierarchy hasn't changed):
+	for (uint32_t i = 0; i < handles.size(); ++i) {
+		Transform const &t = *handles[i];
+		if (t.parent != (parents[i] == -1U ? nullptr : handles[parents[i]])) return false;
+		positions[i] = t.position;
+		rotations[i] = t.rotation;
+		scales[i] = t.scale;
+	}
+
+	//build all local-to-parent matrices at once:
+	// (this is cheap enough with the SIMD kernels that it isn't worth skipping unchanged entries)
+	make_local_to_parent_batch(handles.size(), positions.data(), rotations.data(), scales.data(), local_to_parent.data());
+
+	//linear sweep over the hierarchy -- parents always come before children:
+	for (uint32_t i = 0; i < handles.size(); ++i) {
+		Transform::WorldCache &cache = handles[i]->world_cache;
+		uint32_t parent = parents[i];
+		uint64_t parent_stamp = (parent == -1U ? 0 : stamps[parent]);
+		if (cache.stamp != 0
+		 && cache.position == positions[i]
+		 && cache.rotation == rotations[i]
+		 && cache.scale == scales[i]
+		 && cache.parent == (parent == -1U ? nullptr : handles[parent])
+		 && cache.parent_stamp == parent_stamp) {
+			//unchanged since last computed:
+			stamps[i] = cache.stamp;
+			local_to_world[i] = cache.local_to_world;
+			continue;
+		}
+
+		if (parent == -1U) {
+			local_to_world[i] = local_to_parent[i];
+		} else {
+			local_to_world[i] = local_to_world[parent] * glm::mat4(local_to_parent[i]);
+		}
+		stamps[i] = new_world_cache_stamp();
+
+		//store result so make_local_to_world() will find it:
+		cache.position = positions[i];
+		cache.rotation = rotations[i];
+		cache.scale = scales[i];
+		cache.parent = (parent == -1U ? nullptr : handles[parent]);
+		cache.parent_stamp = parent_stamp;
+		cache.stamp = stamps[i];
+		cache.local_to_world = local_to_world[i];
+		cache.has_world_to_local = false;
+	}
+
+	return true;
+}
+
+void Scene::TransformArrays::clear() {
+	handles.clear();
+	parents.clear();
+	positions.clear();
+	rotations.clear();
+	scales.clear();
+	stamps.clear();
+	local_to_parent.clear();
+	local_to_world.clear();
+}
+
+void Scene::update_transforms() {
+	if (transform_arrays.handles.size() != transforms.size() || !transform_arrays.update()) {
+		transform_arrays.build(transforms);
+		transform_arrays.update(); //(can't fail right after build)
+	}
+}
+
+//-------------------------
+
+std::string_view Scene::NameTable::store(std::string_view chars) {
+	if (chars.empty()) return std::string_view();
+
+	if (block_used + chars.size() > block_size) {
+		block_size = std::max< size_t >(BlockSize, chars.size());
+		blocks.emplace_back(new char[block_size]);
+		block_used = 0;
+	}
+	char *copy = blocks.back().get() + block_used;
+	std::memcpy(copy, chars.data(), chars.size());
+	block_used += chars.size();
+
+	return std::string_view(copy, chars.size());
+}
+
+void Scene::update_name_index() const {
+	auto &ni = name_index;
+	ni = NameIndex();
+
+	ni.transforms.reserve(transforms.size());
+	ni.names.reserve(transforms.size());
+	ni.ids.reserve(transforms.size());
+	for (auto const &t : transforms) {
+		ni.transforms.emplace_back(const_cast< Transform * >(&t));
+		ni.names.emplace_back(t.name);
+		ni.ids.emplace_back(t.name);
+	}
+
+	//hash table with at least twice as many slots as names (power of two, so probing can mask):
+	uint32_t slot_count = 16;
+	while (slot_count < 2 * ni.names.size()) slot_count *= 2;
+	ni.slots.assign(slot_count, -1U);
+	for (uint32_t i = 0; i < ni.names.size(); ++i) {
+		for (uint32_t s = uint32_t(ni.ids[i].value) & (slot_count - 1); /* later */ ; s = (s + 1) & (slot_count - 1)) {
+			uint32_t other = ni.slots[s];
+			if (other == -1U) {
+				ni.slots[s] = i;
+				break;
+			}
+			if (ni.ids[other] != ni.ids[i]) continue;
+			if (ni.names[other] != ni.names[i]) {
+				std::string message = "transform names '" + std::string(ni.names[other]) + "' and '" + std::string(ni.names[i]) + "' have the same NameId; rename one of them";
+				ni = NameIndex();
+				throw std::runtime_error(message);
+			}
+			break; //(keep the first transform with a given name)
+		}
+	}
+
+	ni.active = true;
+}
+
+void Scene::clear_name_index() const {
+	name_index = NameIndex();
+}
+
+Scene::Transform *Scene::find_transform(NameId id) const {
+	if (!name_index.active) update_name_index();
+	auto const &ni = name_index;
+
+	uint32_t mask = uint32_t(ni.slots.size() - 1);
+	for (uint32_t s = uint32_t(id.value) & mask; ni.slots[s] != -1U; s = (s + 1) & mask) {
+		if (ni.ids[ni.slots[s]] == id) return ni.transforms[ni.slots[s]];
+	}
+	return nullptr;
+}
+
+Scene::Transform *Scene::find_transform(std::string_view name) const {
+	//(ids in the index are unique, so if the found transform's name differs, 'name' isn't in the scene)
+	Transform *found = find_transform(NameId(name));
+	if (found && found->name != name) return nullptr;
+	return found;
+}
+
+//compare strings from back to front:
+static bool reversed_less(std::string_view a, std::string_view b) {
+	return std::lexicographical_compare(a.rbegin(), a.rend(), b.rbegin(), b.rend());
+}
+
+//append transforms[i] for each index in [begin,end) to *out, in list (== index) order:
+template< typename Iterator >
+static void append_in_list_order(Iterator begin, Iterator end, std::vector< Scene::Transform * > const &transforms, std::vector< Scene::Transform * > *out) {
+	std::vector< uint32_t > found(begin, end);
+	std::sort(found.begin(), found.end());
+	for (uint32_t i : found) {
+		out->emplace_back(transforms[i]);
+	}
+}
+
+void Scene::find_transforms_with_prefix(std::string_view prefix, std::vector< Transform * > *out) const {
+	assert(out);
+	if (!name_index.active) update_name_index();
+	auto &ni = name_index;
+
+	if (ni.by_name.empty() && !ni.names.empty()) {
+		ni.by_name.resize(ni.names.size());
+		for (uint32_t i = 0; i < ni.by_name.size(); ++i) {
+			ni.by_name[i] = i;
+		}
+		std::sort(ni.by_name.begin(), ni.by_name.end(), [&ni](uint32_t a, uint32_t b) {
+			return ni.names[a] < ni.names[b];
+		});
+	}
+
+	//names with the prefix are adjacent in sorted order:
+	auto begin = std::lower_bound(ni.by_name.begin(), ni.by_name.end(), prefix, [&ni](uint32_t i, std::string_view p) {
+		return ni.names[i] < p;
+	});
+	auto end = begin;
+	while (end != ni.by_name.end() && ni.names[*end].substr(0, prefix.size()) == prefix) ++end;
+
+	append_in_list_order(begin, end, ni.transforms, out);
+}
+
+void Scene::find_transforms_with_suffix(std::string_view suffix, std::vector< Transform * > *out) const {
+	assert(out);
+	if (!name_index.active) update_name_index();
+	auto &ni = name_index;
+
+	if (ni.by_suffix.empty() && !ni.names.empty()) {
+		ni.by_suffix.resize(ni.names.size());
+		for (uint32_t i = 0; i < ni.by_suffix.size(); ++i) {
+			ni.by_suffix[i] = i;
+		}
+		std::sort(ni.by_suffix.begin(), ni.by_suffix.end(), [&ni](uint32_t a, uint32_t b) {
+			return reversed_less(ni.names[a], ni.names[b]);
+		});
+	}
+
+	auto ends_with_suffix = [&suffix](std::string_view name) {
+		return name.size() >= suffix.size() && name.substr(name.size() - suffix.size()) == suffix;
+	};
+
+	//names with the suffix are adjacent in reversed order:
+	auto begin = std::lower_bound(ni.by_suffix.begin(), ni.by_suffix.end(), suffix, [&ni](uint32_t i, std::string_view s) {
+		return reversed_less(ni.names[i], s);
+	});
+	auto end = begin;
+	while (end != ni.by_suffix.end() && ends_with_suffix(ni.names[*end])) ++end;
+
+	append_in_list_order(begin, end, ni.transforms, out);
+}
+
+void Scene::find_transforms_containing(std::string_view substring, std::vector< Transform * > *out) const {
+	assert(out);
+	if (!name_index.active) update_name_index();
+	auto const &ni = name_index;
+
+	for (uint32_t i = 0; i < ni.names.size(); ++i) {
+		if (ni.names[i].find(substring) != std::string_view::npos) out->emplace_back(ni.transforms[i]);
 	}
 }
 
@@ -87,36 +420,427 @@ void Scene::draw(Camera const &camera) const {
 	draw(world_to_clip, world_to_light);
 }
 
+//does the drawable have a bounding box?
+static bool has_bounds(Scene::Drawable const &drawable) {
+	return drawable.min.x <= drawable.max.x && drawable.min.y <= drawable.max.y && drawable.min.z <= drawable.max.z;
+}
+
+//world-space box (as center, half-extents) that contains the (transformed) local bounding box:
+static void world_box(Scene::Drawable const &drawable, glm::mat4x3 const &object_to_world, glm::vec3 *center_, glm::vec3 *radius_) {
+	glm::vec3 center = 0.5f * (drawable.max + drawable.min);
+	glm::vec3 radius = 0.5f * (drawable.max - drawable.min);
+	*center_ = object_to_world * glm::vec4(center, 1.0f);
+	*radius_ =
+		glm::abs(object_to_world[0]) * radius.x
+		+ glm::abs(object_to_world[1]) * radius.y
+		+ glm::abs(object_to_world[2]) * radius.z
+	;
+}
+
+//call f(drawable) for each of a scene's drawables, including those it shares from a base scene (see Scene::share):
+template< typename F >
+static void for_each_drawable(Scene const &scene, F const &f) {
+	for (auto const &drawable : scene.drawables) {
+		f(drawable);
+	}
+	if (!scene.shared.base) return;
+	//(base's drawables that edit() has copied are already in scene.drawables)
+	uint32_t index = 0;
+	for (auto const &drawable : scene.shared.base->drawables) {
+		if (!scene.shared.copied_drawables[index++]) f(drawable);
+	}
+}
+
+void Scene::update_bvh() const {
+	auto &b = drawable_bvh;
+
+	b.gathered.clear();
+	b.unbounded.clear();
+	for_each_drawable(*this, [&b](Drawable const &drawable) {
+		if (has_bounds(drawable)) b.gathered.emplace_back(&drawable);
+		else b.unbounded.emplace_back(&drawable);
+	});
+
+	b.mins.resize(b.gathered.size());
+	b.maxs.resize(b.gathered.size());
+	uint64_t pass = Transform::new_world_pass();
+	for (size_t i = 0; i < b.gathered.size(); ++i) {
+		glm::vec3 center, radius;
+		world_box(*b.gathered[i], b.gathered[i]->transform->make_local_to_world(pass), &center, &radius);
+		b.mins[i] = center - radius;
+		b.maxs[i] = center + radius;
+	}
+
+	if (b.active && b.gathered == b.drawables) {
+		//same drawables as before, so just update the bounds:
+		b.bvh.refit(b.mins.data(), b.maxs.data());
+		if (!b.bvh.should_rebuild()) return;
+	}
+	b.drawables.swap(b.gathered);
+	b.bvh.build(b.drawables.size(), b.mins.data(), b.maxs.data());
+	b.active = true;
+}
+
+void Scene::clear_bvh() const {
+	drawable_bvh = DrawableBVH();
+}
+
+Scene::Drawable const *Scene::pick(glm::vec3 const &origin, glm::vec3 const &direction, float *distance) const {
+	uint32_t item;
+	if (!drawable_bvh.bvh.raycast(origin, direction, std::numeric_limits< float >::infinity(), &item, distance)) return nullptr;
+	return drawable_bvh.drawables[item];
+}
+
+void Scene::query(glm::vec3 const &min, glm::vec3 const &max, std::vector< Drawable const * > *out) const {
+	assert(out);
+	drawable_bvh.hits.clear();
+	drawable_bvh.bvh.query(min, max, &drawable_bvh.hits);
+	for (uint32_t hit : drawable_bvh.hits) {
+		out->emplace_back(drawable_bvh.drawables[hit]);
+	}
+}
+
+//build a render queue sort key, ordered (from most to least significant) by:
+//  program [10 bits] | vao [10 bits] | textures [10 bits] | vertex range [12 bits] | depth [22 bits]
+// so that drawables sharing state (and meshes, for instancing) end up next to each other, front-to-back.
+// (names are truncated / hashed, so equal keys don't imply equal state -- draw() still compares actual state)
+static uint64_t make_queue_key(Scene::Drawable::Pipeline const &pipeline, GLuint start, GLuint count, float depth) {
+	auto fold = [](uint64_t x, uint32_t bits) {
+		uint64_t ret = 0;
+		while (x) {
+			ret ^= x;
+			x >>= bits;
+		}
+		return ret & ((uint64_t(1) << bits) - 1);
+	};
+
+	uint64_t textures = 0;
+	for (uint32_t i = 0; i < Scene::Drawable::Pipeline::TextureCount; ++i) {
+		textures = textures * 31 + pipeline.textures[i].texture;
+	}
+	uint64_t range = ((uint64_t(start) * 31 + count) * 31 + pipeline.type) * 31 + pipeline.index_type;
+
+	//non-negative floats sort the same as their bit patterns:
+	if (!(depth > 0.0f)) depth = 0.0f;
+	uint32_t depth_bits;
+	static_assert(sizeof(depth_bits) == sizeof(depth), "float is 32 bits");
+	std::memcpy(&depth_bits, &depth, sizeof(depth));
+
+	return (uint64_t(pipeline.program & 0x3ff) << 54)
+	     | (uint64_t(pipeline.vao & 0x3ff) << 44)
+	     | (fold(textures, 10) << 34)
+	     | (fold(range, 12) << 22)
+	     | uint64_t(depth_bits >> 10);
+}
+
+//stable LSD radix sort on 'key', one byte per pass:
+static void radix_sort(std::vector< Scene::QueueEntry > *entries_, std::vector< Scene::QueueEntry > *temp_) {
+	assert(entries_);
+	assert(temp_);
+	auto &entries = *entries_;
+	auto &temp = *temp_;
+
+	temp.resize(entries.size());
+	for (uint32_t shift = 0; shift < 64; shift += 8) {
+		uint32_t counts[256] = { 0 };
+		for (auto const &e : entries) {
+			counts[(e.key >> shift) & 0xff] += 1;
+		}
+		//skip passes where every key has the same digit (common for the high bits):
+		if (counts[(entries.empty() ? 0 : (entries[0].key >> shift) & 0xff)] == entries.size()) continue;
+
+		uint32_t offset = 0;
+		for (uint32_t d = 0; d < 256; ++d) {
+			uint32_t count = counts[d];
+			counts[d] = offset;
+			offset += count;
+		}
+		for (auto const &e : entries) {
+			temp[counts[(e.key >> shift) & 0xff]++] = e;
+		}
+		entries.swap(temp);
+	}
+}
+
+//can render queue entries a and b be drawn with the same instanced draw call?
+static bool same_instanced_state(Scene::QueueEntry const &qa, Scene::QueueEntry const &qb) {
+	Scene::Drawable::Pipeline const &a = qa.drawable->pipeline;
+	Scene::Drawable::Pipeline const &b = qb.drawable->pipeline;
+	if (a.instanced_program == 0 || a.instanced_vao == 0) return false;
+	if (a.set_uniforms || b.set_uniforms) return false;
+	if (a.instanced_program != b.instanced_program || a.instanced_vao != b.instanced_vao) return false;
+	if (qa.start != qb.start || qa.count != qb.count) return false;
+	if (a.type != b.type || a.index_type != b.index_type) return false;
+	if (a.position_offset != b.position_offset || a.position_scale != b.position_scale) return false;
+	for (uint32_t i = 0; i < Scene::Drawable::Pipeline::TextureCount; ++i) {
+		if (a.textures[i].texture != b.textures[i].texture) return false;
+		if (a.textures[i].texture != 0 && a.textures[i].target != b.textures[i].target) return false;
+	}
+	return true;
+}
+
+//matrix that takes stored (possibly quantized) positions to object space:
+static glm::mat4 make_position_decode(Scene::Drawable::Pipeline const &pipeline) {
+	return glm::mat4(
+		glm::vec4(pipeline.position_scale.x, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, pipeline.position_scale.y, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, pipeline.position_scale.z, 0.0f),
+		glm::vec4(pipeline.position_offset, 1.0f)
+	);
+}
+
+//offset of index 'start' in an element buffer (as glDrawElements wants it):
+static GLvoid const *index_offset(GLenum index_type, GLuint start) {
+	size_t size = (index_type == GL_UNSIGNED_INT ? 4 : index_type == GL_UNSIGNED_SHORT ? 2 : 1);
+	return (GLbyte const *)0 + start * size;
+}
+
+//buffer that per-instance data is streamed through (see Scene::add_instance_attributes):
+static GLuint instance_buffer = 0;
+
+void Scene::add_instance_attributes(GLuint vao, GLuint program) {
+	if (instance_buffer == 0) {
+		glGenBuffers(1, &instance_buffer);
+	}
+
+	static_assert(sizeof(InstanceData) == 4*16 + 4*12 + 4*9, "InstanceData is packed.");
+
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+
+	//matrix attributes take one location per column:
+	auto bind_matrix = [&](char const *name, GLint columns, GLint rows, size_t offset) {
+		GLint location = glGetAttribLocation(program, name);
+		if (location == -1) return; //program doesn't use this attribute
+		for (GLint c = 0; c < columns; ++c) {
+			glVertexAttribPointer(location + c, rows, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (GLbyte *)0 + offset + c * rows * sizeof(float));
+			glEnableVertexAttribArray(location + c);
+			glVertexAttribDivisor(location + c, 1); //advance once per instance
+		}
+	};
+	bind_matrix("INSTANCE_OBJECT_TO_CLIP", 4, 4, offsetof(InstanceData, OBJECT_TO_CLIP));
+	bind_matrix("INSTANCE_OBJECT_TO_LIGHT", 4, 3, offsetof(InstanceData, OBJECT_TO_LIGHT));
+	bind_matrix("INSTANCE_NORMAL_TO_LIGHT", 3, 3, offsetof(InstanceData, NORMAL_TO_LIGHT));
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	GL_ERRORS();
+}
+
 void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) const {
+	PROFILE_SCOPE("Scene::draw");
+
+	draw_stats = DrawStats();
+
+	//nothing moves during a draw, so each transform only needs to be checked against its world cache once:
+	uint64_t pass = Transform::new_world_pass();
+
+	//Gather all drawables into a render queue:
+	render_queue.clear();
+	cull_drawables.clear();
+	cull_centers.clear();
+	cull_radii.clear();
+
+	//length of the clip-space y axis in world units (used to measure how big things look):
+	float clip_y_scale = glm::length(glm::vec3(world_to_clip[0][1], world_to_clip[1][1], world_to_clip[2][1]));
+
+	auto enqueue = [&](Drawable const &drawable, glm::mat4x3 const &object_to_world) {
+		Drawable::Pipeline const &pipeline = drawable.pipeline;
+
+		//depth of the object's origin (clip-space w is view-space distance along the view direction):
+		float depth = (world_to_clip * glm::vec4(object_to_world[3], 1.0f)).w;
+
+		GLuint start = pipeline.start;
+		GLuint count = pipeline.count;
+		if (pipeline.lods[0].count != 0 && lod_error > 0.0f && has_bounds(drawable)) {
+			//how big do the drawable's bounds look? (radius of bounding sphere, as a fraction of viewport height)
+			glm::vec3 center, radius;
+			world_box(drawable, object_to_world, &center, &radius);
+			float sphere_radius = glm::length(radius);
+			float w = (world_to_clip * glm::vec4(center, 1.0f)).w;
+			if (w > sphere_radius) {
+				float screen_radius = 0.5f * sphere_radius * clip_y_scale / w;
+				//use the coarsest level that looks close enough to full detail:
+				for (uint32_t i = Drawable::Pipeline::LODCount; i > 0; --i) {
+					Drawable::Pipeline::LOD const &lod = pipeline.lods[i-1];
+					if (lod.count != 0 && lod.error * screen_radius <= lod_error) {
+						start = lod.start;
+						count = lod.count;
+						draw_stats.simplified += 1;
+						break;
+					}
+				}
+			}
+		}
+
+		render_queue.emplace_back(QueueEntry{ make_queue_key(pipeline, start, count, depth), &drawable, start, count });
+	};
 
-	//Iterate through all drawables, sending each one to OpenGL:
-	for (auto const &drawable : drawables) {
+	auto can_draw = [](Drawable const &drawable) {
 		//Reference to drawable's pipeline for convenience:
 		Scene::Drawable::Pipeline const &pipeline = drawable.pipeline;
 
 		//skip any drawables without a shader program set:
-		if (pipeline.program == 0) continue;
+		if (pipeline.program == 0) return false;
 		//skip any drawables that don't reference any vertex array:
-		if (pipeline.vao == 0) continue;
+		if (pipeline.vao == 0) return false;
 		//skip any drawables that don't contain any vertices:
-		if (pipeline.count == 0) continue;
+		if (pipeline.count == 0) return false;
+
+		assert(drawable.transform); //drawables *must* have a transform
+		return true;
+	};
+
+	if (drawable_bvh.active) {
+		//cull through the bounding volume hierarchy:
+		for (auto drawable : drawable_bvh.unbounded) {
+			if (!can_draw(*drawable)) continue;
+			enqueue(*drawable, drawable->transform->make_local_to_world(pass));
+		}
+		drawable_bvh.hits.clear();
+		drawable_bvh.bvh.query(Frustum(world_to_clip), &drawable_bvh.hits);
+		for (uint32_t hit : drawable_bvh.hits) {
+			Drawable const &drawable = *drawable_bvh.drawables[hit];
+			if (!can_draw(drawable)) continue;
+			enqueue(drawable, drawable.transform->make_local_to_world(pass));
+		}
+		draw_stats.culled = uint32_t(drawable_bvh.drawables.size() - drawable_bvh.hits.size());
+	} else {
+		for_each_drawable(*this, [&](Drawable const &drawable) {
+			if (!can_draw(drawable)) return;
+
+			glm::mat4x3 object_to_world = drawable.transform->make_local_to_world(pass);
+
+			if (!has_bounds(drawable)) {
+				//no bounds, so can't be culled:
+				enqueue(drawable, object_to_world);
+				return;
+			}
+
+			cull_drawables.emplace_back(&drawable);
+			cull_centers.emplace_back();
+			cull_radii.emplace_back();
+			world_box(drawable, object_to_world, &cull_centers.back(), &cull_radii.back());
+		});
+
+		//Test all boxes against the view frustum at once:
+		cull_visible.resize(cull_drawables.size());
+		Frustum(world_to_clip).cull(cull_drawables.size(), cull_centers.data(), cull_radii.data(), cull_visible.data());
+		for (size_t i = 0; i < cull_drawables.size(); ++i) {
+			if (cull_visible[i]) {
+				enqueue(*cull_drawables[i], cull_drawables[i]->transform->make_local_to_world(pass));
+			} else {
+				draw_stats.culled += 1;
+			}
+		}
+	}
+	draw_stats.visible = uint32_t(render_queue.size());
 
+	//Sort so that drawables with the same state are adjacent:
+	radix_sort(&render_queue, &render_queue_temp);
 
+	//Send drawables to OpenGL, only changing state when needed:
+	GLuint current_program = 0;
+	GLuint current_vao = 0;
+	Drawable::Pipeline::TextureInfo bound[Drawable::Pipeline::TextureCount];
+
+	auto use_program_and_vao = [&](GLuint program, GLuint vao) {
 		//Set shader program:
-		glUseProgram(pipeline.program);
+		if (program != current_program) {
+			glUseProgram(program);
+			current_program = program;
+			draw_stats.program_changes += 1;
+		}
 
 		//Set attribute sources:
-		glBindVertexArray(pipeline.vao);
+		if (vao != current_vao) {
+			glBindVertexArray(vao);
+			current_vao = vao;
+			draw_stats.vao_changes += 1;
+		}
+	};
+
+	auto bind_textures = [&](Drawable::Pipeline const &pipeline) {
+		//(units without a texture are left un-bound, as if they'd been cleaned up after the previous draw)
+		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
+			Drawable::Pipeline::TextureInfo const &want = pipeline.textures[i];
+			if (want.texture == bound[i].texture && (want.texture == 0 || want.target == bound[i].target)) continue;
+			glActiveTexture(GL_TEXTURE0 + i);
+			if (bound[i].texture != 0 && (want.texture == 0 || want.target != bound[i].target)) {
+				glBindTexture(bound[i].target, 0);
+			}
+			if (want.texture != 0) {
+				glBindTexture(want.target, want.texture);
+			}
+			bound[i] = want;
+			draw_stats.texture_changes += 1;
+		}
+	};
+
+	for (size_t begin = 0; begin < render_queue.size(); /* later */) {
+		Scene::Drawable const &drawable = *render_queue[begin].drawable;
+		Scene::Drawable::Pipeline const &pipeline = drawable.pipeline;
+		GLuint start = render_queue[begin].start;
+		GLuint count = render_queue[begin].count;
+
+		//find run of drawables that can be instanced along with this one:
+		size_t end = begin + 1;
+		while (end < render_queue.size() && same_instanced_state(render_queue[begin], render_queue[end])) {
+			++end;
+		}
+
+		if (end - begin >= 2) {
+			//--- instanced draw ---
+			instance_data.clear();
+			glm::mat4 position_decode = make_position_decode(pipeline);
+			for (size_t i = begin; i < end; ++i) {
+				glm::mat4x3 object_to_world = render_queue[i].drawable->transform->make_local_to_world(pass);
+				glm::mat4x3 object_to_light = world_to_light * glm::mat4(object_to_world);
+				instance_data.emplace_back();
+				InstanceData &data = instance_data.back();
+				data.OBJECT_TO_CLIP = world_to_clip * glm::mat4(object_to_world) * position_decode;
+				data.OBJECT_TO_LIGHT = object_to_light * position_decode;
+				//(normals aren't quantized, so they skip the decode)
+				data.NORMAL_TO_LIGHT = glm::inverse(glm::transpose(glm::mat3(object_to_light)));
+			}
+
+			//upload (re-specifying the whole buffer, so the driver can orphan storage in use by earlier draws):
+			glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+			glBufferData(GL_ARRAY_BUFFER, instance_data.size() * sizeof(InstanceData), instance_data.data(), GL_STREAM_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			use_program_and_vao(pipeline.instanced_program, pipeline.instanced_vao);
+			bind_textures(pipeline);
+
+			if (pipeline.index_type) {
+				glDrawElementsInstanced(pipeline.type, count, pipeline.index_type, index_offset(pipeline.index_type, start), GLsizei(instance_data.size()));
+			} else {
+				glDrawArraysInstanced(pipeline.type, start, count, GLsizei(instance_data.size()));
+			}
+			draw_stats.draws += 1;
+			draw_stats.instanced_draws += 1;
+			draw_stats.instances += uint32_t(instance_data.size());
+			if (pipeline.type == GL_TRIANGLES) draw_stats.triangles += count / 3 * uint32_t(instance_data.size());
+
+			begin = end;
+			continue;
+		}
+
+		//--- regular draw ---
+		use_program_and_vao(pipeline.program, pipeline.vao);
 
 		//Configure program uniforms:
 
 		//the object-to-world matrix is used in all three of these uniforms:
-		assert(drawable.transform); //drawables *must* have a transform
-		glm::mat4x3 object_to_world = drawable.transform->make_local_to_world();
+		glm::mat4x3 object_to_world = drawable.transform->make_local_to_world(pass);
+
+		//stored positions are taken to object space first (see Mesh::position_offset):
+		glm::mat4 position_decode = make_position_decode(pipeline);
 
 		//OBJECT_TO_CLIP takes vertices from object space to clip space:
 		if (pipeline.OBJECT_TO_CLIP_mat4 != -1U) {
-			glm::mat4 object_to_clip = world_to_clip * glm::mat4(object_to_world);
+			glm::mat4 object_to_clip = world_to_clip * glm::mat4(object_to_world) * position_decode;
 			glUniformMatrix4fv(pipeline.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
 		}
 
@@ -125,7 +849,8 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 
 		//OBJECT_TO_CLIP takes vertices from object space to light space:
 		if (pipeline.OBJECT_TO_LIGHT_mat4x3 != -1U) {
-			glUniformMatrix4x3fv(pipeline.OBJECT_TO_LIGHT_mat4x3, 1, GL_FALSE, glm::value_ptr(object_to_light));
+			glm::mat4x3 position_to_light = object_to_light * position_decode;
+			glUniformMatrix4x3fv(pipeline.OBJECT_TO_LIGHT_mat4x3, 1, GL_FALSE, glm::value_ptr(position_to_light));
 		}
 
 		//NORMAL_TO_CLIP takes normals from object space to light space:
@@ -138,30 +863,44 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 		if (pipeline.set_uniforms) pipeline.set_uniforms();
 
 		//set up textures:
-		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
-			if (pipeline.textures[i].texture != 0) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(pipeline.textures[i].target, pipeline.textures[i].texture);
-			}
-		}
+		bind_textures(pipeline);
 
 		//draw the object:
-		glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
-
-		//un-bind textures:
-		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
-			if (pipeline.textures[i].texture != 0) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(pipeline.textures[i].target, 0);
-			}
+		if (pipeline.index_type) {
+			glDrawElements(pipeline.type, count, pipeline.index_type, index_offset(pipeline.index_type, start));
+		} else {
+			glDrawArrays(pipeline.type, start, count);
 		}
-		glActiveTexture(GL_TEXTURE0);
+		draw_stats.draws += 1;
+		if (pipeline.type == GL_TRIANGLES) draw_stats.triangles += count / 3;
 
+		begin = begin + 1;
 	}
 
+	//un-bind textures:
+	for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
+		if (bound[i].texture != 0) {
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(bound[i].target, 0);
+		}
+	}
+	glActiveTexture(GL_TEXTURE0);
+
 	glUseProgram(0);
 	glBindVertexArray(0);
 
+	//(also reported as profiler counters, for the overlay, traces, and headless runs)
+	profiler.count("Scene draw calls", draw_stats.draws);
+	profiler.count("Scene instanced draw calls", draw_stats.instanced_draws);
+	profiler.count("Scene instances", draw_stats.instances);
+	profiler.count("Scene triangles", draw_stats.triangles);
+	profiler.count("Scene simplified", draw_stats.simplified);
+	profiler.count("Scene visible", draw_stats.visible);
+	profiler.count("Scene culled", draw_stats.culled);
+	profiler.count("Scene program changes", draw_stats.program_changes);
+	profiler.count("Scene vao changes", draw_stats.vao_changes);
+	profiler.count("Scene texture changes", draw_stats.texture_changes);
+
 	GL_ERRORS();
 }
 
@@ -169,7 +908,9 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 void Scene::load(std::string const &filename,
 	std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable) {
 
-	std::ifstream file(filename, std::ios::binary);
+	//(reading through MappedFile means the scene may come from a mounted Pack)
+	MappedFile mapped(filename);
+	MappedFileStream file(mapped);
 
 	std::vector< char > names;
 	read_chunk(file, "str0", &names);
@@ -221,6 +962,9 @@ void Scene::load(std::string const &filename,
 	//--------------------------------
 	//Now that file is loaded, create transforms for hierarchy entries:
 
+	//names point into one copy of the string chunk:
+	std::string_view chars = name_table->store(std::string_view(names.data(), names.size()));
+
 	std::vector< Transform * > hierarchy_transforms;
 	hierarchy_transforms.reserve(hierarchy.size());
 
@@ -235,7 +979,7 @@ void Scene::load(std::string const &filename,
 		}
 
 		if (h.name_begin <= h.name_end && h.name_end <= names.size()) {
-			t->name = std::string(names.begin() + h.name_begin, names.begin() + h.name_end);
+			t->name = chars.substr(h.name_begin, h.name_end - h.name_begin);
 		} else {
 				throw std::runtime_error("scene file '" + filename + "' contains hierarchy entry with invalid name indices");
 		}
@@ -301,6 +1045,9 @@ void Scene::load(std::string const &filename,
 		light->spot_fov = l.fov / 180.0f * 3.1415926f; //FOV is stored in degrees; convert to radians.
 	}
 
+	//new transforms (and names), so the name index is out of date:
+	clear_name_index();
+
 	//load any extra that a subclass wants:
 	load_extra(file, names, hierarchy_transforms);
 
@@ -327,51 +1074,274 @@ Scene &Scene::operator=(Scene const &other) {
 	return *this;
 }
 
-void Scene::set(Scene const &other, std::unordered_map< Transform const *, Transform * > *transform_map_) {
-
-	std::unordered_map< Transform const *, Transform * > t2t_temp;
-	std::unordered_map< Transform const *, Transform * > &transform_to_transform = *(transform_map_ ? transform_map_ : &t2t_temp);
+//copy a transform's values (and its world matrix cache) to another transform with a given parent:
+// (set() re-uses existing transforms as copies, so 'to' may hold anything)
+static void copy_transform(Scene::Transform const &from, Scene::Transform *parent, Scene::Transform *to) {
+	to->name = from.name;
+	to->position = from.position;
+	to->rotation = from.rotation;
+	to->scale = from.scale;
+	to->parent = parent;
+
+	//the cache stays valid, since the copy of the parent (if any) carries the same stamp as the original:
+	to->world_cache = from.world_cache;
+	if (from.world_cache.parent == from.parent) to->world_cache.parent = parent;
+	else to->world_cache.stamp = 0;
+	to->checked_pass.store(0, std::memory_order_relaxed);
+}
 
-	transform_to_transform.clear();
+uint32_t Scene::CloneIndex::find(Transform const *transform) const {
+	auto f = std::lower_bound(by_address.begin(), by_address.end(), std::make_pair(transform, uint32_t(0)));
+	if (f == by_address.end() || f->first != transform) return -1U;
+	return f->second;
+}
 
-	//null transform maps to itself:
-	transform_to_transform.insert(std::make_pair(nullptr, nullptr));
+bool Scene::CloneIndex::matches(Scene const &scene) const {
+	if (transforms.size() != scene.transforms.size()
+	 || drawables.size() != scene.drawables.size()
+	 || cameras.size() != scene.cameras.size()
+	 || lights.size() != scene.lights.size()) return false;
+
+	uint32_t i = 0;
+	for (auto const &t : scene.transforms) {
+		if (transforms[i] != &t) return false;
+		if (t.parent != (parents[i] == -1U ? nullptr : transforms[parents[i]])) return false;
+		++i;
+	}
+	i = 0;
+	for (auto const &d : scene.drawables) {
+		if (drawable_list[i] != &d || transforms[drawables[i]] != d.transform) return false;
+		++i;
+	}
+	//(cameras and lights of a sharing scene may be attached to base's transforms; those are indexed as -1U)
+	auto in_base = [&scene](Transform const *transform) {
+		return scene.shared.base && scene.shared.base->clone_index.find(transform) != -1U;
+	};
+	i = 0;
+	for (auto const &c : scene.cameras) {
+		uint32_t index = cameras[i++];
+		if (index == -1U ? !in_base(c.transform) : transforms[index] != c.transform) return false;
+	}
+	i = 0;
+	for (auto const &l : scene.lights) {
+		uint32_t index = lights[i++];
+		if (index == -1U ? !in_base(l.transform) : transforms[index] != l.transform) return false;
+	}
+	return true;
+}
 
-	//Copy transforms and store mapping:
+void Scene::CloneIndex::build(Scene const &scene) {
 	transforms.clear();
-	for (auto const &t : other.transforms) {
-		transforms.emplace_back();
-		transforms.back().name = t.name;
-		transforms.back().position = t.position;
-		transforms.back().rotation = t.rotation;
-		transforms.back().scale = t.scale;
-		transforms.back().parent = t.parent; //will update later
+	by_address.clear();
+	transforms.reserve(scene.transforms.size());
+	by_address.reserve(scene.transforms.size());
+	for (auto const &t : scene.transforms) {
+		by_address.emplace_back(&t, uint32_t(transforms.size()));
+		transforms.emplace_back(&t);
+	}
+	std::sort(by_address.begin(), by_address.end());
+
+	auto index_of = [this](Transform const *transform) {
+		uint32_t index = find(transform);
+		if (index == -1U) throw std::runtime_error("scene refers to a transform that isn't in the scene");
+		return index;
+	};
+
+	parents.clear();
+	parents.reserve(transforms.size());
+	for (auto t : transforms) {
+		parents.emplace_back(t->parent ? index_of(t->parent) : -1U);
+	}
 
-		//store mapping between transforms old and new:
-		auto ret = transform_to_transform.insert(std::make_pair(&t, &transforms.back()));
-		assert(ret.second);
+	drawables.clear();
+	drawable_list.clear();
+	for (auto const &d : scene.drawables) {
+		drawables.emplace_back(index_of(d.transform));
+		drawable_list.emplace_back(&d);
 	}
 
-	//update transform parents:
+	//children and attached drawables of each transform, as ranges of one array each (counting sort by parent / transform):
+	auto group = [this](std::vector< uint32_t > const &keys, std::vector< uint32_t > *begin_, std::vector< uint32_t > *items_) {
+		auto &begin = *begin_;
+		auto &items = *items_;
+		begin.assign(transforms.size() + 1, 0);
+		for (uint32_t key : keys) {
+			if (key != -1U) ++begin[key + 1];
+		}
+		for (uint32_t t = 0; t < transforms.size(); ++t) {
+			begin[t + 1] += begin[t];
+		}
+		items.resize(begin.back());
+		std::vector< uint32_t > next(begin.begin(), begin.end() - 1);
+		for (uint32_t i = 0; i < keys.size(); ++i) {
+			if (keys[i] != -1U) items[next[keys[i]]++] = i;
+		}
+	};
+	group(parents, &children_begin, &children);
+	group(drawables, &attached_begin, &attached);
+
+	auto index_of_or_base = [&](Transform const *transform) {
+		if (scene.shared.base && scene.shared.base->clone_index.find(transform) != -1U) return -1U;
+		return index_of(transform);
+	};
+	cameras.clear();
+	for (auto const &c : scene.cameras) cameras.emplace_back(index_of_or_base(c.transform));
+	lights.clear();
+	for (auto const &l : scene.lights) lights.emplace_back(index_of_or_base(l.transform));
+}
+
+Scene::CloneIndex const &Scene::get_clone_index() const {
+	if (!clone_index.matches(*this)) clone_index.build(*this);
+	return clone_index;
+}
+
+void Scene::set(Scene const &other, std::unordered_map< Transform const *, Transform * > *transform_map) {
+	CloneIndex const &index = other.get_clone_index();
+
+	transform_arrays.clear();
+	clear_bvh();
+	clear_name_index();
+
+	//copied names point into other's name table, so share it:
+	name_table = other.name_table;
+
+	//Copy transforms, re-using this scene's list nodes where possible:
+	transforms.resize(other.transforms.size());
+	std::vector< Transform * > copies;
+	copies.reserve(transforms.size());
 	for (auto &t : transforms) {
-		t.parent = transform_to_transform.at(t.parent);
+		copies.emplace_back(&t);
+	}
+	for (uint32_t i = 0; i < copies.size(); ++i) {
+		copy_transform(*index.transforms[i], (index.parents[i] == -1U ? nullptr : copies[index.parents[i]]), copies[i]);
+	}
+
+	if (transform_map) {
+		transform_map->clear();
+		transform_map->insert(std::make_pair(nullptr, nullptr));
+		for (uint32_t i = 0; i < copies.size(); ++i) {
+			transform_map->insert(std::make_pair(index.transforms[i], copies[i]));
+		}
 	}
 
-	//copy other's drawables, updating transform pointers:
+	//copy other's drawables, cameras, and lights, updating transform pointers:
 	drawables = other.drawables;
+	uint32_t i = 0;
 	for (auto &d : drawables) {
-		d.transform = transform_to_transform.at(d.transform);
+		d.transform = copies[index.drawables[i++]];
 	}
 
-	//copy other's cameras, updating transform pointers:
+	//(cameras and lights attached to the transforms other shares from its base are left attached to them)
 	cameras = other.cameras;
+	i = 0;
 	for (auto &c : cameras) {
-		c.transform = transform_to_transform.at(c.transform);
+		uint32_t t = index.cameras[i++];
+		if (t != -1U) c.transform = copies[t];
 	}
 
-	//copy other's lights, updating transform pointers:
 	lights = other.lights;
+	i = 0;
 	for (auto &l : lights) {
-		l.transform = transform_to_transform.at(l.transform);
+		uint32_t t = index.lights[i++];
+		if (t != -1U) l.transform = copies[t];
+	}
+
+	//share what other shares (if anything):
+	shared = Shared();
+	if (other.shared.base) {
+		shared.base = other.shared.base;
+		shared.copied_subtrees = other.shared.copied_subtrees;
+		shared.copied_drawables = other.shared.copied_drawables;
+		shared.copies.assign(other.shared.copies.size(), nullptr);
+		for (uint32_t b = 0; b < other.shared.copies.size(); ++b) {
+			if (other.shared.copies[b]) shared.copies[b] = copies[index.find(other.shared.copies[b])];
+		}
+	}
+}
+
+//-------------------------
+
+void Scene::share(std::shared_ptr< Scene const > const &base) {
+	assert(base);
+	if (base->shared.base) {
+		throw std::runtime_error("can't share a scene that is itself sharing another scene");
 	}
+	CloneIndex const &index = base->get_clone_index();
+
+	transform_arrays.clear();
+	clear_bvh();
+	clear_name_index();
+	transforms.clear();
+	drawables.clear();
+	cameras = base->cameras;
+
+	//(names of copies made by edit() point into base's name table, which shared.base keeps alive)
+	name_table = std::make_shared< NameTable >();
+	lights = base->lights;
+
+	shared.base = base;
+	shared.copies.assign(index.transforms.size(), nullptr);
+	shared.copied_subtrees.assign(index.transforms.size(), 0);
+	shared.copied_drawables.assign(index.drawables.size(), 0);
+}
+
+Scene::Transform *Scene::copy_shared(uint32_t i) {
+	if (shared.copies[i]) return shared.copies[i];
+	CloneIndex const &index = shared.base->clone_index;
+
+	Transform *parent = (index.parents[i] == -1U ? nullptr : copy_shared(index.parents[i]));
+	transforms.emplace_back();
+	copy_transform(*index.transforms[i], parent, &transforms.back());
+	shared.copies[i] = &transforms.back();
+	return shared.copies[i];
+}
+
+Scene::Transform *Scene::edit(Transform const *transform) {
+	assert(transform);
+	if (!shared.base) return const_cast< Transform * >(transform);
+	CloneIndex const &index = shared.base->clone_index;
+	//(share() checked the whole index against base; re-checking it here would make every edit() cost the size of base)
+	assert(index.transforms.size() == shared.base->transforms.size() && "shared scene changed");
+
+	uint32_t root = index.find(transform);
+	if (root == -1U) return const_cast< Transform * >(transform); //already this scene's own
+	if (shared.copied_subtrees[root]) return shared.copies[root];
+
+	//copy root and its descendants (copy_shared also copies ancestors, so the copies' parents are always copies)
+	// and their drawables, skipping any subtree an earlier edit() already copied:
+	// (root itself may have been copied before, as an ancestor of an edited transform, without its subtree)
+	std::vector< uint32_t > todo(1, root);
+	while (!todo.empty()) {
+		uint32_t i = todo.back();
+		todo.pop_back();
+		if (shared.copied_subtrees[i]) continue;
+		shared.copied_subtrees[i] = 1;
+
+		Transform *copy = copy_shared(i);
+		for (uint32_t a = index.attached_begin[i]; a < index.attached_begin[i+1]; ++a) {
+			uint32_t d = index.attached[a];
+			if (shared.copied_drawables[d]) continue;
+			drawables.emplace_back(*index.drawable_list[d]);
+			drawables.back().transform = copy;
+			shared.copied_drawables[d] = 1;
+		}
+		todo.insert(todo.end(), index.children.begin() + index.children_begin[i], index.children.begin() + index.children_begin[i+1]);
+	}
+
+	//move cameras and lights to the copies:
+	auto move = [&](Transform **transform) {
+		uint32_t i = index.find(*transform);
+		if (i != -1U && shared.copies[i]) *transform = shared.copies[i];
+	};
+	for (auto &c : cameras) move(&c.transform);
+	for (auto &l : lights) move(&l.transform);
+
+	return shared.copies[root];
+}
+
+Scene::Transform const *Scene::resolve(Transform const *transform) const {
+	if (!shared.base) return transform;
+	uint32_t i = shared.base->clone_index.find(transform);
+	if (i == -1U || !shared.copies[i]) return transform;
+	return shared.copies[i];
 }
@@ -11,21 +11,28 @@
  */
 
 #include "GL.hpp"
+#include "BVH.hpp"
+#include "NameId.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+#include <atomic>
+#include <limits>
 #include <list>
 #include <memory>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 
 struct Scene {
 	struct Transform {
 		//Transform names are useful for debugging and looking up locations in a loaded scene:
-		std::string name;
+		// (this points into a string table shared by the scene and its copies, so set it to a string
+		//  literal or something returned by Scene::store_name() -- never to a temporary std::string)
+		std::string_view name;
 
 		//The core function of a transform is to store a transformation in the world:
 		glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -40,13 +47,46 @@ struct Scene {
 		glm::mat4x3 make_local_to_parent() const;
 		glm::mat4x3 make_parent_to_local() const;
 		// ..relative to the world:
+		// (these are cached, and only recomputed when this transform or one of its ancestors changes)
+		// NOTE: since position/rotation/scale/parent are assigned directly, there's no dirty flag to consult, so every call
+		//  re-checks this transform *and each of its ancestors* against their caches -- O(depth) even on a cache hit.
 		glm::mat4x3 make_local_to_world() const;
 		glm::mat4x3 make_world_to_local() const;
+		// ..relative to the world, for code that reads many world matrices while nothing moves (e.g., Scene::draw):
+		// every call with the same 'pass' (from new_world_pass()) checks each transform against its cache at most once,
+		// so once a transform's ancestors have been checked in a pass, a cache hit costs O(1).
+		// NOTE: don't change transforms during a pass -- start a new pass after moving things
+		glm::mat4x3 make_local_to_world(uint64_t pass) const;
+		static uint64_t new_world_pass();
 
 		//since hierarchy is tracked through pointers, copy-constructing a transform  is not advised:
 		Transform(Transform const &) = delete;
 		//if we delete some constructors, we need to let the compiler know that the default constructor is still okay:
 		Transform() = default;
+
+		//-- internals --
+
+		//world matrix cache used by make_local_to_world() / make_world_to_local():
+		// changes are detected by comparing against the values the cache was built from,
+		// so position, rotation, scale, and parent may still be assigned directly.
+		struct WorldCache {
+			glm::vec3 position = glm::vec3(0.0f);
+			glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+			glm::vec3 scale = glm::vec3(1.0f);
+			Transform const *parent = nullptr;
+			uint64_t parent_stamp = 0; //parent's stamp when cache was built
+			uint64_t stamp = 0; //changes every time local_to_world is recomputed; 0 => not yet computed
+			glm::mat4x3 local_to_world = glm::mat4x3(1.0f);
+			bool has_world_to_local = false; //world_to_local is computed lazily
+			glm::mat4x3 world_to_local = glm::mat4x3(1.0f);
+		};
+		mutable WorldCache world_cache;
+		//pass during which world_cache was last checked (atomic, since transforms of a shared base scene may be read from several threads):
+		mutable std::atomic< uint64_t > checked_pass{0};
+
+		//bring world_cache up to date with this transform and its ancestors:
+		// (skipping transforms already checked during 'pass', if it isn't 0)
+		void update_world_cache(uint64_t pass = 0) const;
 	};
 
 	struct Drawable {
@@ -54,6 +94,11 @@ struct Scene {
 		Drawable(Transform *transform_) : transform(transform_) { assert(transform); }
 		Transform * transform;
 
+		//(optional) bounding box of the drawn vertices, in the transform's local space:
+		// used by Scene::draw to skip drawables outside the view; if min > max (the default) the drawable is never skipped.
+		glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+		glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
+
 		//Contains all the data needed to run the OpenGL pipeline:
 		struct Pipeline {
 			GLuint program = 0; //shader program; passed to glUseProgram
@@ -65,6 +110,26 @@ struct Scene {
 			GLuint start = 0; //first vertex to draw; passed to glDrawArrays
 			GLuint count = 0; //number of vertices to draw; passed to glDrawArrays
 
+			//(optional) indexed drawing:
+			// if index_type is set (e.g., GL_UNSIGNED_INT; copied from Mesh::index_type), Scene::draw uses glDrawElements instead,
+			// with start/count giving the range of indices in the element buffer bound in the vertex array(s)
+			GLenum index_type = 0;
+
+			//(optional) levels of detail for indexed drawing -- coarser ranges of indices (e.g., copied from Mesh::lods), finest first:
+			// Scene::draw uses the coarsest level whose error would be too small to see (see Scene::lod_error); unused levels have count == 0
+			// (only used for drawables with bounds, since the error is measured relative to them)
+			enum : uint32_t { LODCount = 3 };
+			struct LOD {
+				GLuint start = 0; //first index to draw
+				GLuint count = 0; //number of indices to draw
+				float error = 0.0f; //how far this level is from full detail, relative to the radius of the mesh's bounds (Drawable::min / max)
+			} lods[LODCount];
+
+			//position decoding for meshes with quantized positions (copied from Mesh::position_offset / position_scale):
+			// Scene::draw folds this into the object-to-clip and object-to-light matrices
+			glm::vec3 position_offset = glm::vec3(0.0f);
+			glm::vec3 position_scale = glm::vec3(1.0f);
+
 			//uniforms:
 			GLuint OBJECT_TO_CLIP_mat4 = -1U; //uniform location for object to clip space matrix
 			GLuint OBJECT_TO_LIGHT_mat4x3 = -1U; //uniform location for object to light space (== world space) matrix
@@ -72,6 +137,14 @@ struct Scene {
 
 			std::function< void() > set_uniforms; //(optional) function to set any other useful uniforms
 
+			//(optional) instanced drawing:
+			// when several drawables share all of the state above except for their transforms (and have no set_uniforms),
+			// Scene::draw draws them with a single glDrawArraysInstanced call through this program + vertex array.
+			// the program reads INSTANCE_OBJECT_TO_CLIP / INSTANCE_OBJECT_TO_LIGHT / INSTANCE_NORMAL_TO_LIGHT
+			// per-instance attributes, which Scene::add_instance_attributes() hooks up in the vertex array.
+			GLuint instanced_program = 0;
+			GLuint instanced_vao = 0;
+
 			//texture objects to bind for the first TextureCount textures:
 			enum : uint32_t { TextureCount = 4 };
 			struct TextureInfo {
@@ -122,12 +195,127 @@ struct Scene {
 	std::list< Camera > cameras;
 	std::list< Light > lights;
 
+	//Transform names are stored in a string table shared by this scene and its copies:
+	// (for loaded scenes, names point into one copy of the file's str0 chunk, rather than each having its own allocation)
+	struct NameTable {
+		//copy characters into the table (the copy lives as long as the table does):
+		std::string_view store(std::string_view chars);
+
+		//-- internals --
+		enum : size_t { BlockSize = 64 * 1024 };
+		std::vector< std::unique_ptr< char[] > > blocks; //storage (never moved, so stored names stay put)
+		size_t block_used = 0, block_size = 0;
+		std::vector< std::shared_ptr< void const > > external; //other storage names point into (e.g., a BakedScene's mapped file)
+	};
+	std::shared_ptr< NameTable > name_table = std::make_shared< NameTable >();
+	std::string_view store_name(std::string_view name) { return name_table->store(name); }
+
+	//look up this scene's transforms by name, through an index built on first use:
+	// NOTE: if you add, erase, or rename transforms, call update_name_index() (or clear_name_index()) before looking things up again
+	// (set(), share(), and load() take care of this themselves; for scenes made with share(),
+	//  only this scene's own transforms are indexed -- look up the rest in base, then edit() them)
+	void update_name_index() const;
+	void clear_name_index() const;
+	//first transform (in list order) named exactly 'name', or nullptr if there is none -- via a hash table:
+	Transform *find_transform(std::string_view name) const;
+	//...or with a name that has a given id (e.g., "bird"_id, hashed at compile time):
+	// (building the index throws if two different names in the scene have the same id)
+	Transform *find_transform(NameId id) const;
+	//append transforms whose names start with / end with / contain a string to *out, in list order:
+	// (prefix and suffix queries binary search sorted orders, which are built by the first such query;
+	//  substring queries scan the names, but as a packed array rather than list nodes)
+	void find_transforms_with_prefix(std::string_view prefix, std::vector< Transform * > *out) const;
+	void find_transforms_with_suffix(std::string_view suffix, std::vector< Transform * > *out) const;
+	void find_transforms_containing(std::string_view substring, std::vector< Transform * > *out) const;
+
+	//(optional) flat, structure-of-arrays mirror of the transform hierarchy:
+	// entries are kept in topological order (parents before children), so all
+	// world matrices can be computed in one linear sweep over contiguous arrays.
+	// the Transform objects in 'transforms' remain the handles that code reads and writes;
+	// the arrays are only a cache -- update() re-gathers every entry from its handle -- so writes to them are lost.
+	struct TransformArrays {
+		std::vector< Transform * > handles; //transform for each entry
+		std::vector< uint32_t > parents; //index of parent entry, or -1U for roots; always less than own index
+		std::vector< glm::vec3 > positions;
+		std::vector< glm::quat > rotations;
+		std::vector< glm::vec3 > scales;
+		std::vector< uint64_t > stamps; //world cache stamp for each entry
+		std::vector< glm::mat4x3 > local_to_parent;
+		std::vector< glm::mat4x3 > local_to_world;
+
+		//(re)build handles + parents from a list of transforms:
+		// throws if the parent pointers contain a cycle
+		void build(std::list< Transform > &transforms);
+
+		//copy position/rotation/scale in from handles, compute local_to_world for every entry,
+		// and store the results in the handles' world caches:
+		// returns false if the hierarchy no longer matches 'handles' -- by then, entries before the first mismatch
+		// have already had position/rotation/scale re-gathered, but no matrices or world caches have changed;
+		// build() and update() again (as update_transforms() does)
+		bool update();
+
+		void clear();
+	};
+	TransformArrays transform_arrays;
+
+	//compute all world matrices via transform_arrays, rebuilding it if the hierarchy has changed:
+	// (call once per frame after moving transforms; afterward transform_arrays.local_to_world[i] is the world matrix of
+	//  transform_arrays.handles[i], and make_local_to_world() calls are cache hits)
+	// NOTE: if you erase transforms, call transform_arrays.clear() so no stale handles are kept
+	void update_transforms();
+
 	//The "draw" function provides a convenient way to pass all the things in a scene to OpenGL:
 	void draw(Camera const &camera) const;
 
 	//..sometimes, you want to draw with a custom projection matrix and/or light space:
 	void draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light = glm::mat4x3(1.0f)) const;
 
+	//largest simplification error draw() allows on screen when picking levels of detail (Drawable::Pipeline::lods),
+	// as a fraction of the viewport's height (0 => always draw full detail):
+	float lod_error = 0.001f;
+
+	//(optional) bounding volume hierarchy over the world-space bounding boxes of drawables:
+	// update_bvh() fits the hierarchy to the current transforms (rebuilding it if drawables were added
+	// or removed, or if moving things has made it inefficient). Once it has been called, draw() culls
+	// through the hierarchy and pick() / query() can be used -- so call it again after moving things.
+	// NOTE: if you erase drawables, call clear_bvh() (or update_bvh()) so no stale drawables are kept
+	void update_bvh() const;
+	void clear_bvh() const;
+
+	//nearest drawable whose world-space box is hit by the ray origin + t * direction (t >= 0), or nullptr if none:
+	// (only drawables with bounds can be picked; *distance, if given, is set to t)
+	Drawable const *pick(glm::vec3 const &origin, glm::vec3 const &direction, float *distance = nullptr) const;
+
+	//append drawables whose world-space boxes overlap the box [min,max] to *out:
+	void query(glm::vec3 const &min, glm::vec3 const &max, std::vector< Drawable const * > *out) const;
+
+	//draw() sorts drawables by (program, vao, textures, depth) and only changes GL state when it must;
+	// these counters record what the most recent draw() call did (and are added to profiler counters, too):
+	struct DrawStats {
+		uint32_t draws = 0; //glDraw{Arrays,Elements}[Instanced] calls
+		uint32_t instanced_draws = 0; //glDraw{Arrays,Elements}Instanced calls
+		uint32_t instances = 0; //drawables drawn via glDraw{Arrays,Elements}Instanced
+		uint32_t triangles = 0; //triangles submitted (counting every instance; GL_TRIANGLES drawables only)
+		uint32_t simplified = 0; //drawables drawn with one of their levels of detail
+		uint32_t visible = 0; //drawables that passed view culling (or had no bounds to cull with)
+		uint32_t culled = 0; //drawables skipped because their bounds were outside the view
+		uint32_t program_changes = 0; //glUseProgram calls
+		uint32_t vao_changes = 0; //glBindVertexArray calls
+		uint32_t texture_changes = 0; //glBindTexture calls
+	};
+	mutable DrawStats draw_stats;
+
+	//per-instance data for instanced drawing, streamed to a shared buffer by draw():
+	struct InstanceData {
+		glm::mat4 OBJECT_TO_CLIP;
+		glm::mat4x3 OBJECT_TO_LIGHT;
+		glm::mat3 NORMAL_TO_LIGHT;
+	};
+
+	//bind the INSTANCE_* per-instance attributes used by 'program' in 'vao' to the shared instance buffer:
+	// (the instance buffer is created on first call, so this needs a GL context)
+	static void add_instance_attributes(GLuint vao, GLuint program);
+
 	//add transforms/objects/cameras from a scene file to this scene:
 	// the 'on_drawable' callback gives your code a chance to look up mesh data and make Drawables:
 	// throws on file format errors
@@ -150,4 +338,92 @@ struct Scene {
 	Scene &operator=(Scene const &); //...as scene = scene
 	//... as a set() function that optionally returns the transform->transform mapping:
 	void set(Scene const &, std::unordered_map< Transform const *, Transform * > *transform_map = nullptr);
+	// (copies are made through index tables kept with the source scene -- see CloneIndex -- so copying
+	//  a scene repeatedly, e.g. on every game restart, doesn't hash a single pointer)
+	// NOTE: assigning over a scene re-uses its existing transforms (in list order) to hold the copies, so pointers
+	//  into the old scene stay valid but now point at *different* transforms. Look transforms up again afterward
+	//  (e.g., with find_transform() or transform_map) rather than keeping pointers across a set().
+
+	//copy-on-write instancing:
+	// share(base) empties this scene and has it use base's transforms and drawables in place instead of copying them
+	// (cameras and lights are few, so they're copied, but still attached to base's transforms).
+	// draw(), update_bvh(), pick(), and query() treat base's drawables as if they were this scene's own.
+	// Before changing a transform from base, call edit(), which copies it into this scene -- along with its
+	// descendants (whose world matrices depend on it) and their drawables -- and returns the copy.
+	// (its ancestors are copied too, so that the copies' parents are this scene's, but their other children and
+	//  their drawables stay shared until an ancestor is itself edited; each edit() costs the size of what it copies)
+	// So many scenes (e.g., game sessions) can share one loaded scene, and each only pays for what it changes.
+	// NOTE: base must not change while it is shared. To share it between threads, bring its world matrices
+	//  up to date first (e.g., base.update_transforms()), so that sharing scenes never write to its caches.
+	//  (they still mark its transforms as checked during their read passes -- see make_local_to_world(pass) -- but those marks are atomic)
+	void share(std::shared_ptr< Scene const > const &base);
+	//this scene's modifiable version of a transform from base (or the transform itself if it is already this scene's):
+	Transform *edit(Transform const *transform);
+	//this scene's current version of a transform, without copying it:
+	Transform const *resolve(Transform const *transform) const;
+
+	//-- internals --
+
+	//index tables used to copy this scene by position instead of by pointer (by set() and share()):
+	// built on first use, and checked against the lists each time they're used (so they can't go stale).
+	struct CloneIndex {
+		std::vector< Transform const * > transforms; //transforms, in list order
+		std::vector< uint32_t > parents; //index of each transform's parent, or -1U
+		std::vector< uint32_t > drawables, cameras, lights; //index of each one's transform, in list order (cameras and lights use -1U for base's transforms; see share())
+		std::vector< Drawable const * > drawable_list; //drawables, in list order
+		//children of transform i are children[children_begin[i], children_begin[i+1]); its drawables (by index) are attached[attached_begin[i], attached_begin[i+1]):
+		std::vector< uint32_t > children_begin, children;
+		std::vector< uint32_t > attached_begin, attached;
+		std::vector< std::pair< Transform const *, uint32_t > > by_address; //(transform, index), sorted by address
+		uint32_t find(Transform const *transform) const; //index of a transform, or -1U if it isn't in the scene
+		bool matches(Scene const &scene) const;
+		void build(Scene const &scene); //throws if anything points at a transform that isn't in the scene
+	};
+	mutable CloneIndex clone_index;
+	CloneIndex const &get_clone_index() const;
+
+	//index used by find_transform() and friends:
+	struct NameIndex {
+		bool active = false; //has it been built (since clear_name_index())?
+		std::vector< Transform * > transforms; //in list order
+		std::vector< std::string_view > names; //name of each of the above
+		std::vector< NameId > ids; //id of each name
+		std::vector< uint32_t > slots; //open-addressing hash table (by id) of the first transform with each name (-1U: empty)
+		std::vector< uint32_t > by_name, by_suffix; //transforms sorted by name / by reversed name (empty until needed)
+	};
+	mutable NameIndex name_index;
+
+	//state for share() / edit():
+	struct Shared {
+		std::shared_ptr< Scene const > base;
+		std::vector< Transform * > copies; //copy of each of base's transforms (by base clone index), or nullptr
+		std::vector< uint8_t > copied_subtrees; //for each of base's transforms, has edit() copied it along with all of its descendants and their drawables?
+		std::vector< uint8_t > copied_drawables; //for each of base's drawables (in list order), has edit() copied it?
+	} shared;
+	Transform *copy_shared(uint32_t index); //copy a transform (and its ancestors, but not their drawables) from base
+
+	//render queue used by draw(); kept around to avoid re-allocating every frame:
+	struct QueueEntry {
+		uint64_t key; //sort key
+		Drawable const *drawable;
+		GLuint start, count; //range to draw (the pipeline's own, or one of its levels of detail)
+	};
+	mutable std::vector< QueueEntry > render_queue, render_queue_temp;
+	mutable std::vector< InstanceData > instance_data;
+	//world-space boxes of drawables to be culled (as center, half-extents):
+	mutable std::vector< Drawable const * > cull_drawables;
+	mutable std::vector< glm::vec3 > cull_centers, cull_radii;
+	mutable std::vector< uint8_t > cull_visible;
+
+	//hierarchy used by update_bvh(), draw(), pick(), and query():
+	struct DrawableBVH {
+		bool active = false; //has update_bvh() been called (since clear_bvh())?
+		BVH bvh;
+		std::vector< Drawable const * > drawables; //drawable for each bvh item
+		std::vector< Drawable const * > unbounded; //drawables without bounds (never culled)
+		std::vector< Drawable const * > gathered; //scratch space for update_bvh()
+		std::vector< glm::vec3 > mins, maxs; //world-space box of each bvh item
+		std::vector< uint32_t > hits; //scratch space for queries
+	};
+	mutable DrawableBVH drawable_bvh;
 };
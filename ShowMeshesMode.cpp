@@ -2,8 +2,12 @@
 
 #include "ShowMeshesProgram.hpp"
 #include "DrawLines.hpp"
+#include "vertex_cache.hpp"
 
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <vector>
 
 ShowMeshesMode::ShowMeshesMode(MeshBuffer const &buffer_) : buffer(buffer_) {
 	vao = buffer.make_vao_for_program(show_meshes_program->program);
@@ -148,6 +152,18 @@ void ShowMeshesMode::draw(glm::uvec2 const &drawable_size) {
 			0.15f * glm::vec3(0.0f, 1.0f, 0.0f),
 			glm::u8vec4(0xff, 0xff, 0xff, 0xff)
 		);
+
+		//vertex counts and cache efficiency:
+		std::ostringstream stats;
+		stats << current_mesh_vertices << " vertices (" << current_mesh_drawn_vertices << " unindexed), ACMR "
+		      << std::fixed << std::setprecision(2) << current_mesh_acmr << " (3.00 unindexed)";
+		if (current_mesh_lods) stats << ", " << current_mesh_lods << " LODs";
+		draw_lines.draw_text(stats.str(),
+			current_mesh_min + glm::vec3(0.0f, -0.35f, 0.0f),
+			0.1f * glm::vec3(1.0f, 0.0f, 0.0f),
+			0.1f * glm::vec3(0.0f, 1.0f, 0.0f),
+			glm::u8vec4(0xdd, 0xdd, 0xdd, 0xff)
+		);
 	}
 }
 
@@ -161,8 +177,13 @@ void ShowMeshesMode::select_prev_mesh() {
 		scene_drawable->pipeline.type = f->second.type;
 		scene_drawable->pipeline.start = f->second.start;
 		scene_drawable->pipeline.count = f->second.count;
+		scene_drawable->pipeline.index_type = f->second.index_type;
+		scene_drawable->pipeline.position_offset = f->second.position_offset;
+		scene_drawable->pipeline.position_scale = f->second.position_scale;
 		current_mesh_min = f->second.min;
 		current_mesh_max = f->second.max;
+		scene_drawable->min = current_mesh_min;
+		scene_drawable->max = current_mesh_max;
 	} else {
 		current_mesh_name = "";
 		scene_drawable->pipeline.type = GL_TRIANGLES;
@@ -170,7 +191,10 @@ void ShowMeshesMode::select_prev_mesh() {
 		scene_drawable->pipeline.count = 0;
 		current_mesh_min = glm::vec3(0.0f);
 		current_mesh_max = glm::vec3(0.0f);
+		scene_drawable->min = current_mesh_min;
+		scene_drawable->max = current_mesh_max;
 	}
+	update_current_mesh_stats();
 }
 
 void ShowMeshesMode::select_next_mesh() {
@@ -190,8 +214,13 @@ void ShowMeshesMode::select_next_mesh() {
 		scene_drawable->pipeline.type = f->second.type;
 		scene_drawable->pipeline.start = f->second.start;
 		scene_drawable->pipeline.count = f->second.count;
+		scene_drawable->pipeline.index_type = f->second.index_type;
+		scene_drawable->pipeline.position_offset = f->second.position_offset;
+		scene_drawable->pipeline.position_scale = f->second.position_scale;
 		current_mesh_min = f->second.min;
 		current_mesh_max = f->second.max;
+		scene_drawable->min = current_mesh_min;
+		scene_drawable->max = current_mesh_max;
 	} else {
 		current_mesh_name = "";
 		scene_drawable->pipeline.type = GL_TRIANGLES;
@@ -199,5 +228,36 @@ void ShowMeshesMode::select_next_mesh() {
 		scene_drawable->pipeline.count = 0;
 		current_mesh_min = glm::vec3(0.0f);
 		current_mesh_max = glm::vec3(0.0f);
+		scene_drawable->min = current_mesh_min;
+		scene_drawable->max = current_mesh_max;
+	}
+	update_current_mesh_stats();
+}
+
+void ShowMeshesMode::update_current_mesh_stats() {
+	auto f = buffer.meshes.find(current_mesh_name);
+	if (f == buffer.meshes.end()) {
+		current_mesh_vertices = 0;
+		current_mesh_drawn_vertices = 0;
+		current_mesh_acmr = 0.0f;
+		current_mesh_lods = 0;
+		return;
+	}
+	Mesh const &mesh = f->second;
+
+	current_mesh_vertices = mesh.vertex_count;
+	current_mesh_drawn_vertices = mesh.count;
+	current_mesh_lods = uint32_t(mesh.lods.size());
+
+	if (mesh.index_type == GL_UNSIGNED_INT) {
+		//read the mesh's indices back from the GPU:
+		std::vector< uint32_t > indices(mesh.count);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer.index_buffer);
+		glGetBufferSubData(GL_ARRAY_BUFFER, mesh.start * sizeof(uint32_t), indices.size() * sizeof(uint32_t), indices.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		current_mesh_acmr = compute_acmr(indices.data(), indices.size());
+	} else {
+		//without indices, every vertex of every triangle is transformed:
+		current_mesh_acmr = (mesh.count >= 3 ? 3.0f : 0.0f);
 	}
 }
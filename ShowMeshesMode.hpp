@@ -36,6 +36,13 @@ struct ShowMeshesMode : Mode {
 	glm::vec3 current_mesh_max = glm::vec3(0.0f);
 	void select_prev_mesh();
 	void select_next_mesh();
+
+	//stats for the currently selected mesh (shown along with its name):
+	uint32_t current_mesh_vertices = 0; //vertices stored
+	uint32_t current_mesh_drawn_vertices = 0; //vertices drawn (more than stored if indexed and vertices are shared)
+	float current_mesh_acmr = 0.0f; //average cache miss ratio (see vertex_cache.hpp)
+	uint32_t current_mesh_lods = 0; //simplified levels of detail stored along with the mesh (always shown at full detail here)
+	void update_current_mesh_stats();
 	
 	//Vertex array object used to bind mesh buffer for drawing:
 	GLuint vao = 0;
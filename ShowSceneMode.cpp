@@ -28,6 +28,20 @@ bool ShowSceneMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_
 			camera.flip_x = (std::abs(camera.elevation) > 0.5f * 3.1415926f);
 			return true;
 		}
+		if (evt.button.button == SDL_BUTTON_RIGHT) {
+			//select the drawable under the mouse by casting a ray from the camera:
+			glm::vec2 ndc = glm::vec2(
+				evt.button.x / float(window_size.x) * 2.0f - 1.0f,
+				evt.button.y / float(window_size.y) * -2.0f + 1.0f
+			);
+			float tan_half = std::tan(0.5f * scene_camera->fovy);
+			glm::vec3 dir = scene_camera->transform->rotation * glm::vec3(ndc.x * tan_half * scene_camera->aspect, ndc.y * tan_half, -1.0f);
+			selected = scene.pick(scene_camera->transform->position, dir);
+			if (selected) {
+				std::cout << "Selected drawable on '" << selected->transform->name << "'." << std::endl;
+			}
+			return true;
+		}
 	}
 	if (evt.type == SDL_MOUSEMOTION) {
 		if (evt.motion.state & SDL_BUTTON(SDL_BUTTON_LEFT)) {
@@ -91,6 +105,7 @@ void ShowSceneMode::draw(glm::uvec2 const &drawable_size) {
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LEQUAL);
 
+	scene.update_bvh(); //(so draw() can cull through it and right-clicks can pick)
 	scene.draw(*scene_camera);
 
 	{ //decorate with some lines:
@@ -121,13 +136,35 @@ void ShowSceneMode::draw(glm::uvec2 const &drawable_size) {
 			draw_lines.draw(xf(glm::vec3(0.0f)), xf(glm::vec3(0.0f, 0.0f, -len)), glm::u8vec4(0x00, 0x00, 0x88, 0xff));
 
 			//transform name:
-			draw_lines.draw_text("'" + transform.name + "'",
+			draw_lines.draw_text("'" + std::string(transform.name) + "'",
 				xf(glm::vec3(0.05f, 0.0f, 0.05f)),
 				0.15f * xfd(glm::vec3(1.0f, 0.0f, 0.0f)),
 				0.15f * xfd(glm::vec3(0.0f, 0.0f, 1.0f)),
 				glm::u8vec4(0xff, 0xff, 0xff, 0xff)
 			);
 		}
+
+		if (selected) {
+			//outline the selected drawable's bounds:
+			glm::mat4 local_to_world = selected->transform->make_local_to_world();
+			auto xf = [&local_to_world](glm::vec3 const &vec) {
+				return glm::vec3(local_to_world * glm::vec4(vec, 1.0f));
+			};
+			glm::vec3 const &min = selected->min;
+			glm::vec3 const &max = selected->max;
+			glm::u8vec4 color = glm::u8vec4(0x00, 0xff, 0xff, 0xff);
+			for (uint32_t a = 0; a < 3; ++a) {
+				//the four box edges parallel to axis 'a':
+				uint32_t b = (a + 1) % 3, c = (a + 2) % 3;
+				for (uint32_t corner = 0; corner < 4; ++corner) {
+					glm::vec3 p0 = min, p1 = min;
+					p1[a] = max[a];
+					if (corner & 1) p0[b] = p1[b] = max[b];
+					if (corner & 2) p0[c] = p1[c] = max[c];
+					draw_lines.draw(xf(p0), xf(p1), color);
+				}
+			}
+		}
 		/*
 		glEnable(GL_LINE_SMOOTH);
 		glEnable(GL_BLEND);
@@ -30,6 +30,9 @@ struct ShowSceneMode : Mode {
 	//Scene being viewed:
 	Scene const &scene;
 
+	//drawable selected by right-clicking (outlined when drawn):
+	Scene::Drawable const *selected = nullptr;
+
 	//mode uses a secondary Scene to hold a camera:
 	Scene camera_scene;
 	Scene::Camera *scene_camera = nullptr;
@@ -0,0 +1,108 @@
+#include "Spawner.hpp"
+
+#include "Collision.hpp"
+
+#include <cassert>
+
+float Spawner::random(float lo, float hi) {
+	return std::uniform_real_distribution< float >(0.0f, 1.0f)(rng) * (hi - lo) + lo;
+}
+
+uint32_t Spawner::add(Scene::Transform *transform, uint32_t collider_id) {
+	assert(transform);
+	uint32_t handle = uint32_t(slots.size());
+	uint32_t slot = uint32_t(transforms.size());
+
+	transforms.emplace_back(transform);
+	collider_ids.emplace_back(collider_id);
+	speeds.emplace_back(0.0f);
+	timers.emplace_back(random(params.min_spawn_time, params.max_spawn_time));
+	handles.emplace_back(handle);
+	slots.emplace_back(slot);
+
+	transform->position = params.parked_position;
+	set_collider_enabled(slot, false);
+
+	return handle;
+}
+
+void Spawner::update(float elapsed) {
+	//move active objects:
+	for (uint32_t i = 0; i < active_count; ++i) {
+		transforms[i]->position += (speeds[i] * elapsed) * params.direction;
+	}
+
+	//retire active objects that have left the live box:
+	// (walks backward, so the object swapped into slot i has already been checked)
+	for (uint32_t i = active_count; i > 0; --i) {
+		glm::vec3 const &p = transforms[i-1]->position;
+		if (p.x < params.live_min.x || p.y < params.live_min.y || p.z < params.live_min.z
+		 || p.x > params.live_max.x || p.y > params.live_max.y || p.z > params.live_max.z) {
+			retire_slot(i-1);
+		}
+	}
+
+	//count down spawn timers:
+	for (uint32_t i = active_count; i < uint32_t(timers.size()); ++i) {
+		timers[i] -= elapsed;
+	}
+
+	//spawn objects whose timers have run out:
+	// (spawning swaps slot i with the first waiting slot, which has already been checked)
+	for (uint32_t i = active_count; i < uint32_t(timers.size()); ++i) {
+		if (timers[i] <= 0.0f) spawn_slot(i);
+	}
+}
+
+void Spawner::spawn(uint32_t handle) {
+	assert(handle < slots.size());
+	if (slots[handle] >= active_count) spawn_slot(slots[handle]);
+}
+
+void Spawner::retire(uint32_t handle) {
+	assert(handle < slots.size());
+	if (slots[handle] < active_count) retire_slot(slots[handle]);
+}
+
+void Spawner::spawn_slot(uint32_t slot) {
+	assert(slot >= active_count && slot < transforms.size());
+	swap_slots(slot, active_count);
+	slot = active_count;
+	active_count += 1;
+
+	transforms[slot]->position = glm::vec3(
+		random(params.spawn_min.x, params.spawn_max.x),
+		random(params.spawn_min.y, params.spawn_max.y),
+		random(params.spawn_min.z, params.spawn_max.z)
+	);
+	speeds[slot] = random(params.min_speed, params.max_speed);
+	set_collider_enabled(slot, true);
+}
+
+void Spawner::retire_slot(uint32_t slot) {
+	assert(slot < active_count);
+	active_count -= 1;
+	swap_slots(slot, active_count);
+	slot = active_count;
+
+	transforms[slot]->position = params.parked_position;
+	timers[slot] = random(params.min_spawn_time, params.max_spawn_time);
+	set_collider_enabled(slot, false);
+}
+
+void Spawner::swap_slots(uint32_t a, uint32_t b) {
+	if (a == b) return;
+	std::swap(transforms[a], transforms[b]);
+	std::swap(collider_ids[a], collider_ids[b]);
+	std::swap(speeds[a], speeds[b]);
+	std::swap(timers[a], timers[b]);
+	std::swap(handles[a], handles[b]);
+	slots[handles[a]] = a;
+	slots[handles[b]] = b;
+}
+
+void Spawner::set_collider_enabled(uint32_t slot, bool enabled) {
+	if (collision && collider_ids[slot] != -1U) {
+		collision->colliders[collider_ids[slot]].enabled = enabled;
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+/*
+ * A Spawner manages a fixed pool of scene objects that repeatedly spawn,
+ * travel in a straight line, and retire (e.g., obstacles flying past).
+ *
+ * Pool data is stored as parallel arrays, partitioned so that active objects
+ * come first and waiting objects come last; update() then moves all active
+ * objects and counts down all spawn timers in two tight loops, and spawning
+ * or retiring an object is just a swap across the partition.
+ *
+ * Nothing is allocated after the pool has been filled.
+ *
+ */
+
+#include "Scene.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+struct Collision;
+
+struct Spawner {
+	Spawner(uint32_t seed = 0) : rng(seed) { }
+
+	struct Params {
+		float min_spawn_time = 1.0f, max_spawn_time = 1.0f; //time an object waits after retiring before spawning again
+		float min_speed = 1.0f, max_speed = 1.0f; //speed objects are spawned with
+		glm::vec3 direction = glm::vec3(-1.0f, 0.0f, 0.0f); //direction of travel
+		glm::vec3 spawn_min = glm::vec3(0.0f), spawn_max = glm::vec3(0.0f); //objects spawn at a random spot in this box
+		glm::vec3 live_min = glm::vec3(-std::numeric_limits< float >::infinity()); //objects retire on leaving this box
+		glm::vec3 live_max = glm::vec3( std::numeric_limits< float >::infinity());
+		glm::vec3 parked_position = glm::vec3(0.0f); //where objects wait before spawning
+	} params;
+
+	//(optional) if set, objects' colliders are only enabled while they are active:
+	Collision *collision = nullptr;
+
+	//add an object to the pool (it starts out waiting to spawn), returning a handle for it:
+	uint32_t add(Scene::Transform *transform, uint32_t collider_id = -1U);
+
+	//move active objects, count down spawn timers, and spawn / retire objects as needed:
+	void update(float elapsed);
+
+	//spawn / retire an object early (e.g., when it is hit):
+	void spawn(uint32_t handle);
+	void retire(uint32_t handle);
+
+	bool is_active(uint32_t handle) const { return slots[handle] < active_count; }
+
+	//pool storage, indexed by slot -- slots [0,active_count) are active, the rest are waiting:
+	uint32_t active_count = 0;
+	std::vector< Scene::Transform * > transforms;
+	std::vector< uint32_t > collider_ids; //-1U if no collider
+	std::vector< float > speeds; //(meaningful for active slots)
+	std::vector< float > timers; //time left before spawning (meaningful for waiting slots)
+
+	//handles stay the same as objects move between slots:
+	std::vector< uint32_t > handles; //handle of object in each slot
+	std::vector< uint32_t > slots; //slot of each handle
+
+	//-- internals --
+	std::mt19937 rng;
+	float random(float lo, float hi);
+
+	void spawn_slot(uint32_t slot);
+	void retire_slot(uint32_t slot);
+	void swap_slots(uint32_t a, uint32_t b);
+	void set_collider_enabled(uint32_t slot, bool enabled);
+};
@@ -0,0 +1,107 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+ThreadPool::ThreadPool(uint32_t threads) {
+	if (threads == 0) {
+		uint32_t hardware = std::thread::hardware_concurrency();
+		threads = (hardware > 1 ? hardware - 1 : 1);
+	}
+	workers.reserve(threads);
+	for (uint32_t i = 0; i < threads; ++i) {
+		workers.emplace_back([this](){
+			while (true) {
+				std::function< void() > job;
+				{
+					std::unique_lock< std::mutex > lock(mutex);
+					wake.wait(lock, [this](){ return stopping || !jobs.empty(); });
+					if (jobs.empty()) return; //(only empty if stopping)
+					job = std::move(jobs.front());
+					jobs.pop_front();
+				}
+				job();
+			}
+		});
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::run(std::function< void() > const &job) {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		jobs.emplace_back(job);
+	}
+	wake.notify_one();
+}
+
+void ThreadPool::parallel_for(size_t count, std::function< void(size_t) > const &work) {
+	if (count == 0) return;
+	if (count == 1 || workers.empty()) {
+		for (size_t i = 0; i < count; ++i) work(i);
+		return;
+	}
+
+	//helpers (and the calling thread) claim indices from a shared counter until none are left:
+	struct State {
+		std::atomic< size_t > next{0};
+		std::atomic< size_t > finished{0};
+		std::atomic< bool > failed{false}; //once set, claimed indices are skipped instead of run
+		std::exception_ptr error; //first exception thrown by work (guarded by mutex)
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+	//(shared, since helpers that start late -- after all the work is done -- still look at it)
+	auto state = std::make_shared< State >();
+
+	//NOTE: 'work' is only called for claimed indices, so late helpers never touch it after this function returns
+	// (exceptions are caught so every claimed index still counts as finished -- the caller rethrows after waiting)
+	auto drain = [state, count, &work]() {
+		for (size_t i = state->next++; i < count; i = state->next++) {
+			if (!state->failed) {
+				try {
+					work(i);
+				} catch (...) {
+					std::unique_lock< std::mutex > lock(state->mutex);
+					if (!state->error) state->error = std::current_exception();
+					state->failed = true;
+				}
+			}
+			if (++state->finished == count) {
+				std::unique_lock< std::mutex > lock(state->mutex);
+				state->done.notify_all();
+			}
+		}
+	};
+
+	size_t helpers = std::min(workers.size(), count - 1);
+	for (size_t h = 0; h < helpers; ++h) {
+		run(drain);
+	}
+
+	drain();
+
+	//wait for work items claimed by helpers to finish:
+	// (doesn't wait for helpers to start, so this is safe to call from inside a job)
+	std::unique_lock< std::mutex > lock(state->mutex);
+	state->done.wait(lock, [&state, count](){ return state->finished == count; });
+
+	if (state->error) std::rethrow_exception(state->error);
+}
+
+ThreadPool &ThreadPool::shared() {
+	static ThreadPool pool;
+	return pool;
+}
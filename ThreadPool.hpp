@@ -0,0 +1,44 @@
+#pragma once
+
+/*
+ * A ThreadPool keeps a set of worker threads around to run jobs, so
+ * code can spread work across cores without starting threads each time.
+ *
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ThreadPool {
+	//start 'threads' workers (0 => one fewer than the number of hardware threads, since callers usually help):
+	ThreadPool(uint32_t threads = 0);
+	//finishes any queued jobs, then stops the workers:
+	~ThreadPool();
+
+	ThreadPool(ThreadPool const &) = delete;
+	ThreadPool &operator=(ThreadPool const &) = delete;
+
+	//queue a job to be run on some worker:
+	void run(std::function< void() > const &job);
+
+	//call work(i) for every i in [0,count), spread across the workers and the calling thread:
+	// returns once all calls are finished; work must be safe to call concurrently
+	// if any call throws, indices not yet started are skipped, and the first exception is rethrown once the rest finish
+	void parallel_for(size_t count, std::function< void(size_t) > const &work);
+
+	//pool shared by the whole program (started on first use):
+	static ThreadPool &shared();
+
+	//-- internals --
+	std::vector< std::thread > workers;
+	std::mutex mutex;
+	std::condition_variable wake; //signalled when jobs are queued or workers should stop
+	std::deque< std::function< void() > > jobs;
+	bool stopping = false;
+};
@@ -0,0 +1,52 @@
+//bake-scene turns a '.scene' file and the '.pnct' file its meshes come from into a baked scene
+// (see BakedScene.hpp), which can be mapped and instantiated without parsing or looking anything up.
+//
+//Usage:
+// bake-scene <in.scene> <in.pnct> <out.bscene>
+//
+//Every mesh is looked up in the '.pnct' file here, once, so loading the result needs no name lookups
+// (just the header, the checksum, and a quick pass over the records' indices).
+//NOTE: the baked mesh ranges are only valid for the '.pnct' file they were baked against,
+// so re-bake whenever the meshes are re-exported (or re-indexed / quantized / simplified).
+// (the file's size and vertex/index totals are recorded, and BakedScene::instantiate refuses other mesh buffers)
+
+#include "BakedScene.hpp"
+#include "Mesh.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	if (argc != 4) {
+		std::cerr << "Usage:\n\t" << argv[0] << " <in.scene> <in.pnct> <out.bscene>" << std::endl;
+		return 1;
+	}
+	std::string scene_file = argv[1];
+	std::string meshes_file = argv[2];
+	std::string out_file = argv[3];
+
+	try {
+		//(no OpenGL context here, so don't upload anything)
+		MeshBuffer meshes(meshes_file, MeshBuffer::DeferUpload);
+
+		std::vector< char > data = BakedScene::bake(scene_file, meshes);
+		BakedScene::Header header;
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		std::ofstream out(out_file, std::ios::binary);
+		out.write(data.data(), data.size());
+		if (!out) throw std::runtime_error("failed to write '" + out_file + "'.");
+
+		std::cout << "Baked " << header.transforms.count << " transforms, " << header.drawables.count << " drawables (of " << header.meshes.count << " meshes), "
+			<< header.cameras.count << " cameras, and " << header.lights.count << " lights into '" << out_file << "' (" << data.size() << " bytes)." << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,227 @@
+//bench-baked-scene times getting a large scene ready to draw two ways:
+// - ".scene": Scene::load() with an on_drawable that looks each mesh up by name (as PlayMode and show-scene do)
+// - ".bscene": mapping a baked scene (BakedScene's constructor, which also verifies the checksum) and instantiate()ing it
+//The baked time is also split into the constructor, the checksum alone, and instantiate().
+//
+//Usage:
+// bench-baked-scene [transforms] [meshes] [repeats]
+//
+//Writes a synthetic .scene (default 150000 transforms, two thirds of them drawing a mesh picked at random from
+// [meshes], default dist/bird.pnct), bakes it with BakedScene::bake(), and removes both files after.
+//Files stay in the page cache between repeats, so these are warm-cache times (best of 'repeats', default 7).
+//Doesn't need OpenGL (meshes are loaded without uploading them).
+
+#include "BakedScene.hpp"
+#include "Mesh.hpp"
+#include "MappedFile.hpp"
+#include "data_path.hpp"
+#include "read_write_chunk.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+//same layouts as Scene::load's entries:
+struct HierarchyEntry {
+	uint32_t parent;
+	uint32_t name_begin;
+	uint32_t name_end;
+	glm::vec3 position;
+	glm::quat rotation;
+	glm::vec3 scale;
+};
+static_assert(sizeof(HierarchyEntry) == 4 + 4 + 4 + 4*3 + 4*4 + 4*3, "HierarchyEntry is packed.");
+
+struct MeshEntry {
+	uint32_t transform;
+	uint32_t name_begin;
+	uint32_t name_end;
+};
+static_assert(sizeof(MeshEntry) == 4 + 4 + 4, "MeshEntry is packed.");
+
+struct CameraEntry {
+	uint32_t transform;
+	char type[4]; //"pers" or "orth"
+	float data; //fov in degrees for 'pers', scale for 'orth'
+	float clip_near, clip_far;
+};
+static_assert(sizeof(CameraEntry) == 4 + 4 + 4 + 4 + 4, "CameraEntry is packed.");
+
+int main(int argc, char **argv) {
+	uint32_t count = 150000;
+	std::string meshes_file = data_path("../dist/bird.pnct");
+	uint32_t repeats = 7;
+	if (argc > 1) count = uint32_t(std::stoul(argv[1]));
+	if (argc > 2) meshes_file = argv[2];
+	if (argc > 3) repeats = uint32_t(std::stoul(argv[3]));
+
+	std::string const scene_file = "bench-baked-scene.scene";
+	std::string const baked_file = "bench-baked-scene.bscene";
+
+	MeshBuffer meshes(meshes_file, MeshBuffer::DeferUpload);
+	std::vector< std::string > mesh_names;
+	for (auto const &[name, mesh] : meshes.meshes) {
+		mesh_names.emplace_back(name);
+	}
+	if (mesh_names.empty()) {
+		std::cerr << "No meshes in '" << meshes_file << "'." << std::endl;
+		return 1;
+	}
+
+	//--- write the scene: chains of four transforms, the last three drawing a mesh each ---
+	{
+		std::mt19937 mt(0xba6ed);
+		auto uniform = [&mt](float lo, float hi) {
+			return std::uniform_real_distribution< float >(lo, hi)(mt);
+		};
+		std::vector< char > strings;
+		auto add_string = [&strings](std::string const &s, uint32_t *begin, uint32_t *end) {
+			*begin = uint32_t(strings.size());
+			strings.insert(strings.end(), s.begin(), s.end());
+			*end = uint32_t(strings.size());
+		};
+		std::vector< HierarchyEntry > hierarchy;
+		std::vector< MeshEntry > mesh_entries;
+		for (uint32_t i = 0; i < count; ++i) {
+			HierarchyEntry h;
+			h.parent = (i % 4 == 0 ? -1U : i - 1);
+			add_string("Object" + std::to_string(i), &h.name_begin, &h.name_end);
+			h.position = glm::vec3(uniform(-100.0f, 100.0f), uniform(-100.0f, 100.0f), uniform(-10.0f, 10.0f));
+			h.rotation = glm::angleAxis(uniform(0.0f, 6.28f), glm::vec3(0.0f, 0.0f, 1.0f));
+			h.scale = glm::vec3(1.0f);
+			hierarchy.emplace_back(h);
+			if (i % 4 != 0) {
+				MeshEntry m;
+				m.transform = i;
+				add_string(mesh_names[std::uniform_int_distribution< size_t >(0, mesh_names.size() - 1)(mt)], &m.name_begin, &m.name_end);
+				mesh_entries.emplace_back(m);
+			}
+		}
+		CameraEntry camera;
+		camera.transform = 0;
+		std::copy_n("pers", 4, camera.type);
+		camera.data = 60.0f;
+		camera.clip_near = 0.1f;
+		camera.clip_far = 1000.0f;
+
+		std::ofstream out(scene_file, std::ios::binary);
+		write_chunk("str0", strings, &out);
+		write_chunk("xfh0", hierarchy, &out);
+		write_chunk("msh0", mesh_entries, &out);
+		write_chunk("cam0", std::vector< CameraEntry >(1, camera), &out);
+		write_chunk("lmp0", std::vector< uint32_t >(), &out);
+		if (!out) {
+			std::cerr << "Failed to write '" << scene_file << "'." << std::endl;
+			return 1;
+		}
+	}
+	{
+		std::vector< char > data = BakedScene::bake(scene_file, meshes);
+		std::ofstream out(baked_file, std::ios::binary);
+		out.write(data.data(), data.size());
+		if (!out) {
+			std::cerr << "Failed to write '" << baked_file << "'." << std::endl;
+			return 1;
+		}
+	}
+
+	//--- time loading each ---
+	auto time = [](auto const &f) {
+		auto before = std::chrono::high_resolution_clock::now();
+		f();
+		auto after = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration< double, std::milli >(after - before).count();
+	};
+	auto best = [&](auto const &f) {
+		double ms = std::numeric_limits< double >::infinity();
+		for (uint32_t r = 0; r < repeats; ++r) {
+			ms = std::min(ms, f());
+		}
+		return ms;
+	};
+
+	Scene::Drawable::Pipeline pipeline; //(no GL, so a pipeline with nothing to draw with)
+	size_t drawables = 0;
+
+	double load_ms = best([&](){
+		auto scene = std::make_unique< Scene >();
+		double ms = time([&](){
+			scene->load(scene_file, [&](Scene &scene, Scene::Transform *transform, std::string const &mesh_name){
+				Mesh const &mesh = meshes.lookup(mesh_name);
+
+				scene.drawables.emplace_back(transform);
+				Scene::Drawable &drawable = scene.drawables.back();
+
+				drawable.pipeline = pipeline;
+				drawable.pipeline.type = mesh.type;
+				drawable.pipeline.start = mesh.start;
+				drawable.pipeline.count = mesh.count;
+				drawable.pipeline.index_type = mesh.index_type;
+				for (uint32_t i = 0; i < Scene::Drawable::Pipeline::LODCount && i < mesh.lods.size(); ++i) {
+					drawable.pipeline.lods[i].start = mesh.lods[i].start;
+					drawable.pipeline.lods[i].count = mesh.lods[i].count;
+					drawable.pipeline.lods[i].error = mesh.lods[i].error;
+				}
+				drawable.pipeline.position_offset = mesh.position_offset;
+				drawable.pipeline.position_scale = mesh.position_scale;
+
+				drawable.min = mesh.min;
+				drawable.max = mesh.max;
+			});
+		});
+		drawables = scene->drawables.size();
+		return ms; //(the scene is destroyed outside the timed part)
+	});
+
+	double constructor_ms = std::numeric_limits< double >::infinity();
+	double instantiate_ms = std::numeric_limits< double >::infinity();
+	double baked_ms = best([&](){
+		auto scene = std::make_unique< Scene >();
+		std::unique_ptr< BakedScene > baked;
+		double constructor = time([&](){ baked = std::make_unique< BakedScene >(baked_file); });
+		double instantiate = time([&](){ baked->instantiate(scene.get(), &meshes, pipeline); });
+		constructor_ms = std::min(constructor_ms, constructor);
+		instantiate_ms = std::min(instantiate_ms, instantiate);
+		if (scene->drawables.size() != drawables) {
+			std::cerr << "Baked scene has " << scene->drawables.size() << " drawables, expecting " << drawables << "." << std::endl;
+			std::exit(1);
+		}
+		return constructor + instantiate;
+	});
+
+	double checksum_ms = std::numeric_limits< double >::infinity();
+	uint64_t sum = 0; //(so the checksum isn't optimized away)
+	size_t scene_bytes = 0, baked_bytes = 0;
+	{
+		MappedFile scene_mapped(scene_file);
+		scene_bytes = scene_mapped.size;
+		MappedFile mapped(baked_file);
+		baked_bytes = mapped.size;
+		checksum_ms = best([&](){
+			return time([&](){ sum += BakedScene::checksum(mapped.data + sizeof(BakedScene::Header), mapped.data + mapped.size); });
+		});
+	}
+	std::remove(scene_file.c_str());
+	std::remove(baked_file.c_str());
+
+	std::cout << count << " transforms, " << drawables << " drawables (of " << mesh_names.size() << " meshes); .scene "
+	          << std::fixed << std::setprecision(2) << scene_bytes / (1024.0 * 1024.0) << " MB, .bscene " << baked_bytes / (1024.0 * 1024.0) << " MB; best of " << repeats << ", ms:" << std::endl;
+	std::cout << std::setw(28) << ".scene + lookups" << std::setw(10) << load_ms << std::endl;
+	std::cout << std::setw(28) << ".bscene" << std::setw(10) << baked_ms << std::endl;
+	std::cout << std::setw(28) << "  map + check (constructor)" << std::setw(10) << constructor_ms << std::endl;
+	std::cout << std::setw(28) << "    of which checksum" << std::setw(10) << checksum_ms << (sum == 12345 ? " " : "") << std::endl;
+	std::cout << std::setw(28) << "  instantiate" << std::setw(10) << instantiate_ms << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,132 @@
+//bench-bounds times compute_mesh_bounds() (the chunked, multi-threaded, SSE bounding box pass MeshBuffer uses on load)
+// against a serial glm::min / glm::max loop over each mesh, for 1M to 16M vertices,
+// and checks that the results are bit-identical.
+//
+//Usage:
+// bench-bounds [repeats]
+//
+//Vertices are laid out like a .pnct file (36 bytes each, position first) and are random, from a fixed seed.
+//Some coordinates are NaN, and half the meshes have minimums that are a mix of -0.0 and 0.0, so the check covers
+// the cases where SSE min/max and glm::min/max can disagree if their operands are in the wrong order.
+//Times are the best of [repeats] (default 10) runs. Returns non-zero if any result differs.
+
+#include "Mesh.hpp"
+#include "ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	uint32_t repeats = 10;
+	if (argc > 1) repeats = uint32_t(std::stoul(argv[1]));
+
+	size_t const stride = 36; //(same as a .pnct vertex)
+
+	std::cout << "compute_mesh_bounds() uses " << ThreadPool::shared().workers.size() + 1 << " threads (pool workers + caller)." << std::endl;
+	std::cout << "milliseconds (best of " << repeats << "):" << std::endl;
+	std::cout << std::setw(10) << "vertices" << std::setw(8) << "meshes" << std::setw(10) << "serial"
+	          << std::setw(22) << "compute_mesh_bounds" << std::setw(10) << "speedup" << std::endl;
+
+	std::mt19937 mt(0xb0b0);
+	auto uniform = [&mt](float lo, float hi) {
+		return std::uniform_real_distribution< float >(lo, hi)(mt);
+	};
+
+	uint32_t failures = 0;
+	for (uint32_t vertex_count : {1u << 20, 1u << 22, 1u << 24}) {
+		//meshes of random sizes (a few empty, a few large enough to be split into many chunks):
+		std::vector< Mesh > meshes;
+		for (uint32_t start = 0; start < vertex_count; ) {
+			uint32_t count = std::min(vertex_count - start, uint32_t(mt() % (vertex_count / 8)));
+			if (mt() % 8 == 0) count = 0;
+			meshes.emplace_back();
+			meshes.back().vertex_start = start;
+			meshes.back().vertex_count = count;
+			start += count;
+		}
+
+		std::vector< char > data(vertex_count * stride);
+		for (uint32_t m = 0; m < meshes.size(); ++m) {
+			bool zeros = (m % 2 == 1);
+			for (uint32_t v = meshes[m].vertex_start; v < meshes[m].vertex_start + meshes[m].vertex_count; ++v) {
+				float vertex[9];
+				for (uint32_t c = 0; c < 9; ++c) {
+					vertex[c] = uniform(-100.0f, 100.0f);
+				}
+				if (zeros) {
+					//(nothing below zero, so the minimum is whichever signed zero comes first)
+					for (uint32_t c = 0; c < 3; ++c) {
+						vertex[c] = std::abs(vertex[c]);
+						if (mt() % 64 == 0) vertex[c] = (mt() % 2 ? -0.0f : 0.0f);
+					}
+				}
+				if (mt() % 1024 == 0) vertex[mt() % 3] = std::numeric_limits< float >::quiet_NaN();
+				vertex[3] = std::numeric_limits< float >::quiet_NaN(); //(the float after the position is loaded but ignored)
+				std::memcpy(&data[v * stride], vertex, sizeof(vertex));
+			}
+		}
+
+		auto best_ms = [&](auto const &f) {
+			double best = std::numeric_limits< double >::infinity();
+			for (uint32_t r = 0; r < repeats; ++r) {
+				auto before = std::chrono::high_resolution_clock::now();
+				f();
+				auto after = std::chrono::high_resolution_clock::now();
+				best = std::min(best, std::chrono::duration< double, std::milli >(after - before).count());
+			}
+			return best;
+		};
+
+		std::vector< Mesh > expected;
+		double serial_ms = best_ms([&](){
+			expected = meshes;
+			for (auto &mesh : expected) {
+				for (uint32_t v = mesh.vertex_start; v < mesh.vertex_start + mesh.vertex_count; ++v) {
+					glm::vec3 position;
+					std::memcpy(&position, &data[v * stride], sizeof(position));
+					mesh.min = glm::min(mesh.min, position);
+					mesh.max = glm::max(mesh.max, position);
+				}
+			}
+		});
+
+		std::vector< Mesh > result;
+		double parallel_ms = best_ms([&](){
+			result = meshes;
+			compute_mesh_bounds(data.data(), stride, &result);
+		});
+
+		uint32_t mismatched = 0;
+		for (uint32_t m = 0; m < meshes.size(); ++m) {
+			if (std::memcmp(&result[m].min, &expected[m].min, sizeof(glm::vec3)) != 0
+			 || std::memcmp(&result[m].max, &expected[m].max, sizeof(glm::vec3)) != 0) {
+				++mismatched;
+			}
+		}
+		if (mismatched) {
+			std::cout << "  FAILED: " << vertex_count << " vertices: " << mismatched << " of " << meshes.size() << " meshes have bounds that differ from the serial pass." << std::endl;
+			++failures;
+		}
+
+		std::cout << std::fixed << std::setprecision(2)
+		          << std::setw(10) << vertex_count << std::setw(8) << meshes.size() << std::setw(10) << serial_ms
+		          << std::setw(22) << parallel_ms << std::setw(9) << serial_ms / parallel_ms << "x" << std::endl;
+	}
+
+	if (failures) {
+		std::cout << failures << " check(s) FAILED." << std::endl;
+		return 1;
+	}
+	std::cout << "Bounds are bit-identical to the serial pass." << std::endl;
+	return 0;
+}
@@ -0,0 +1,160 @@
+//bench-bvh times the BVH on 10k to 1M boxes -- SAH build, refit after every box moves, frustum queries, and raycasts --
+// against brute force (Frustum::cull over every box, and a slab test of every box for each ray),
+// and checks that both find the same things.
+//
+//Usage:
+// bench-bvh [rays]
+//
+//Boxes are random (from a fixed seed) and spread so that density is the same at every count;
+// the frustum is a 60-degree camera in the middle of the boxes (so it sees a small fraction of them, as in a game).
+//Returns non-zero if the BVH and brute force disagree.
+
+#include "BVH.hpp"
+#include "Frustum.hpp"
+#include "Scene.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	uint32_t ray_count = 200;
+	if (argc > 1) ray_count = uint32_t(std::stoul(argv[1]));
+
+	std::mt19937 mt(0xb0c5);
+	auto uniform = [&mt](float lo, float hi) {
+		return std::uniform_real_distribution< float >(lo, hi)(mt);
+	};
+	auto ms_since = [](auto before) {
+		return std::chrono::duration< double, std::milli >(std::chrono::high_resolution_clock::now() - before).count();
+	};
+	auto now = []() { return std::chrono::high_resolution_clock::now(); };
+
+	std::cout << "milliseconds (frustum: per query; rays: per " << ray_count << " rays):" << std::endl;
+	std::cout << std::setw(9) << "boxes" << std::setw(9) << "build" << std::setw(9) << "refit"
+	          << std::setw(11) << "visible" << std::setw(13) << "frustum bvh" << std::setw(13) << "frustum all"
+	          << std::setw(10) << "rays bvh" << std::setw(10) << "rays all" << std::endl;
+
+	uint32_t failures = 0;
+	for (size_t count : {10000, 100000, 1000000}) {
+		//boxes about 1 unit across, about one per 8 cubic units:
+		float half = 0.5f * std::cbrt(8.0f * float(count));
+		std::vector< glm::vec3 > centers(count), radii(count), mins(count), maxs(count);
+		for (size_t i = 0; i < count; ++i) {
+			centers[i] = glm::vec3(uniform(-half, half), uniform(-half, half), uniform(-half, half));
+			radii[i] = glm::vec3(uniform(0.1f, 0.9f), uniform(0.1f, 0.9f), uniform(0.1f, 0.9f));
+			mins[i] = centers[i] - radii[i];
+			maxs[i] = centers[i] + radii[i];
+		}
+
+		BVH bvh;
+		auto before = now();
+		bvh.build(count, mins.data(), maxs.data());
+		double build_ms = ms_since(before);
+
+		//everything moves a little (as in a frame of a game), then refit:
+		for (size_t i = 0; i < count; ++i) {
+			centers[i] += glm::vec3(uniform(-0.1f, 0.1f), uniform(-0.1f, 0.1f), uniform(-0.1f, 0.1f));
+			mins[i] = centers[i] - radii[i];
+			maxs[i] = centers[i] + radii[i];
+		}
+		before = now();
+		bvh.refit(mins.data(), maxs.data());
+		double refit_ms = ms_since(before);
+
+		//camera in the middle, looking down -z:
+		Scene::Transform camera_transform;
+		Scene::Camera camera(&camera_transform);
+		camera.fovy = 60.0f / 180.0f * 3.1415926f;
+		camera.aspect = 16.0f / 9.0f;
+		camera.near = 0.1f;
+		Frustum frustum(camera.make_projection() * glm::mat4(camera_transform.make_world_to_local()));
+
+		std::vector< uint32_t > found;
+		double frustum_bvh_ms = std::numeric_limits< double >::infinity();
+		for (uint32_t r = 0; r < 5; ++r) {
+			found.clear();
+			before = now();
+			bvh.query(frustum, &found);
+			frustum_bvh_ms = std::min(frustum_bvh_ms, ms_since(before));
+		}
+		std::vector< uint8_t > visible(count);
+		double frustum_all_ms = std::numeric_limits< double >::infinity();
+		for (uint32_t r = 0; r < 5; ++r) {
+			before = now();
+			frustum.cull(count, centers.data(), radii.data(), visible.data());
+			frustum_all_ms = std::min(frustum_all_ms, ms_since(before));
+		}
+		std::vector< uint32_t > expected;
+		for (uint32_t i = 0; i < count; ++i) {
+			if (visible[i]) expected.emplace_back(i);
+		}
+		std::sort(found.begin(), found.end());
+		if (found != expected) {
+			std::cout << "  FAILED: " << count << " boxes: BVH found " << found.size() << " boxes in the frustum, brute force found " << expected.size() << std::endl;
+			++failures;
+		}
+
+		//rays from random points inside, in random directions:
+		std::vector< glm::vec3 > origins(ray_count), directions(ray_count);
+		for (uint32_t r = 0; r < ray_count; ++r) {
+			origins[r] = glm::vec3(uniform(-half, half), uniform(-half, half), uniform(-half, half));
+			directions[r] = glm::normalize(glm::vec3(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f)));
+		}
+		float const max_t = 4.0f * half;
+		std::vector< float > bvh_t(ray_count, -1.0f), all_t(ray_count, -1.0f);
+		before = now();
+		for (uint32_t r = 0; r < ray_count; ++r) {
+			uint32_t item;
+			float t;
+			if (bvh.raycast(origins[r], directions[r], max_t, &item, &t)) bvh_t[r] = t;
+		}
+		double rays_bvh_ms = ms_since(before);
+
+		before = now();
+		for (uint32_t r = 0; r < ray_count; ++r) {
+			glm::vec3 inv = 1.0f / directions[r];
+			float best = std::numeric_limits< float >::infinity();
+			for (size_t i = 0; i < count; ++i) {
+				glm::vec3 t0 = (mins[i] - origins[r]) * inv;
+				glm::vec3 t1 = (maxs[i] - origins[r]) * inv;
+				glm::vec3 lo = glm::min(t0, t1), hi = glm::max(t0, t1);
+				float enter = std::max({ lo.x, lo.y, lo.z, 0.0f });
+				float exit = std::min({ hi.x, hi.y, hi.z, max_t });
+				if (enter <= exit && enter < best) best = enter;
+			}
+			if (best != std::numeric_limits< float >::infinity()) all_t[r] = best;
+		}
+		double rays_all_ms = ms_since(before);
+
+		uint32_t mismatched = 0;
+		for (uint32_t r = 0; r < ray_count; ++r) {
+			if (std::abs(bvh_t[r] - all_t[r]) > 1e-4f * (1.0f + all_t[r])) ++mismatched;
+		}
+		if (mismatched) {
+			std::cout << "  FAILED: " << count << " boxes: " << mismatched << " of " << ray_count << " rays hit at a different distance than brute force" << std::endl;
+			++failures;
+		}
+
+		std::cout << std::fixed << std::setprecision(2)
+		          << std::setw(9) << count << std::setw(9) << build_ms << std::setw(9) << refit_ms
+		          << std::setw(11) << found.size() << std::setw(13) << frustum_bvh_ms << std::setw(13) << frustum_all_ms
+		          << std::setw(10) << rays_bvh_ms << std::setw(10) << rays_all_ms
+		          << (bvh.should_rebuild() ? "  (refit tree should be rebuilt)" : "") << std::endl;
+	}
+
+	if (failures) {
+		std::cout << failures << " check(s) FAILED." << std::endl;
+		return 1;
+	}
+	std::cout << "BVH results match brute force." << std::endl;
+	return 0;
+}
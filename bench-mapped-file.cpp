@@ -0,0 +1,240 @@
+//bench-mapped-file compares two ways of loading a large .pnct mesh file, in wall time and memory:
+// - "ifstream": the old MeshBuffer path -- read_chunk() every chunk from a std::ifstream into std::vectors
+// - "mapped": the current MeshBuffer path -- MappedFile + find_chunk(), using the vertex data in place
+//Both then compute per-mesh bounds and read every vertex byte once (standing in for glBufferData, which needs GL),
+// with the file's pages either evicted from the page cache first ("cold") or already cached ("warm").
+//
+//Usage:
+// bench-mapped-file [megabytes] [file]
+//
+//Writes a synthetic file of the given size (default 512 MB) to [file] (default bench-mapped-file.pnct) and removes it after.
+//Each load runs in its own (forked) process, so peak memory is per-method:
+// - "peak RSS": the most memory the process ever had resident
+// - "private": memory only this process can use (e.g. a std::vector copy of the file), measured after loading
+// - "file-backed": file pages mapped by the process, which are shared with the OS page cache rather than copies
+//Linux only (uses fork, posix_fadvise, and /proc/self/status).
+
+#include "MappedFile.hpp"
+#include "read_write_chunk.hpp"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+//same layout as MeshBuffer's .pnct vertex:
+struct Vertex {
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::u8vec4 Color;
+	glm::vec2 TexCoord;
+};
+static_assert(sizeof(Vertex) == 3*4+3*4+4*1+2*4, "Vertex is packed.");
+
+struct IndexEntry {
+	uint32_t name_begin, name_end;
+	uint32_t vertex_begin, vertex_end;
+};
+static_assert(sizeof(IndexEntry) == 16, "Index entry should be packed");
+
+#if defined(__linux__)
+
+//read a "Name:   1234 kB" line from /proc/self/status, in megabytes:
+static double status_mb(char const *name) {
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		if (line.compare(0, std::strlen(name), name) == 0 && line[std::strlen(name)] == ':') {
+			return std::stod(line.substr(std::strlen(name) + 1)) / 1024.0;
+		}
+	}
+	return 0.0;
+}
+
+//per-mesh bounds plus a sum of every vertex word (so every byte is read, as an upload would):
+static uint32_t touch(char const *data, size_t vertex_count, std::vector< IndexEntry > const &index, glm::vec3 *min_, glm::vec3 *max_) {
+	glm::vec3 &min = *min_;
+	glm::vec3 &max = *max_;
+	for (auto const &entry : index) {
+		for (uint32_t v = entry.vertex_begin; v < entry.vertex_end; ++v) {
+			glm::vec3 position;
+			std::memcpy(&position, data + v * sizeof(Vertex) + offsetof(Vertex, Position), sizeof(position));
+			min = glm::min(min, position);
+			max = glm::max(max, position);
+		}
+	}
+	uint32_t sum = 0;
+	for (size_t i = 0; i + 4 <= vertex_count * sizeof(Vertex); i += 4) {
+		uint32_t word;
+		std::memcpy(&word, data + i, 4);
+		sum += word;
+	}
+	return sum;
+}
+
+#endif
+
+int main(int argc, char **argv) {
+	#if !defined(__linux__)
+	(void)argc; (void)argv;
+	std::cout << "bench-mapped-file only runs on Linux." << std::endl;
+	return 0;
+	#else
+	size_t megabytes = 512;
+	std::string filename = "bench-mapped-file.pnct";
+	if (argc > 1) megabytes = std::stoul(argv[1]);
+	if (argc > 2) filename = argv[2];
+
+	//write a file shaped like a scene export -- one big vertex chunk, then names, then an index of meshes:
+	uint32_t const mesh_count = 1000;
+	size_t vertex_count = megabytes * 1024 * 1024 / sizeof(Vertex);
+	if (vertex_count * sizeof(Vertex) > std::numeric_limits< uint32_t >::max()) {
+		std::cerr << "Chunk sizes are 32 bits, so the file can be at most 4095 megabytes." << std::endl;
+		return 1;
+	}
+	{
+		std::ofstream out(filename, std::ios::binary);
+		auto header = [&](char const *magic, size_t size) {
+			uint32_t size32 = uint32_t(size);
+			out.write(magic, 4);
+			out.write(reinterpret_cast< char const * >(&size32), 4);
+		};
+		header("pnct", vertex_count * sizeof(Vertex));
+		std::vector< Vertex > block(65536);
+		for (size_t begin = 0; begin < vertex_count; begin += block.size()) {
+			size_t count = std::min(block.size(), vertex_count - begin);
+			for (size_t i = 0; i < count; ++i) {
+				float f = float(begin + i);
+				block[i].Position = glm::vec3(std::sin(f), std::cos(f), 0.001f * f);
+				block[i].Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+				block[i].Color = glm::u8vec4(0xff);
+				block[i].TexCoord = glm::vec2(0.0f);
+			}
+			out.write(reinterpret_cast< char const * >(block.data()), count * sizeof(Vertex));
+		}
+		std::string strings;
+		std::vector< IndexEntry > index;
+		for (uint32_t m = 0; m < mesh_count; ++m) {
+			IndexEntry entry;
+			entry.name_begin = uint32_t(strings.size());
+			strings += "Mesh." + std::to_string(m);
+			entry.name_end = uint32_t(strings.size());
+			entry.vertex_begin = uint32_t(vertex_count * m / mesh_count);
+			entry.vertex_end = uint32_t(vertex_count * (m + 1) / mesh_count);
+			index.emplace_back(entry);
+		}
+		header("str0", strings.size());
+		out.write(strings.data(), strings.size());
+		header("idx0", index.size() * sizeof(IndexEntry));
+		out.write(reinterpret_cast< char const * >(index.data()), index.size() * sizeof(IndexEntry));
+		if (!out) {
+			std::cerr << "Failed to write '" << filename << "'." << std::endl;
+			return 1;
+		}
+	}
+
+	//ask the OS to drop the file's pages from its cache (so the next load reads from disk):
+	auto evict = [&]() {
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd == -1) return;
+		fdatasync(fd);
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	};
+
+	//load the file either way, calling 'measure' while the loaded data is still alive (returns touch()'s sum):
+	auto load = [&](bool mapped, glm::vec3 *min, glm::vec3 *max, std::function< void() > const &measure) {
+		uint32_t sum;
+		if (mapped) {
+			MappedFile file(filename);
+			char const *at = file.data;
+			char const *end = file.data + file.size;
+			size_t count = 0;
+			char const *data = find_chunk< Vertex >(&at, end, "pnct", &count);
+			size_t strings_size = 0;
+			find_chunk< char >(&at, end, "str0", &strings_size);
+			std::vector< IndexEntry > index;
+			read_chunk(&at, end, "idx0", &index);
+			sum = touch(data, count, index, min, max);
+			measure();
+		} else {
+			std::ifstream file(filename, std::ios::binary);
+			std::vector< Vertex > data;
+			read_chunk(file, "pnct", &data);
+			std::vector< char > strings;
+			read_chunk(file, "str0", &strings);
+			std::vector< IndexEntry > index;
+			read_chunk(file, "idx0", &index);
+			sum = touch(reinterpret_cast< char const * >(data.data()), data.size(), index, min, max);
+			measure();
+		}
+		return sum;
+	};
+
+	std::cout << megabytes << " MB file, " << vertex_count << " vertices in " << mesh_count << " meshes:" << std::endl;
+	std::cout << std::setw(10) << "method" << std::setw(7) << "cache" << std::setw(10) << "ms"
+	          << std::setw(14) << "peak RSS MB" << std::setw(12) << "private MB" << std::setw(16) << "file-backed MB" << std::endl;
+
+	bool failed = false;
+	for (bool cold : {true, false}) {
+		for (bool mapped : {false, true}) {
+			if (cold) {
+				evict();
+			} else {
+				glm::vec3 min = glm::vec3(0.0f), max = glm::vec3(0.0f);
+				load(mapped, &min, &max, [](){});
+			}
+
+			std::cout.flush();
+			pid_t child = fork();
+			if (child == 0) {
+				glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+				glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
+				double private_mb = 0.0, file_mb = 0.0;
+				uint32_t sum = 0; //(printed below so reads aren't optimized away)
+				auto before = std::chrono::high_resolution_clock::now();
+				//(reading /proc/self/status inside the timed part takes a few microseconds)
+				auto measure = [&]() { private_mb = status_mb("RssAnon"); file_mb = status_mb("RssFile"); };
+				try {
+					sum = load(mapped, &min, &max, measure);
+				} catch (std::exception &e) {
+					std::cerr << "  FAILED: " << e.what() << std::endl;
+					_exit(1);
+				}
+				double ms = std::chrono::duration< double, std::milli >(std::chrono::high_resolution_clock::now() - before).count();
+				std::cout << std::fixed << std::setprecision(1)
+				          << std::setw(10) << (mapped ? "mapped" : "ifstream") << std::setw(7) << (cold ? "cold" : "warm") << std::setw(10) << ms
+				          << std::setw(14) << status_mb("VmHWM") << std::setw(12) << private_mb << std::setw(16) << file_mb
+				          << (min.z == 0.0f && max.z > 0.0f ? "" : "  (wrong bounds!)") << (sum == 12345 ? " " : "") << std::endl;
+				_exit(min.z == 0.0f && max.z > 0.0f ? 0 : 1);
+			}
+			int status = 0;
+			if (child == -1 || waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				failed = true;
+			}
+		}
+	}
+
+	std::remove(filename.c_str());
+
+	if (failed) {
+		std::cout << "FAILED: a load failed or found the wrong bounds." << std::endl;
+		return 1;
+	}
+	return 0;
+	#endif
+}
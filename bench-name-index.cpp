@@ -0,0 +1,227 @@
+//bench-name-index times loading a scene with many named transforms and looking transforms up by name,
+// through Scene's name index vs scanning Scene::transforms (as lookups were done before the index), and
+// measures the heap used by the loaded scene and by the index:
+// - "exact": find_transform(name) for names picked at random
+// - "prefix" / "suffix" / "contains": find_transforms_with_prefix / _with_suffix / _containing
+//   (the first prefix and suffix queries also build the index's sorted orders; they are timed separately)
+//
+//Usage:
+// bench-name-index [transforms] [file]
+//
+//Writes a synthetic .scene (default 150000 transforms, with names of 17-28 characters in the style of the game's
+// "Object.012_plane" / "Object.012_planeCollider") to [file] (default bench-name-index.scene) and removes it after.
+//Heap use is counted through the global operator new.
+
+#include "Scene.hpp"
+#include "read_write_chunk.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+//count bytes still in use through the global operator new:
+// (each block is prefixed with its size, so that unsized deletes can be counted too)
+static std::atomic< int64_t > in_use(0);
+
+static void *counted_new(std::size_t size) {
+	in_use += int64_t(size);
+	if (void *ptr = std::malloc(size + 16)) {
+		*reinterpret_cast< std::size_t * >(ptr) = size;
+		return reinterpret_cast< char * >(ptr) + 16;
+	}
+	throw std::bad_alloc();
+}
+static void counted_delete(void *ptr) {
+	if (!ptr) return;
+	void *block = reinterpret_cast< char * >(ptr) - 16;
+	in_use -= int64_t(*reinterpret_cast< std::size_t * >(block));
+	std::free(block);
+}
+
+void *operator new(std::size_t size) { return counted_new(size); }
+void *operator new[](std::size_t size) { return counted_new(size); }
+void operator delete(void *ptr) noexcept { counted_delete(ptr); }
+void operator delete[](void *ptr) noexcept { counted_delete(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { counted_delete(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { counted_delete(ptr); }
+
+//same layout as Scene::load's transform entries:
+struct HierarchyEntry {
+	uint32_t parent;
+	uint32_t name_begin;
+	uint32_t name_end;
+	glm::vec3 position;
+	glm::quat rotation;
+	glm::vec3 scale;
+};
+static_assert(sizeof(HierarchyEntry) == 4 + 4 + 4 + 4*3 + 4*4 + 4*3, "HierarchyEntry is packed.");
+
+int main(int argc, char **argv) {
+	uint32_t count = 150000;
+	std::string filename = "bench-name-index.scene";
+	if (argc > 1) count = uint32_t(std::stoul(argv[1]));
+	if (argc > 2) filename = argv[2];
+
+	std::mt19937 mt(0x4a3e);
+	auto pick = [&mt](size_t n) {
+		return size_t(std::uniform_int_distribution< size_t >(0, n - 1)(mt));
+	};
+
+	//--- write the scene: objects with colliders as children ---
+	char const *kinds[] = { "_plane", "_coin", "_cloud", "_tree", "_rock", "_balloon" };
+	std::vector< std::string > names;
+	{
+		std::vector< char > strings;
+		std::vector< HierarchyEntry > hierarchy;
+		for (uint32_t i = 0; i < count; ++i) {
+			HierarchyEntry h;
+			h.parent = -1U;
+			std::string name;
+			if (i % 2 == 0) {
+				name = "Object" + std::to_string(100000 + i / 2) + kinds[pick(6)];
+			} else {
+				//(collider of the previous object)
+				h.parent = i - 1;
+				name = names.back() + "Collider";
+			}
+			h.name_begin = uint32_t(strings.size());
+			strings.insert(strings.end(), name.begin(), name.end());
+			h.name_end = uint32_t(strings.size());
+			h.position = glm::vec3(0.0f);
+			h.rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+			h.scale = glm::vec3(1.0f);
+			hierarchy.emplace_back(h);
+			names.emplace_back(name);
+		}
+		std::ofstream out(filename, std::ios::binary);
+		write_chunk("str0", strings, &out);
+		write_chunk("xfh0", hierarchy, &out);
+		write_chunk("msh0", std::vector< uint32_t >(), &out);
+		write_chunk("cam0", std::vector< uint32_t >(), &out);
+		write_chunk("lmp0", std::vector< uint32_t >(), &out);
+		if (!out) {
+			std::cerr << "Failed to write '" << filename << "'." << std::endl;
+			return 1;
+		}
+	}
+
+	auto time = [](auto const &f) {
+		auto before = std::chrono::high_resolution_clock::now();
+		f();
+		auto after = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration< double, std::milli >(after - before).count();
+	};
+	auto mb = [](int64_t bytes) {
+		return bytes / (1024.0 * 1024.0);
+	};
+
+	//--- load ---
+	int64_t in_use_before = in_use;
+	Scene scene;
+	double load_ms = time([&](){
+		scene.load(filename, [](Scene &, Scene::Transform *, std::string const &){ });
+	});
+	int64_t scene_bytes = in_use - in_use_before;
+	std::remove(filename.c_str());
+
+	//--- build the index ---
+	in_use_before = in_use;
+	double index_ms = time([&](){ scene.update_name_index(); });
+	int64_t index_bytes = in_use - in_use_before;
+
+	auto shortest = std::min_element(names.begin(), names.end(), [](std::string const &a, std::string const &b){ return a.size() < b.size(); });
+	auto longest = std::max_element(names.begin(), names.end(), [](std::string const &a, std::string const &b){ return a.size() < b.size(); });
+	std::cout << count << " transforms (names of " << shortest->size() << "-" << longest->size() << " characters):" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "  load " << load_ms << " ms, " << mb(scene_bytes) << " MB of heap" << std::endl;
+	std::cout << "  update_name_index " << index_ms << " ms, " << mb(index_bytes) << " MB of heap" << std::endl;
+
+	//--- lookups ---
+	std::cout << std::setw(12) << "query" << std::setw(10) << "queries" << std::setw(12) << "found" << std::setw(12) << "scan ms" << std::setw(12) << "index ms" << std::endl;
+	size_t sum = 0; //(so results aren't optimized away)
+	auto report = [&](char const *query, size_t queries, size_t found, double scan_ms, double index_ms) {
+		std::cout << std::setw(12) << query << std::setw(10) << queries << std::setw(12) << found << std::setw(12) << scan_ms << std::setw(12) << index_ms
+		          << (sum == 12345 ? " " : "") << std::endl;
+	};
+
+	{ //exact:
+		std::vector< std::string > queries;
+		for (uint32_t i = 0; i < 1000; ++i) queries.emplace_back(names[pick(names.size())]);
+		size_t found = 0;
+		double scan_ms = time([&](){
+			for (auto const &q : queries) {
+				for (auto &t : scene.transforms) {
+					if (t.name == q) { sum += size_t(&t); ++found; break; }
+				}
+			}
+		});
+		double index_ms = time([&](){
+			for (auto const &q : queries) sum += size_t(scene.find_transform(q));
+		});
+		report("exact", queries.size(), found, scan_ms, index_ms);
+	}
+
+	//prefix / suffix / contains, each with a few queries of different selectivity:
+	auto run = [&](char const *query, std::vector< std::string > const &queries, auto const &matches, auto const &find) {
+		std::vector< Scene::Transform * > out;
+		size_t found = 0;
+		double scan_ms = time([&](){
+			for (auto const &q : queries) {
+				out.clear();
+				for (auto &t : scene.transforms) {
+					if (matches(t.name, q)) out.emplace_back(&t);
+				}
+				found += out.size();
+				sum += out.size();
+			}
+		});
+		double index_ms = time([&](){
+			for (auto const &q : queries) {
+				out.clear();
+				find(q, &out);
+				sum += out.size();
+			}
+		});
+		report(query, queries.size(), found, scan_ms, index_ms);
+	};
+	auto starts_with = [](std::string_view name, std::string_view s) {
+		return name.size() >= s.size() && name.substr(0, s.size()) == s;
+	};
+	auto ends_with = [](std::string_view name, std::string_view s) {
+		return name.size() >= s.size() && name.substr(name.size() - s.size()) == s;
+	};
+	auto contains = [](std::string_view name, std::string_view s) {
+		return name.find(s) != std::string_view::npos;
+	};
+
+	std::vector< std::string > prefixes = { "Object1000", "Object1234", "Object12", "Object170001_coin" };
+	std::vector< std::string > suffixes = { "_plane", "_coinCollider", "Collider", "7_rock" };
+	std::vector< std::string > substrings = { "_plane", "_coin", "Collider", "2345" };
+
+	{ //the first prefix and suffix queries also build the sorted orders:
+		std::vector< Scene::Transform * > out;
+		in_use_before = in_use;
+		double prefix_ms = time([&](){ scene.find_transforms_with_prefix(prefixes[0], &out); });
+		double suffix_ms = time([&](){ scene.find_transforms_with_suffix(suffixes[0], &out); });
+		std::cout << "  first prefix query " << prefix_ms << " ms, first suffix query " << suffix_ms << " ms (building sorted orders: " << mb(in_use - in_use_before) << " MB of heap)" << std::endl;
+		sum += out.size();
+	}
+
+	run("prefix", prefixes, starts_with, [&](std::string_view q, std::vector< Scene::Transform * > *out){ scene.find_transforms_with_prefix(q, out); });
+	run("suffix", suffixes, ends_with, [&](std::string_view q, std::vector< Scene::Transform * > *out){ scene.find_transforms_with_suffix(q, out); });
+	run("contains", substrings, contains, [&](std::string_view q, std::vector< Scene::Transform * > *out){ scene.find_transforms_containing(q, out); });
+
+	return 0;
+}
@@ -0,0 +1,226 @@
+//bench-pack compares three ways of shipping the same assets, in wall time and memory:
+// - "loose": every file on its own, opened (and mapped) one at a time by MappedFile
+// - "stored": one pack (see Pack.hpp) of the files as-is, mounted, so files are used in place from one mapping
+// - "deflated": one pack with the files compressed (as pack-assets --deflate makes), inflated as they're opened
+//Two sets of assets are loaded each way:
+// - "small": many small text-like files, each read in full through MappedFile
+// - "game": dist/bird.pnct and dist/bird.scene, loaded as the game does (MeshBuffer -- without uploading -- and Scene::load)
+//with the files' pages either evicted from the page cache first ("cold") or already cached ("warm").
+//
+//Usage:
+// bench-pack [small files] [directory]
+//
+//Writes the small files (default 2000, of 1-16 KB each) and copies of the game assets into [directory]
+// (default bench-pack.dir), packs them both ways next to it, and removes everything after.
+//Each load runs in its own (forked) process, so that packs mounted for one method don't affect the next, and
+// peak memory is per-method. Linux only (uses fork, posix_fadvise, and /proc/self/status).
+
+#include "Pack.hpp"
+#include "MappedFile.hpp"
+#include "Mesh.hpp"
+#include "Scene.hpp"
+#include "data_path.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+
+//read a "Name:   1234 kB" line from /proc/self/status, in megabytes:
+static double status_mb(char const *name) {
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		if (line.compare(0, std::strlen(name), name) == 0 && line[std::strlen(name)] == ':') {
+			return std::stod(line.substr(std::strlen(name) + 1)) / 1024.0;
+		}
+	}
+	return 0.0;
+}
+
+static std::vector< char > read_file(std::string const &filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) throw std::runtime_error("failed to open '" + filename + "'.");
+	return std::vector< char >((std::istreambuf_iterator< char >(file)), std::istreambuf_iterator< char >());
+}
+
+static void write_file(std::string const &filename, std::vector< char > const &data) {
+	std::ofstream out(filename, std::ios::binary);
+	out.write(data.data(), std::streamsize(data.size()));
+	if (!out) throw std::runtime_error("failed to write '" + filename + "'.");
+}
+
+#endif
+
+int main(int argc, char **argv) {
+	#if !defined(__linux__)
+	(void)argc; (void)argv;
+	std::cout << "bench-pack only runs on Linux." << std::endl;
+	return 0;
+	#else
+	uint32_t small_count = 2000;
+	std::string directory = "bench-pack.dir";
+	if (argc > 1) small_count = uint32_t(std::stoul(argv[1]));
+	if (argc > 2) directory = argv[2];
+	std::string const stored_pack = directory + ".stored.pack";
+	std::string const deflated_pack = directory + ".deflated.pack";
+
+	//--- write the assets, loose and packed ---
+	std::vector< std::string > small_names;
+	std::vector< std::string > const game_names = { "bird.pnct", "bird.scene" };
+	size_t small_bytes = 0, game_bytes = 0;
+	try {
+		if (mkdir(directory.c_str(), 0777) != 0 || mkdir((directory + "/small").c_str(), 0777) != 0) {
+			throw std::runtime_error("failed to make directory '" + directory + "/small' (does it already exist?).");
+		}
+
+		std::vector< std::pair< std::string, std::vector< char > > > files;
+
+		//small files are sentences made of a few hundred words (so they deflate about as well as text or json):
+		std::mt19937 mt(0x9ac4);
+		std::vector< std::string > words;
+		for (uint32_t w = 0; w < 300; ++w) {
+			std::string word;
+			for (uint32_t l = 3 + mt() % 6; l > 0; --l) word += char('a' + mt() % 26);
+			words.emplace_back(word);
+		}
+		for (uint32_t i = 0; i < small_count; ++i) {
+			char name[32];
+			std::snprintf(name, sizeof(name), "small/%05u.txt", i);
+			size_t size = 1024 + mt() % (15 * 1024);
+			std::vector< char > contents;
+			while (contents.size() < size) {
+				std::string const &word = words[mt() % words.size()];
+				contents.insert(contents.end(), word.begin(), word.end());
+				contents.emplace_back(mt() % 12 == 0 ? '\n' : ' ');
+			}
+			small_bytes += contents.size();
+			small_names.emplace_back(name);
+			files.emplace_back(name, std::move(contents));
+		}
+		for (auto const &name : game_names) {
+			std::vector< char > contents = read_file(data_path("../dist/" + name));
+			game_bytes += contents.size();
+			files.emplace_back(name, std::move(contents));
+		}
+
+		for (auto const &[name, contents] : files) {
+			write_file(directory + "/" + name, contents);
+		}
+		write_file(stored_pack, Pack::build(files, false));
+		write_file(deflated_pack, Pack::build(std::move(files), true));
+	} catch (std::exception &e) {
+		std::cerr << "Failed to write assets: " << e.what() << std::endl;
+		return 1;
+	}
+
+	//every file a load may read (for evicting them from the page cache):
+	std::vector< std::string > all_files = { stored_pack, deflated_pack };
+	for (auto const &name : small_names) all_files.emplace_back(directory + "/" + name);
+	for (auto const &name : game_names) all_files.emplace_back(directory + "/" + name);
+
+	//ask the OS to drop the files' pages from its cache (so the next load reads from disk):
+	auto evict = [&]() {
+		for (auto const &filename : all_files) {
+			int fd = open(filename.c_str(), O_RDONLY);
+			if (fd == -1) continue;
+			fdatasync(fd);
+			posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			close(fd);
+		}
+	};
+
+	auto file_mb = [](std::string const &filename) {
+		MappedFile file(filename);
+		return file.size / (1024.0 * 1024.0);
+	};
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << small_count << " small files (" << small_bytes / (1024.0 * 1024.0) << " MB) + game assets (" << game_bytes / (1024.0 * 1024.0) << " MB); "
+	          << "stored pack " << file_mb(stored_pack) << " MB, deflated pack " << file_mb(deflated_pack) << " MB:" << std::endl;
+	std::cout << std::setw(10) << "method" << std::setw(7) << "cache" << std::setw(10) << "mount ms" << std::setw(10) << "small ms" << std::setw(10) << "game ms"
+	          << std::setw(14) << "peak RSS MB" << std::endl;
+
+	char const *methods[] = { "loose", "stored", "deflated" };
+	std::string const packs[] = { "", stored_pack, deflated_pack };
+
+	bool failed = false;
+	for (bool cold : {true, false}) {
+		for (uint32_t m = 0; m < 3; ++m) {
+			if (cold) evict();
+
+			std::cout.flush();
+			pid_t child = fork();
+			if (child == 0) {
+				double mount_ms = 0.0, small_ms = 0.0, game_ms = 0.0;
+				uint32_t sum = 0; //(printed below so reads aren't optimized away)
+				size_t drawables = 0;
+				auto since = [](auto before) {
+					return std::chrono::duration< double, std::milli >(std::chrono::high_resolution_clock::now() - before).count();
+				};
+				try {
+					auto before = std::chrono::high_resolution_clock::now();
+					if (packs[m] != "") Pack::mount(packs[m], directory + "/");
+					mount_ms = since(before);
+
+					before = std::chrono::high_resolution_clock::now();
+					for (auto const &name : small_names) {
+						MappedFile file(directory + "/" + name);
+						for (size_t i = 0; i < file.size; ++i) sum += uint8_t(file.data[i]);
+					}
+					small_ms = since(before);
+
+					before = std::chrono::high_resolution_clock::now();
+					MeshBuffer meshes(directory + "/bird.pnct", MeshBuffer::DeferUpload);
+					Scene scene;
+					scene.load(directory + "/bird.scene", [&](Scene &scene, Scene::Transform *transform, std::string const &mesh_name){
+						Mesh const &mesh = meshes.lookup(mesh_name);
+						scene.drawables.emplace_back(transform);
+						scene.drawables.back().min = mesh.min;
+						scene.drawables.back().max = mesh.max;
+					});
+					game_ms = since(before);
+					drawables = scene.drawables.size();
+				} catch (std::exception &e) {
+					std::cerr << "  FAILED: " << e.what() << std::endl;
+					_exit(1);
+				}
+				std::cout << std::setw(10) << methods[m] << std::setw(7) << (cold ? "cold" : "warm") << std::setw(10) << mount_ms << std::setw(10) << small_ms << std::setw(10) << game_ms
+				          << std::setw(14) << status_mb("VmHWM")
+				          << (drawables > 0 ? "" : "  (no drawables!)") << (sum == 12345 ? " " : "") << std::endl;
+				_exit(drawables > 0 ? 0 : 1);
+			}
+			int status = 0;
+			if (child == -1 || waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				failed = true;
+			}
+		}
+	}
+
+	for (auto const &filename : all_files) std::remove(filename.c_str());
+	std::remove((directory + "/small").c_str());
+	std::remove(directory.c_str());
+
+	if (failed) {
+		std::cout << "FAILED: a load failed." << std::endl;
+		return 1;
+	}
+	return 0;
+	#endif
+}
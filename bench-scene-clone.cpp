@@ -0,0 +1,210 @@
+//bench-scene-clone times (and measures the heap used by) the ways of getting a copy of a large scene:
+// - "hash map": the old Scene::set(), which mapped every transform pointer through a std::unordered_map
+//   (reproduced here as a reference)
+// - "set": Scene::set(), which copies by position through the source scene's CloneIndex
+//   (the first copy also builds that index; later copies reuse it)
+// - "share": Scene::share(), which uses the base scene's transforms and drawables in place,
+//   and "share + edits", which then edit()s a few transforms (copying them and their descendants)
+//Each is timed both into a fresh (empty) scene and into a scene that already holds a copy (as on a game restart).
+//
+//Usage:
+// bench-scene-clone [transforms] [repeats]
+//
+//Transforms are arranged as chains of 8, with a drawable on every other one. Times are the best of 'repeats'
+// runs; "allocated" counts every byte requested from the heap during a copy, "held" the bytes still in use after it.
+
+#include "Scene.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//count bytes allocated (and still in use) through the global operator new:
+// (each block is prefixed with its size, so that unsized deletes can be counted too)
+static std::atomic< uint64_t > allocated(0);
+static std::atomic< int64_t > in_use(0);
+
+static void *counted_new(std::size_t size) {
+	allocated += size;
+	in_use += int64_t(size);
+	if (void *ptr = std::malloc(size + 16)) {
+		*reinterpret_cast< std::size_t * >(ptr) = size;
+		return reinterpret_cast< char * >(ptr) + 16;
+	}
+	throw std::bad_alloc();
+}
+static void counted_delete(void *ptr) {
+	if (!ptr) return;
+	void *block = reinterpret_cast< char * >(ptr) - 16;
+	in_use -= int64_t(*reinterpret_cast< std::size_t * >(block));
+	std::free(block);
+}
+
+void *operator new(std::size_t size) { return counted_new(size); }
+void *operator new[](std::size_t size) { return counted_new(size); }
+void operator delete(void *ptr) noexcept { counted_delete(ptr); }
+void operator delete[](void *ptr) noexcept { counted_delete(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { counted_delete(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { counted_delete(ptr); }
+
+//Scene::set() as it was before CloneIndex: every pointer is remapped through a hash map:
+static void hash_map_set(Scene &scene, Scene const &other) {
+	std::unordered_map< Scene::Transform const *, Scene::Transform * > transform_to_transform;
+	transform_to_transform.insert(std::make_pair(nullptr, nullptr));
+
+	scene.transform_arrays.clear();
+	scene.clear_bvh();
+	scene.clear_name_index();
+	scene.name_table = other.name_table;
+	scene.transforms.clear();
+	for (auto const &t : other.transforms) {
+		scene.transforms.emplace_back();
+		scene.transforms.back().name = t.name;
+		scene.transforms.back().position = t.position;
+		scene.transforms.back().rotation = t.rotation;
+		scene.transforms.back().scale = t.scale;
+		scene.transforms.back().parent = t.parent; //will update later
+
+		auto ret = transform_to_transform.insert(std::make_pair(&t, &scene.transforms.back()));
+		assert(ret.second);
+	}
+	for (auto &t : scene.transforms) {
+		t.parent = transform_to_transform.at(t.parent);
+	}
+
+	scene.drawables = other.drawables;
+	for (auto &d : scene.drawables) {
+		d.transform = transform_to_transform.at(d.transform);
+	}
+	scene.cameras = other.cameras;
+	for (auto &c : scene.cameras) {
+		c.transform = transform_to_transform.at(c.transform);
+	}
+	scene.lights = other.lights;
+	for (auto &l : scene.lights) {
+		l.transform = transform_to_transform.at(l.transform);
+	}
+}
+
+int main(int argc, char **argv) {
+	uint32_t count = 200000;
+	uint32_t repeats = 7;
+	if (argc > 1) count = uint32_t(std::stoul(argv[1]));
+	if (argc > 2) repeats = uint32_t(std::stoul(argv[2]));
+
+	//--- build the scene to be copied ---
+	auto base = std::make_shared< Scene >();
+	{
+		std::mt19937 mt(0x5ce7e);
+		auto uniform = [&mt](float lo, float hi) {
+			return std::uniform_real_distribution< float >(lo, hi)(mt);
+		};
+		Scene::Transform *previous = nullptr;
+		for (uint32_t i = 0; i < count; ++i) {
+			base->transforms.emplace_back();
+			Scene::Transform *t = &base->transforms.back();
+			t->name = base->store_name("T" + std::to_string(i));
+			t->parent = (i % 8 == 0 ? nullptr : previous);
+			t->position = glm::vec3(uniform(-10.0f, 10.0f), uniform(-10.0f, 10.0f), uniform(-10.0f, 10.0f));
+			if (i % 2 == 1) {
+				base->drawables.emplace_back(t);
+				base->drawables.back().min = glm::vec3(-1.0f);
+				base->drawables.back().max = glm::vec3(1.0f);
+			}
+			if (i % (count / 4 + 1) == 0) {
+				base->cameras.emplace_back(t);
+				base->lights.emplace_back(t);
+			}
+			previous = t;
+		}
+		//(as share() asks, bring base's world matrices up to date before sharing it)
+		base->update_transforms();
+	}
+	Scene const &other = *base;
+
+	//transforms edited in the "share + edits" case (spread through the scene):
+	std::vector< Scene::Transform const * > to_edit;
+	{
+		uint32_t i = 0;
+		for (auto const &t : other.transforms) {
+			if (i++ % (count / 16 + 1) == 0) to_edit.emplace_back(&t);
+		}
+	}
+
+	std::cout << count << " transforms, " << other.drawables.size() << " drawables; best of " << repeats << ":" << std::endl;
+	std::cout << std::setw(24) << "copy" << std::setw(10) << "into" << std::setw(12) << "ms" << std::setw(16) << "allocated MB" << std::setw(12) << "held MB" << std::endl;
+
+	struct Result {
+		double ms = std::numeric_limits< double >::infinity();
+		uint64_t allocated = 0;
+		int64_t held = 0;
+	};
+	//time copy(scene) into either a fresh scene or one already holding a copy (made by copy() itself):
+	auto run = [&](auto const &copy, bool fresh) {
+		Result result;
+		for (uint32_t r = 0; r < repeats; ++r) {
+			auto scene = std::make_unique< Scene >();
+			if (!fresh) copy(*scene);
+
+			uint64_t allocated_before = allocated;
+			int64_t in_use_before = in_use;
+			auto before = std::chrono::high_resolution_clock::now();
+			copy(*scene);
+			auto after = std::chrono::high_resolution_clock::now();
+			result.ms = std::min(result.ms, std::chrono::duration< double, std::milli >(after - before).count());
+			result.allocated = allocated - allocated_before;
+			result.held = in_use - in_use_before;
+		}
+		return result;
+	};
+	auto report = [](char const *name, char const *into, Result const &result) {
+		std::cout << std::fixed << std::setprecision(2)
+		          << std::setw(24) << name << std::setw(10) << into << std::setw(12) << result.ms
+		          << std::setw(16) << result.allocated / (1024.0 * 1024.0) << std::setw(12) << result.held / (1024.0 * 1024.0) << std::endl;
+	};
+
+	auto hash_map = [&](Scene &scene) { hash_map_set(scene, other); };
+	auto set = [&](Scene &scene) { scene.set(other); };
+	auto share = [&](Scene &scene) { scene.share(base); };
+	auto share_edits = [&](Scene &scene) {
+		scene.share(base);
+		for (auto t : to_edit) scene.edit(t);
+	};
+
+	{ //the first set() from a scene also builds its CloneIndex:
+		Scene scene;
+		uint64_t allocated_before = allocated;
+		int64_t in_use_before = in_use;
+		auto before = std::chrono::high_resolution_clock::now();
+		scene.set(other);
+		auto after = std::chrono::high_resolution_clock::now();
+		Result first;
+		first.ms = std::chrono::duration< double, std::milli >(after - before).count();
+		first.allocated = allocated - allocated_before;
+		first.held = in_use - in_use_before;
+		report("set (builds index)", "fresh", first);
+	}
+
+	report("hash map", "fresh", run(hash_map, true));
+	report("hash map", "existing", run(hash_map, false));
+	report("set", "fresh", run(set, true));
+	report("set", "existing", run(set, false));
+	report("share", "fresh", run(share, true));
+	report("share", "existing", run(share, false));
+	report(("share + " + std::to_string(to_edit.size()) + " edits").c_str(), "fresh", run(share_edits, true));
+
+	return 0;
+}
@@ -0,0 +1,105 @@
+//bench-spawner times Spawner::update() on a large pool whose objects live only a few frames,
+// so hundreds of thousands of objects spawn and retire every (wall-clock) second,
+// and checks that nothing is allocated once the pool is filled.
+//
+//Usage:
+// bench-spawner [objects] [frames]
+//
+//Objects are attached to colliders (so spawning and retiring also toggles them) and use a fixed seed,
+// so runs are repeatable. Returns non-zero if any allocation happens after the warm-up frames.
+
+#include "Spawner.hpp"
+#include "Collision.hpp"
+#include "Scene.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+//count every allocation made through the global operator new:
+static std::atomic< uint64_t > allocations(0);
+
+void *operator new(std::size_t size) {
+	allocations += 1;
+	if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+	throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) {
+	allocations += 1;
+	if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+	throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+int main(int argc, char **argv) {
+	uint32_t count = 200000;
+	uint32_t frames = 600;
+	if (argc > 1) count = uint32_t(std::stoul(argv[1]));
+	if (argc > 2) frames = uint32_t(std::stoul(argv[2]));
+	uint32_t const warm_up = 60;
+
+	//objects cross the live box in 4-12 frames and wait 0-6 frames before spawning again:
+	Scene scene;
+	Collision collision;
+	Spawner spawner(0x5eed);
+	spawner.params.min_spawn_time = 0.0f;
+	spawner.params.max_spawn_time = 0.1f;
+	spawner.params.min_speed = 10.0f;
+	spawner.params.max_speed = 30.0f;
+	spawner.params.direction = glm::vec3(-1.0f, 0.0f, 0.0f);
+	spawner.params.spawn_min = glm::vec3(0.0f, -10.0f, 0.0f);
+	spawner.params.spawn_max = glm::vec3(0.0f, 10.0f, 5.0f);
+	spawner.params.live_min = glm::vec3(-1.0f, -20.0f, -20.0f);
+	spawner.params.live_max = glm::vec3(1.0f, 20.0f, 20.0f);
+	spawner.params.parked_position = glm::vec3(0.0f, 0.0f, -100.0f);
+	spawner.collision = &collision;
+	for (uint32_t i = 0; i < count; ++i) {
+		scene.transforms.emplace_back();
+		spawner.add(&scene.transforms.back(), collision.add(&scene.transforms.back()));
+	}
+
+	//run, counting spawns and retirements (outside the timed part) by watching which handles change state:
+	std::vector< uint8_t > was_active(count, 0);
+	uint64_t spawned = 0, retired = 0;
+	double update_ms = 0.0;
+	uint64_t steady_allocations = 0;
+	for (uint32_t frame = 0; frame < warm_up + frames; ++frame) {
+		uint64_t allocations_before = allocations;
+		auto before = std::chrono::high_resolution_clock::now();
+		spawner.update(1.0f / 60.0f);
+		auto after = std::chrono::high_resolution_clock::now();
+
+		bool steady = (frame >= warm_up);
+		if (steady) {
+			steady_allocations += allocations - allocations_before;
+			update_ms += std::chrono::duration< double, std::milli >(after - before).count();
+		}
+		for (uint32_t h = 0; h < count; ++h) {
+			uint8_t active = spawner.is_active(h);
+			if (steady && active && !was_active[h]) ++spawned;
+			if (steady && !active && was_active[h]) ++retired;
+			was_active[h] = active;
+		}
+	}
+
+	double seconds = update_ms / 1000.0;
+	std::cout << count << " objects, " << frames << " frames (after " << warm_up << " warm-up frames): "
+	          << double(spawner.active_count) / count * 100.0 << "% active at the end." << std::endl;
+	std::cout << "update(): " << update_ms / frames << " ms per frame; "
+	          << spawned / frames << " spawns and " << retired / frames << " retirements per frame, or "
+	          << uint64_t(spawned / seconds) << " spawns and " << uint64_t(retired / seconds) << " retirements per second of update()." << std::endl;
+	std::cout << "Allocations during steady state: " << steady_allocations << std::endl;
+
+	if (steady_allocations != 0) {
+		std::cout << "FAILED: Spawner allocated after its pool was filled." << std::endl;
+		return 1;
+	}
+	return 0;
+}
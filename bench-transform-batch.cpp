@@ -0,0 +1,108 @@
+//bench-transform-batch times make_local_to_parent_batch() -- with each of its kernels (scalar, SSE, AVX2) --
+// against calling Scene::Transform::make_local_to_parent() / make_parent_to_local() (the glm path) per transform,
+// for 10k to 1M transforms, and checks that every kernel agrees with the glm path.
+//
+//Usage:
+// bench-transform-batch [repeats]
+//
+//Inputs are random (from a fixed seed); times are the best of [repeats] (default 10) runs.
+//Kernels the CPU doesn't support fall back to the next-best one (see transform_batch.hpp), and are marked as such.
+
+#include "transform_batch.hpp"
+#include "Scene.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	uint32_t repeats = 10;
+	if (argc > 1) repeats = uint32_t(std::stoul(argv[1]));
+
+	TransformBatchKernel best = transform_batch_kernel();
+	std::cout << "make_local_to_parent_batch() uses the " << (best == TransformBatchAVX2 ? "AVX2" : best == TransformBatchSSE ? "SSE" : "scalar") << " kernel on this machine." << std::endl;
+	std::cout << "nanoseconds per transform (best of " << repeats << "), computing local_to_parent + parent_to_local:" << std::endl;
+	std::cout << std::setw(10) << "count" << std::setw(10) << "glm" << std::setw(10) << "scalar" << std::setw(10) << "SSE" << std::setw(10) << "AVX2"
+	          << std::setw(16) << "best speedup" << std::setw(14) << "max error" << std::endl;
+
+	std::mt19937 mt(0x7a5f);
+	auto uniform = [&mt](float lo, float hi) {
+		return std::uniform_real_distribution< float >(lo, hi)(mt);
+	};
+
+	for (size_t count : {10000, 100000, 1000000}) {
+		std::vector< glm::vec3 > positions(count), scales(count);
+		std::vector< glm::quat > rotations(count);
+		std::unique_ptr< Scene::Transform[] > transforms(new Scene::Transform[count]);
+		for (size_t i = 0; i < count; ++i) {
+			positions[i] = glm::vec3(uniform(-100.0f, 100.0f), uniform(-100.0f, 100.0f), uniform(-100.0f, 100.0f));
+			rotations[i] = glm::normalize(glm::quat(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f)));
+			scales[i] = glm::vec3(uniform(0.1f, 10.0f), uniform(0.1f, 10.0f), uniform(0.1f, 10.0f));
+			transforms[i].position = positions[i];
+			transforms[i].rotation = rotations[i];
+			transforms[i].scale = scales[i];
+		}
+
+		std::vector< glm::mat4x3 > expected_l2p(count), expected_p2l(count), l2p(count), p2l(count);
+
+		auto best_ns = [&](auto const &f) {
+			double best = std::numeric_limits< double >::infinity();
+			for (uint32_t r = 0; r < repeats; ++r) {
+				auto before = std::chrono::high_resolution_clock::now();
+				f();
+				auto after = std::chrono::high_resolution_clock::now();
+				best = std::min(best, std::chrono::duration< double, std::nano >(after - before).count() / count);
+			}
+			return best;
+		};
+
+		double glm_ns = best_ns([&](){
+			for (size_t i = 0; i < count; ++i) {
+				expected_l2p[i] = transforms[i].make_local_to_parent();
+				expected_p2l[i] = transforms[i].make_parent_to_local();
+			}
+		});
+
+		//error relative to the size of the matrix entries (which range up to ~100):
+		float max_error = 0.0f;
+		auto check = [&]() {
+			for (size_t i = 0; i < count; ++i) {
+				for (uint32_t c = 0; c < 4; ++c) {
+					glm::vec3 d1 = glm::abs(l2p[i][c] - expected_l2p[i][c]) / (glm::abs(expected_l2p[i][c]) + 1.0f);
+					glm::vec3 d2 = glm::abs(p2l[i][c] - expected_p2l[i][c]) / (glm::abs(expected_p2l[i][c]) + 1.0f);
+					max_error = std::max({ max_error, d1.x, d1.y, d1.z, d2.x, d2.y, d2.z });
+				}
+			}
+		};
+
+		double kernel_ns[3];
+		for (TransformBatchKernel kernel : {TransformBatchScalar, TransformBatchSSE, TransformBatchAVX2}) {
+			std::fill(l2p.begin(), l2p.end(), glm::mat4x3(0.0f));
+			std::fill(p2l.begin(), p2l.end(), glm::mat4x3(0.0f));
+			kernel_ns[kernel] = best_ns([&](){
+				make_local_to_parent_batch(kernel, count, positions.data(), rotations.data(), scales.data(), l2p.data(), p2l.data());
+			});
+			check();
+		}
+
+		std::cout << std::fixed << std::setprecision(2)
+		          << std::setw(10) << count << std::setw(10) << glm_ns
+		          << std::setw(10) << kernel_ns[TransformBatchScalar] << std::setw(10) << kernel_ns[TransformBatchSSE]
+		          << std::setw(10) << kernel_ns[TransformBatchAVX2] << (best == TransformBatchAVX2 ? "" : "*")
+		          << std::setw(15) << glm_ns / kernel_ns[best] << "x"
+		          << std::setw(14) << std::scientific << std::setprecision(1) << max_error << std::endl;
+	}
+	if (best != TransformBatchAVX2) std::cout << "(* AVX2 isn't supported here, so that column ran the SSE kernel)" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,259 @@
+//bench-vertex-fetch draws the same dense mesh offscreen from a plain ("pnct", 36 bytes per vertex) and
+// a quantized ("pnq0", 20 bytes per vertex; see quantize-meshes.cpp) MeshBuffer, with Scene::draw and ShowSceneProgram,
+// and compares GPU time per draw (GL_TIME_ELAPSED) -- and checks that both draws produce the same image.
+//
+//Usage:
+// bench-vertex-fetch [triangles] [draws]
+//
+//The mesh is a finely tessellated sphere (default 2M triangles, not indexed, so every triangle fetches three vertices)
+// drawn into a small framebuffer, so vertex work outweighs pixel work. Both files are written to the working
+// directory (as bench-vertex-fetch-*.pnct), loaded through MeshBuffer, and removed after.
+//Uses the same video driver as headless mode (see headless.hpp). Returns non-zero if the images differ.
+
+#include "Mesh.hpp"
+#include "Scene.hpp"
+#include "ShowSceneProgram.hpp"
+#include "headless.hpp"
+#include "read_write_chunk.hpp"
+#include "gl_errors.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//same layouts as MeshBuffer's:
+struct Vertex {
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::u8vec4 Color;
+	glm::vec2 TexCoord;
+};
+static_assert(sizeof(Vertex) == 3*4+3*4+4*1+2*4, "Vertex is packed.");
+
+struct QuantizedVertex {
+	glm::i16vec4 Position;
+	glm::i16vec2 Normal;
+	glm::u8vec4 Color;
+	glm::u16vec2 TexCoord;
+};
+static_assert(sizeof(QuantizedVertex) == 4*2+2*2+4*1+2*2, "QuantizedVertex is packed.");
+
+struct IndexEntry {
+	uint32_t name_begin, name_end;
+	uint32_t vertex_begin, vertex_end;
+};
+static_assert(sizeof(IndexEntry) == 16, "Index entry should be packed");
+
+//(same encoding as quantize-meshes.cpp)
+static int16_t to_snorm16(float value) {
+	return int16_t(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+static glm::vec2 oct_encode(glm::vec3 n) {
+	n /= (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+	glm::vec2 e = glm::vec2(n.x, n.y);
+	if (n.z < 0.0f) {
+		e = glm::vec2(
+			(1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f)
+		);
+	}
+	return e;
+}
+
+int main(int argc, char **argv) {
+	uint32_t triangles = 2000000;
+	uint32_t draws = 20;
+	if (argc > 1) triangles = uint32_t(std::stoul(argv[1]));
+	if (argc > 2) draws = uint32_t(std::stoul(argv[2]));
+
+	OffscreenContext context;
+	call_load_functions();
+	std::cout << "Renderer: " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")" << std::endl;
+
+	//--- write the mesh both ways ---
+	//sphere with 'rings' x 2*'rings' cells, two triangles each:
+	uint32_t rings = std::max(2u, uint32_t(std::sqrt(triangles / 4.0)));
+	uint32_t segments = 2 * rings;
+	std::vector< Vertex > vertices;
+	vertices.reserve(6 * rings * segments);
+	auto corner = [&](uint32_t r, uint32_t s) {
+		float theta = 3.1415926f * r / rings;
+		float phi = 2.0f * 3.1415926f * s / segments;
+		Vertex v;
+		v.Normal = glm::vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+		v.Position = v.Normal;
+		v.Color = glm::u8vec4(uint8_t(128 + 127 * v.Normal.x), uint8_t(128 + 127 * v.Normal.y), 0xff, 0xff);
+		v.TexCoord = glm::vec2(float(s) / segments, float(r) / rings);
+		vertices.emplace_back(v);
+	};
+	for (uint32_t r = 0; r < rings; ++r) {
+		for (uint32_t s = 0; s < segments; ++s) {
+			corner(r, s); corner(r+1, s); corner(r+1, s+1);
+			corner(r, s); corner(r+1, s+1); corner(r, s+1);
+		}
+	}
+
+	std::string strings = "Sphere";
+	std::vector< char > string_chunk(strings.begin(), strings.end());
+	std::vector< IndexEntry > index(1);
+	index[0].name_begin = 0;
+	index[0].name_end = uint32_t(strings.size());
+	index[0].vertex_begin = 0;
+	index[0].vertex_end = uint32_t(vertices.size());
+
+	glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+	glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
+	for (auto const &v : vertices) {
+		min = glm::min(min, v.Position);
+		max = glm::max(max, v.Position);
+	}
+	std::vector< glm::vec3 > decode{ 0.5f * (min + max), 0.5f * (max - min) }; //(one "qdc0" entry: offset, scale)
+	std::vector< QuantizedVertex > quantized(vertices.size());
+	for (uint32_t i = 0; i < vertices.size(); ++i) {
+		for (uint32_t c = 0; c < 3; ++c) {
+			quantized[i].Position[c] = to_snorm16((vertices[i].Position[c] - decode[0][c]) / decode[1][c]);
+		}
+		quantized[i].Position.w = -32767; //(flags octahedral normals)
+		glm::vec2 oct = oct_encode(vertices[i].Normal);
+		quantized[i].Normal = glm::i16vec2(to_snorm16(oct.x), to_snorm16(oct.y));
+		quantized[i].Color = vertices[i].Color;
+		quantized[i].TexCoord = glm::u16vec2(glm::packHalf1x16(vertices[i].TexCoord.x), glm::packHalf1x16(vertices[i].TexCoord.y));
+	}
+
+	std::string const plain_file = "bench-vertex-fetch-plain.pnct";
+	std::string const quantized_file = "bench-vertex-fetch-quantized.pnct";
+	{
+		std::ofstream file(plain_file, std::ios::binary);
+		write_chunk("pnct", vertices, &file);
+		write_chunk("str0", string_chunk, &file);
+		write_chunk("idx0", index, &file);
+	}
+	{
+		std::ofstream file(quantized_file, std::ios::binary);
+		write_chunk("pnq0", quantized, &file);
+		write_chunk("str0", string_chunk, &file);
+		write_chunk("idx0", index, &file);
+		write_chunk("qdc0", decode, &file);
+	}
+	vertices.clear(); vertices.shrink_to_fit();
+	quantized.clear(); quantized.shrink_to_fit();
+
+	//--- draw each ---
+	OffscreenFramebuffer framebuffer(glm::uvec2(256, 256));
+
+	Scene::Transform camera_transform;
+	camera_transform.position = glm::vec3(0.0f, 0.0f, 3.0f);
+	Scene::Camera camera(&camera_transform);
+	camera.fovy = 60.0f / 180.0f * 3.1415926f;
+	camera.aspect = 1.0f;
+	camera.near = 0.1f;
+
+	struct Result {
+		std::string name;
+		size_t bytes_per_vertex;
+		uint32_t vertices;
+		double median_ms;
+		std::vector< glm::u8vec4 > image;
+	};
+	std::vector< Result > results;
+	for (std::string const &file : {plain_file, quantized_file}) {
+		MeshBuffer buffer(file);
+		Mesh const &mesh = buffer.lookup("Sphere");
+		GLuint vao = buffer.make_vao_for_program(show_scene_program->program);
+
+		Scene scene;
+		scene.transforms.emplace_back();
+		//(turned a little, so the tessellation isn't lined up with the pixels)
+		scene.transforms.back().rotation = glm::angleAxis(0.3f, glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f)));
+		scene.drawables.emplace_back(&scene.transforms.back());
+		Scene::Drawable &drawable = scene.drawables.back();
+		drawable.pipeline = show_scene_program_pipeline;
+		drawable.pipeline.vao = vao;
+		drawable.pipeline.type = mesh.type;
+		drawable.pipeline.start = mesh.start;
+		drawable.pipeline.count = mesh.count;
+		drawable.pipeline.position_offset = mesh.position_offset;
+		drawable.pipeline.position_scale = mesh.position_scale;
+		drawable.min = mesh.min;
+		drawable.max = mesh.max;
+
+		auto draw = [&]() {
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glEnable(GL_DEPTH_TEST);
+			glDepthFunc(GL_LESS);
+			scene.draw(camera);
+		};
+
+		//(one untimed draw first, for first-use costs)
+		draw();
+		glFinish();
+
+		std::vector< GLuint > queries(draws, 0);
+		glGenQueries(GLsizei(queries.size()), queries.data());
+		for (uint32_t d = 0; d < draws; ++d) {
+			glBeginQuery(GL_TIME_ELAPSED, queries[d]);
+			draw();
+			glEndQuery(GL_TIME_ELAPSED);
+		}
+		std::vector< double > ms(draws, 0.0);
+		for (uint32_t d = 0; d < draws; ++d) {
+			GLuint64 ns = 0;
+			glGetQueryObjectui64v(queries[d], GL_QUERY_RESULT, &ns);
+			ms[d] = ns / 1.0e6;
+		}
+		glDeleteQueries(GLsizei(queries.size()), queries.data());
+		std::sort(ms.begin(), ms.end());
+
+		results.emplace_back();
+		results.back().name = (buffer.Position.type == GL_FLOAT ? "pnct" : "pnq0");
+		results.back().bytes_per_vertex = buffer.Position.stride;
+		results.back().vertices = mesh.count;
+		results.back().median_ms = ms[ms.size() / 2];
+		results.back().image = framebuffer.read_pixels();
+
+		glDeleteVertexArrays(1, &vao);
+		GL_ERRORS();
+	}
+	std::remove(plain_file.c_str());
+	std::remove(quantized_file.c_str());
+
+	//--- report ---
+	std::cout << results[0].vertices << " vertices (" << results[0].vertices / 3 << " triangles), " << framebuffer.size.x << "x" << framebuffer.size.y << " pixels, median of " << draws << " draws:" << std::endl;
+	std::cout << std::setw(8) << "format" << std::setw(16) << "bytes/vertex" << std::setw(12) << "buffer MB" << std::setw(14) << "GPU ms/draw" << std::setw(16) << "Mvertices/s" << std::endl;
+	for (auto const &result : results) {
+		std::cout << std::fixed << std::setprecision(2)
+		          << std::setw(8) << result.name << std::setw(16) << result.bytes_per_vertex
+		          << std::setw(12) << result.vertices * result.bytes_per_vertex / (1024.0 * 1024.0)
+		          << std::setw(14) << result.median_ms << std::setw(16) << result.vertices / (result.median_ms * 1000.0) << std::endl;
+	}
+	std::cout << "pnq0 draws are " << std::setprecision(2) << results[0].median_ms / results[1].median_ms << "x as fast as pnct draws." << std::endl;
+
+	//quantization moves positions by ~1e-5 of the sphere's size, so only a few edge pixels should change:
+	uint32_t covered = 0, different = 0;
+	for (uint32_t i = 0; i < results[0].image.size(); ++i) {
+		glm::u8vec4 a = results[0].image[i], b = results[1].image[i];
+		if (a.b != 0 || b.b != 0) ++covered;
+		for (uint32_t c = 0; c < 3; ++c) {
+			if (std::abs(int(a[c]) - int(b[c])) > 4) {
+				++different;
+				break;
+			}
+		}
+	}
+	std::cout << different << " of " << covered << " covered pixels differ between the two images." << std::endl;
+	if (covered == 0 || different > covered / 100) {
+		std::cout << "FAILED: the plain and quantized meshes don't draw the same image." << std::endl;
+		return 1;
+	}
+	return 0;
+}
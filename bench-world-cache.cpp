@@ -0,0 +1,114 @@
+//bench-world-cache times computing world matrices for a scene's transforms each frame, at several hierarchy depths,
+// when every transform moves, when only a few leaves move, and when only a few roots (and so their chains) move:
+// - "lazy": move, then call make_local_to_world() on every transform (each recomputes as needed, but each call
+//   also re-checks its ancestors -- see Scene::Transform::make_local_to_world)
+// - "pass": move, then call make_local_to_world(pass) on every transform, with one pass for the frame
+//   (as Scene::draw does; each transform is checked once, however deep)
+// - "update_transforms": move, then Scene::update_transforms() (one linear sweep over flat arrays)
+// - "array reads": reading every world matrix from Scene::transform_arrays.local_to_world after update_transforms()
+//
+//Usage:
+// bench-world-cache [transforms] [frames] [movers]
+//
+//Transforms are arranged as chains of the given depth (so the total count is the same at every depth).
+//Defaults to 100000 transforms, 50 frames, and 16 movers in the "few leaves" / "few roots" cases.
+
+#include "Scene.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	uint32_t count = 100000;
+	uint32_t frames = 50;
+	uint32_t movers = 16;
+	if (argc > 1) count = uint32_t(std::stoul(argv[1]));
+	if (argc > 2) frames = uint32_t(std::stoul(argv[2]));
+	if (argc > 3) movers = uint32_t(std::stoul(argv[3]));
+
+	std::cout << count << " transforms, " << frames << " frames, " << movers << " movers; milliseconds per frame:" << std::endl;
+	std::cout << std::setw(6) << "depth" << std::setw(14) << "moved" << std::setw(10) << "lazy" << std::setw(10) << "pass" << std::setw(20) << "update_transforms" << std::setw(14) << "array reads" << std::endl;
+
+	for (uint32_t depth : {1, 4, 16, 64}) {
+		Scene scene;
+		std::vector< Scene::Transform * > list;
+		std::vector< Scene::Transform * > roots, leaves;
+		for (uint32_t i = 0; i < count; ++i) {
+			scene.transforms.emplace_back();
+			Scene::Transform *t = &scene.transforms.back();
+			t->parent = (i % depth == 0 ? nullptr : list.back());
+			t->position = glm::vec3(float(i % 7), float(i % 5), 1.0f);
+			t->rotation = glm::angleAxis(0.01f * float(i % 13), glm::vec3(0.0f, 0.0f, 1.0f));
+			list.emplace_back(t);
+			if (i % depth == 0) roots.emplace_back(t);
+			if (i % depth == depth - 1 || i + 1 == count) leaves.emplace_back(t);
+		}
+		scene.update_transforms();
+
+		//movers are spread evenly through the scene:
+		auto pick = [movers](std::vector< Scene::Transform * > const &from) {
+			std::vector< Scene::Transform * > picked;
+			for (uint32_t i = 0; i < movers && i < from.size(); ++i) {
+				picked.emplace_back(from[size_t(i) * from.size() / std::min< size_t >(movers, from.size())]);
+			}
+			return picked;
+		};
+
+		glm::vec3 sum = glm::vec3(0.0f); //(so reads aren't optimized away)
+		auto read_all = [&]() {
+			for (auto t : list) sum += t->make_local_to_world()[3];
+		};
+		auto read_all_pass = [&]() {
+			uint64_t pass = Scene::Transform::new_world_pass();
+			for (auto t : list) sum += t->make_local_to_world(pass)[3];
+		};
+		auto read_arrays = [&]() {
+			for (auto const &m : scene.transform_arrays.local_to_world) sum += m[3];
+		};
+		auto time = [](auto const &f) {
+			auto before = std::chrono::high_resolution_clock::now();
+			f();
+			auto after = std::chrono::high_resolution_clock::now();
+			return std::chrono::duration< double, std::milli >(after - before).count();
+		};
+
+		std::pair< char const *, std::vector< Scene::Transform * > > cases[] = {
+			{ "all", list },
+			{ "few leaves", pick(leaves) },
+			{ "few roots", pick(roots) },
+		};
+		for (auto const &[name, moving] : cases) {
+			uint32_t step = 0;
+			auto move = [&]() {
+				++step;
+				for (auto t : moving) t->position.z = float(step);
+			};
+
+			double lazy = 0.0, pass = 0.0, sweep = 0.0, array_reads = 0.0;
+			for (uint32_t frame = 0; frame < frames; ++frame) {
+				move();
+				lazy += time(read_all);
+
+				move();
+				pass += time(read_all_pass);
+
+				move();
+				sweep += time([&](){ scene.update_transforms(); });
+				array_reads += time(read_arrays);
+			}
+
+			std::cout << std::fixed << std::setprecision(2)
+			          << std::setw(6) << depth << std::setw(14) << name << std::setw(10) << lazy / frames << std::setw(10) << pass / frames << std::setw(20) << sweep / frames << std::setw(14) << array_reads / frames
+			          << (sum.x == 12345.0f ? " " : "") << std::endl;
+		}
+	}
+
+	return 0;
+}
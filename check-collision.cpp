@@ -0,0 +1,175 @@
+//check-collision runs Collision::update() (sweep-and-prune + oriented box tests) on a few thousand moving colliders
+// without a window, and checks its contacts against brute force -- every enabled pair, tested with Collision::overlap():
+// - the contact lists must be identical (same pairs, same order, same normal and depth)
+// - each contact's normal and depth must actually separate the pair (pushing b a little less than depth still
+//   overlaps, a little more doesn't)
+//
+//Usage:
+// check-collision [colliders] [frames]
+//
+//Colliders are randomly placed, rotated, scaled, parented, layered, disabled, removed, and re-added, from a fixed
+// seed, so runs are repeatable. Prints timings for both methods; returns non-zero if anything differs.
+
+#include "Collision.hpp"
+#include "Scene.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	uint32_t count = 4000;
+	uint32_t frames = 30;
+	if (argc > 1) count = uint32_t(std::stoul(argv[1]));
+	if (argc > 2) frames = uint32_t(std::stoul(argv[2]));
+
+	std::mt19937 mt(0x0c011de5);
+	auto uniform = [&mt](float lo, float hi) {
+		return std::uniform_real_distribution< float >(lo, hi)(mt);
+	};
+	auto random_rotation = [&]() {
+		return glm::normalize(glm::quat(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f)));
+	};
+
+	//colliders in a box about 40 units on a side (so each touches a few others), a quarter of them in groups under moving parents:
+	Scene scene;
+	std::vector< Scene::Transform * > parents;
+	for (uint32_t i = 0; i < count / 16; ++i) {
+		scene.transforms.emplace_back();
+		scene.transforms.back().position = glm::vec3(uniform(-20.0f, 20.0f), uniform(-20.0f, 20.0f), uniform(-20.0f, 20.0f));
+		scene.transforms.back().rotation = random_rotation();
+		parents.emplace_back(&scene.transforms.back());
+	}
+
+	Collision collision;
+	std::vector< Scene::Transform * > movers;
+	auto add_collider = [&]() {
+		scene.transforms.emplace_back();
+		Scene::Transform *t = &scene.transforms.back();
+		if (!parents.empty() && mt() % 4 == 0) {
+			t->parent = parents[mt() % parents.size()];
+			t->position = glm::vec3(uniform(-2.0f, 2.0f), uniform(-2.0f, 2.0f), uniform(-2.0f, 2.0f));
+		} else {
+			t->position = glm::vec3(uniform(-20.0f, 20.0f), uniform(-20.0f, 20.0f), uniform(-20.0f, 20.0f));
+		}
+		t->rotation = random_rotation();
+		t->scale = glm::vec3(uniform(0.5f, 2.0f), uniform(0.5f, 2.0f), uniform(0.5f, 2.0f));
+		movers.emplace_back(t);
+
+		uint32_t id = collision.add(t, glm::vec3(uniform(-0.5f, 0.0f), uniform(-0.5f, 0.0f), uniform(-0.5f, 0.0f)), glm::vec3(uniform(0.0f, 0.5f), uniform(0.0f, 0.5f), uniform(0.0f, 0.5f)));
+		Collision::Collider &c = collision.colliders[id];
+		c.layers = 1u << (mt() % 3);
+		c.mask = (mt() % 4 == 0 ? (1u << (mt() % 3)) : ~0u);
+		c.enabled = (mt() % 8 != 0);
+	};
+	for (uint32_t i = 0; i < count; ++i) {
+		add_collider();
+	}
+
+	//brute force reference:
+	std::vector< Collision::Contact > expected;
+	auto brute_force = [&]() {
+		expected.clear();
+		auto const &colliders = collision.colliders;
+		for (uint32_t a = 0; a < colliders.size(); ++a) {
+			if (!colliders[a].transform || !colliders[a].enabled) continue;
+			for (uint32_t b = a + 1; b < colliders.size(); ++b) {
+				if (!colliders[b].transform || !colliders[b].enabled) continue;
+				if (!(colliders[a].layers & colliders[b].mask) || !(colliders[b].layers & colliders[a].mask)) continue;
+				Collision::Contact contact;
+				if (Collision::overlap(colliders[a], colliders[b], &contact)) {
+					contact.a = a;
+					contact.b = b;
+					expected.emplace_back(contact);
+				}
+			}
+		}
+	};
+
+	uint32_t failures = 0;
+	double update_ms = 0.0, brute_ms = 0.0;
+	uint64_t total_contacts = 0, total_candidates = 0;
+	for (uint32_t frame = 0; frame < frames; ++frame) {
+		//move things (small steps, as in a game, plus the occasional teleport to shuffle the sweep order):
+		for (auto t : movers) {
+			if (mt() % 64 == 0) {
+				t->position = glm::vec3(uniform(-20.0f, 20.0f), uniform(-20.0f, 20.0f), uniform(-20.0f, 20.0f));
+			} else {
+				t->position += glm::vec3(uniform(-0.2f, 0.2f), uniform(-0.2f, 0.2f), uniform(-0.2f, 0.2f));
+			}
+			t->rotation = glm::normalize(t->rotation * glm::quat(1.0f, uniform(-0.05f, 0.05f), uniform(-0.05f, 0.05f), uniform(-0.05f, 0.05f)));
+		}
+		for (auto p : parents) {
+			p->rotation = glm::normalize(p->rotation * glm::quat(1.0f, 0.0f, 0.05f, 0.0f));
+		}
+		//...and change which colliders are in play:
+		for (uint32_t i = 0; i < count / 100; ++i) {
+			uint32_t id = uint32_t(mt() % collision.colliders.size());
+			Collision::Collider &c = collision.colliders[id];
+			if (!c.transform) continue;
+			if (mt() % 2) {
+				c.enabled = !c.enabled;
+			} else {
+				//(the transform stays in the scene; the re-added collider gets a new one)
+				collision.remove(id);
+				add_collider();
+			}
+		}
+
+		auto before = std::chrono::high_resolution_clock::now();
+		collision.update();
+		auto after = std::chrono::high_resolution_clock::now();
+		brute_force();
+		auto after_brute = std::chrono::high_resolution_clock::now();
+		update_ms += std::chrono::duration< double, std::milli >(after - before).count();
+		brute_ms += std::chrono::duration< double, std::milli >(after_brute - after).count();
+		total_contacts += collision.contacts.size();
+		total_candidates += collision.stats.candidates;
+
+		//same contacts?
+		bool same = (collision.contacts.size() == expected.size());
+		for (uint32_t i = 0; same && i < expected.size(); ++i) {
+			Collision::Contact const &x = collision.contacts[i], &y = expected[i];
+			same = (x.a == y.a && x.b == y.b && x.normal == y.normal && x.depth == y.depth);
+		}
+		if (!same) {
+			std::cout << "  FAILED: frame " << frame << ": update() found " << collision.contacts.size() << " contacts, brute force found " << expected.size() << std::endl;
+			++failures;
+		}
+
+		//do the normals and depths separate the boxes?
+		for (auto const &contact : collision.contacts) {
+			Collision::Collider const &a = collision.colliders[contact.a];
+			Collision::Collider b = collision.colliders[contact.b];
+			float slack = 1e-3f * (1.0f + contact.depth);
+			glm::vec3 center = b.center;
+			b.center = center + contact.normal * (contact.depth + slack);
+			bool separated = !Collision::overlap(a, b);
+			b.center = center + contact.normal * std::max(0.0f, contact.depth - slack);
+			bool still_touching = Collision::overlap(a, b);
+			if (!separated || !still_touching) {
+				std::cout << "  FAILED: frame " << frame << ": contact (" << contact.a << ", " << contact.b << ") with depth " << contact.depth
+				          << (separated ? " separates too soon" : " doesn't separate the boxes") << std::endl;
+				++failures;
+				break;
+			}
+		}
+	}
+
+	std::cout << count << " colliders, " << frames << " frames: "
+	          << double(total_contacts) / frames << " contacts and " << double(total_candidates) / frames << " sweep-and-prune candidates per frame." << std::endl;
+	std::cout << "update(): " << update_ms / frames << " ms per frame; brute force: " << brute_ms / frames << " ms per frame." << std::endl;
+
+	if (failures) {
+		std::cout << failures << " check(s) FAILED." << std::endl;
+		return 1;
+	}
+	std::cout << "Contacts match brute force on every frame." << std::endl;
+	return 0;
+}
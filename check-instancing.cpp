@@ -0,0 +1,174 @@
+//check-instancing draws the game's scene offscreen, set up the way PlayMode sets it up (with the planes, coins,
+// and clouds in view), twice:
+// - with instancing (drawables that share a mesh drawn by one glDrawArraysInstanced call), and
+// - with every drawable's instanced_vao cleared (so each one is drawn on its own, with uniforms),
+// and checks that the two images match and that the first draw really did use instancing.
+//
+//Usage:
+// check-instancing [scene] [meshes]
+//
+//Defaults to dist/bird.scene and dist/bird.pnct (found relative to the executable).
+//Needs OpenGL, from the same video driver as headless mode (see headless.hpp). Returns non-zero if any check fails.
+
+#include "LitColorTextureProgram.hpp"
+#include "Mesh.hpp"
+#include "Scene.hpp"
+#include "data_path.hpp"
+#include "headless.hpp"
+#include "gl_errors.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	std::string scene_file = data_path("../dist/bird.scene");
+	std::string meshes_file = data_path("../dist/bird.pnct");
+	if (argc > 1) scene_file = argv[1];
+	if (argc > 2) meshes_file = argv[2];
+
+	OffscreenContext context;
+	call_load_functions();
+
+	//--- load meshes + scene (as PlayMode's bird_meshes and bird_scene do) ---
+	MeshBuffer meshes(meshes_file);
+	GLuint vao = meshes.make_vao_for_program(lit_color_texture_program->program);
+	GLuint instanced_vao = meshes.make_vao_for_program(lit_color_texture_instanced_program->program);
+	Scene::add_instance_attributes(instanced_vao, lit_color_texture_instanced_program->program);
+
+	Scene scene(scene_file, [&](Scene &scene, Scene::Transform *transform, std::string const &mesh_name){
+		Mesh const &mesh = meshes.lookup(mesh_name);
+
+		scene.drawables.emplace_back(transform);
+		Scene::Drawable &drawable = scene.drawables.back();
+
+		drawable.pipeline = lit_color_texture_program_pipeline;
+
+		drawable.pipeline.vao = vao;
+		drawable.pipeline.instanced_vao = instanced_vao;
+		drawable.pipeline.type = mesh.type;
+		drawable.pipeline.start = mesh.start;
+		drawable.pipeline.count = mesh.count;
+		drawable.pipeline.index_type = mesh.index_type;
+		for (uint32_t i = 0; i < Scene::Drawable::Pipeline::LODCount && i < mesh.lods.size(); ++i) {
+			drawable.pipeline.lods[i].start = mesh.lods[i].start;
+			drawable.pipeline.lods[i].count = mesh.lods[i].count;
+			drawable.pipeline.lods[i].error = mesh.lods[i].error;
+		}
+		drawable.pipeline.position_offset = mesh.position_offset;
+		drawable.pipeline.position_scale = mesh.position_scale;
+
+		drawable.min = mesh.min;
+		drawable.max = mesh.max;
+	});
+	//(same light as PlayMode adds)
+	if (Scene::Transform *hemi_light = scene.find_transform("hemi_light")) {
+		scene.lights.emplace_back(hemi_light);
+		scene.lights.back().type = Scene::Light::Hemisphere;
+		scene.lights.back().energy = glm::vec3(0.95f, 0.9f, 0.9f);
+	}
+	if (scene.cameras.empty() || scene.lights.empty()) {
+		std::cout << "  FAILED: expecting '" << scene_file << "' to have a camera and a light (or a 'hemi_light' transform)." << std::endl;
+		return 1;
+	}
+
+	Scene::Camera &camera = scene.cameras.front();
+
+	//planes, coins, and clouds (which share meshes) start out of view, so put them in flight in front of the camera,
+	// in the volume PlayMode's spawners use (see PlayMode.hpp):
+	std::vector< Scene::Transform * > flying;
+	for (char const *kind : {"_plane", "_coin", "_cloud"}) {
+		scene.find_transforms_containing(kind, &flying);
+	}
+	std::mt19937 mt(0x1235);
+	auto uniform = [&mt](float lo, float hi) {
+		return std::uniform_real_distribution< float >(lo, hi)(mt);
+	};
+	for (Scene::Transform *transform : flying) {
+		if (transform->parent) continue; //(skip colliders, which move with their objects)
+		transform->position = camera.transform->position + glm::vec3(uniform(8.0f, 30.0f), uniform(-3.0f, 3.0f), uniform(-2.0f, 2.0f));
+	}
+
+	OffscreenFramebuffer framebuffer(glm::uvec2(320, 240));
+	camera.aspect = float(framebuffer.size.x) / float(framebuffer.size.y);
+
+	//(same light uniforms as PlayMode::draw)
+	Scene::Light const &light = scene.lights.front();
+	for (LitColorTextureProgram const *program : { lit_color_texture_program.value, lit_color_texture_instanced_program.value }) {
+		glUseProgram(program->program);
+		switch (light.type) {
+			case light.Point: glUniform1i(program->LIGHT_TYPE_int, 0); break;
+			case light.Hemisphere: glUniform1i(program->LIGHT_TYPE_int, 1); break;
+			case light.Spot: glUniform1i(program->LIGHT_TYPE_int, 2); break;
+			case light.Directional: glUniform1i(program->LIGHT_TYPE_int, 3); break;
+			default: break;
+		}
+		glUniform3fv(program->LIGHT_DIRECTION_vec3, 1, glm::value_ptr(light.transform->rotation * glm::vec3(0.0f, 0.0f,-1.0f)));
+		glUniform3fv(program->LIGHT_ENERGY_vec3, 1, glm::value_ptr(light.energy));
+	}
+	glUseProgram(0);
+
+	auto draw = [&](Scene::DrawStats *stats) {
+		glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
+		glClearDepth(1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LESS);
+		scene.draw(camera);
+		*stats = scene.draw_stats;
+		GL_ERRORS();
+		return framebuffer.read_pixels();
+	};
+
+	Scene::DrawStats instanced_stats, separate_stats;
+	std::vector< glm::u8vec4 > instanced = draw(&instanced_stats);
+	for (auto &drawable : scene.drawables) {
+		drawable.pipeline.instanced_vao = 0;
+	}
+	std::vector< glm::u8vec4 > separate = draw(&separate_stats);
+
+	glDeleteVertexArrays(1, &vao);
+	glDeleteVertexArrays(1, &instanced_vao);
+
+	//--- report ---
+	std::cout << "Drew " << scene.drawables.size() << " drawables (" << instanced_stats.visible << " visible) into " << framebuffer.size.x << "x" << framebuffer.size.y << " pixels:" << std::endl;
+	std::cout << "  instanced: " << instanced_stats.draws << " draw calls (" << instanced_stats.instanced_draws << " instanced, covering " << instanced_stats.instances << " drawables), " << instanced_stats.triangles << " triangles" << std::endl;
+	std::cout << "  separate:  " << separate_stats.draws << " draw calls (" << separate_stats.instanced_draws << " instanced), " << separate_stats.triangles << " triangles" << std::endl;
+
+	uint32_t failures = 0;
+	auto check = [&failures](bool ok, std::string const &what) {
+		std::cout << (ok ? "  ok: " : "  FAILED: ") << what << std::endl;
+		if (!ok) ++failures;
+	};
+
+	check(instanced_stats.instanced_draws > 0, "the instanced draw used glDraw*Instanced");
+	check(separate_stats.instanced_draws == 0, "the separate draw didn't");
+	check(instanced_stats.draws < separate_stats.draws, "instancing drew the scene with fewer draw calls");
+	check(instanced_stats.triangles == separate_stats.triangles && instanced_stats.visible == separate_stats.visible, "both draws submitted the same drawables and triangles");
+
+	//the per-instance matrices are the same floats the uniforms get, so pixels should match exactly:
+	uint32_t different = 0;
+	int max_difference = 0;
+	for (uint32_t i = 0; i < instanced.size(); ++i) {
+		int difference = 0;
+		for (uint32_t c = 0; c < 3; ++c) {
+			difference = std::max(difference, std::abs(int(instanced[i][c]) - int(separate[i][c])));
+		}
+		if (difference != 0) ++different;
+		max_difference = std::max(max_difference, difference);
+	}
+	check(different == 0, std::to_string(different) + " of " + std::to_string(instanced.size()) + " pixels differ between the images (by at most " + std::to_string(max_difference) + ")");
+
+	if (failures) {
+		std::cout << failures << " check(s) FAILED." << std::endl;
+		return 1;
+	}
+	std::cout << "Instanced and separate draws match." << std::endl;
+	return 0;
+}
@@ -0,0 +1,118 @@
+//check-scene-share exercises Scene::share() / edit() / resolve() (copy-on-write scene instancing) without a window:
+// edits transforms from a shared base scene in orders that have gone wrong before (a child, then its parent),
+// moves the copies, and checks -- through update_bvh() / query(), as a game would see them -- that every
+// drawable below an edited transform moved with it, while the base scene stayed put.
+//
+//Usage:
+// check-scene-share
+//
+//Prints what it checked and returns non-zero if anything failed.
+
+#include "Scene.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+int main(int, char **) {
+	uint32_t failures = 0;
+	auto check = [&failures](bool ok, std::string const &what) {
+		std::cout << (ok ? "  ok: " : "  FAILED: ") << what << std::endl;
+		if (!ok) ++failures;
+	};
+
+	//base scene:
+	//  root
+	//  |- a (+10 x)
+	//  |  |- b (+10 y)
+	//  |  '- c (-10 y) -- camera
+	//  '- d (-10 x)
+	//each with a 2x2x2 drawable:
+	auto base = std::make_shared< Scene >();
+	auto add = [&](char const *name, Scene::Transform *parent, glm::vec3 const &position) {
+		base->transforms.emplace_back();
+		Scene::Transform *t = &base->transforms.back();
+		t->name = name;
+		t->parent = parent;
+		t->position = position;
+		base->drawables.emplace_back(t);
+		base->drawables.back().min = glm::vec3(-1.0f);
+		base->drawables.back().max = glm::vec3( 1.0f);
+		return t;
+	};
+	Scene::Transform *root = add("root", nullptr, glm::vec3(0.0f));
+	Scene::Transform *a = add("a", root, glm::vec3(10.0f, 0.0f, 0.0f));
+	Scene::Transform *b = add("b", a, glm::vec3(0.0f, 10.0f, 0.0f));
+	Scene::Transform *c = add("c", a, glm::vec3(0.0f,-10.0f, 0.0f));
+	Scene::Transform *d = add("d", root, glm::vec3(-10.0f, 0.0f, 0.0f));
+	base->cameras.emplace_back(c);
+	base->update_transforms();
+
+	//drawables a scene sees in a box, as the names of their transforms:
+	auto names_in = [](Scene const &scene, glm::vec3 const &min, glm::vec3 const &max) {
+		scene.update_bvh();
+		std::vector< Scene::Drawable const * > hits;
+		scene.query(min, max, &hits);
+		std::vector< std::string > names;
+		for (auto d : hits) names.emplace_back(d->transform->name);
+		std::sort(names.begin(), names.end());
+		return names;
+	};
+	using Names = std::vector< std::string >;
+
+	{ //edit a child, then its parent, then move the parent:
+		std::cout << "edit(b), then edit(a):" << std::endl;
+		Scene scene;
+		scene.share(base);
+		check(names_in(scene, glm::vec3(-20.0f), glm::vec3(20.0f)) == Names({"a", "b", "c", "d", "root"}), "sharing scene sees all of base's drawables");
+
+		Scene::Transform *b2 = scene.edit(b);
+		check(b2 != b && b2->parent && b2->parent != a, "edit(b) copies b and its parent");
+		check(scene.drawables.size() == 1, "edit(b) copies only b's drawable");
+		check(scene.resolve(b) == b2 && scene.resolve(c) == c, "resolve() finds b's copy and leaves c shared");
+
+		Scene::Transform *a2 = scene.edit(a);
+		check(a2 == b2->parent, "edit(a) returns the copy edit(b) made as b's parent");
+		check(scene.drawables.size() == 3, "edit(a) copies the drawables of a and its other child, c");
+		check(scene.resolve(c) != c && scene.resolve(c)->parent == a2, "c's copy is attached to a's copy");
+		check(scene.cameras.front().transform == scene.resolve(c), "the camera on c follows it to the copy");
+		check(scene.edit(a) == a2 && scene.drawables.size() == 3, "editing a again copies nothing new");
+
+		a2->position.x += 100.0f;
+		check(names_in(scene, glm::vec3(100.0f, -20.0f, -20.0f), glm::vec3(120.0f, 20.0f, 20.0f)) == Names({"a", "b", "c"}), "a, b, and c moved with a's copy");
+		check(names_in(scene, glm::vec3(5.0f, -20.0f, -20.0f), glm::vec3(20.0f, 20.0f, 20.0f)).empty(), "nothing was left behind at a's old position");
+		check(names_in(scene, glm::vec3(-20.0f), glm::vec3(1.0f)) == Names({"d", "root"}), "root and d are still shared");
+		check(names_in(*base, glm::vec3(5.0f, -20.0f, -20.0f), glm::vec3(20.0f, 20.0f, 20.0f)) == Names({"a", "b", "c"}), "base didn't move");
+
+		//copies of a sharing scene share the same way:
+		Scene copy(scene);
+		Scene::Transform *d2 = copy.edit(d);
+		d2->position.x -= 100.0f;
+		check(names_in(copy, glm::vec3(100.0f, -20.0f, -20.0f), glm::vec3(120.0f, 20.0f, 20.0f)) == Names({"a", "b", "c"}), "a copy keeps the edits it was copied with");
+		check(names_in(copy, glm::vec3(-120.0f, -20.0f, -20.0f), glm::vec3(-100.0f, 20.0f, 20.0f)) == Names({"d"}), "...and can make its own");
+		check(names_in(scene, glm::vec3(-20.0f), glm::vec3(1.0f)) == Names({"d", "root"}), "...without changing the scene it was copied from");
+	}
+
+	{ //edit the root after a leaf:
+		std::cout << "edit(c), then edit(root):" << std::endl;
+		Scene scene;
+		scene.share(base);
+		scene.edit(c);
+		Scene::Transform *root2 = scene.edit(root);
+		check(scene.drawables.size() == base->drawables.size() && scene.transforms.size() == base->transforms.size(), "everything is copied, once");
+		root2->position.z += 100.0f;
+		check(names_in(scene, glm::vec3(-20.0f, -20.0f, 90.0f), glm::vec3(20.0f, 20.0f, 110.0f)) == Names({"a", "b", "c", "d", "root"}), "everything moved with root's copy");
+		check(names_in(scene, glm::vec3(-20.0f), glm::vec3(20.0f)).empty(), "nothing was left behind");
+	}
+
+	if (failures) {
+		std::cout << failures << " check(s) FAILED." << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,96 @@
+//check-thread-pool checks ThreadPool::parallel_for():
+// - every index is visited exactly once (from the caller and from inside pool jobs)
+// - when work throws -- on the calling thread or on a worker -- the exception reaches the caller,
+//   and only after every call that was running has returned (so nothing touches the caller's stack afterward)
+//
+//Usage:
+// check-thread-pool [rounds]
+//
+//Runs a pool with more workers than cores, so calls interleave; returns non-zero if any check fails.
+
+#include "ThreadPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv) {
+	uint32_t rounds = 200;
+	if (argc > 1) rounds = uint32_t(std::stoul(argv[1]));
+
+	ThreadPool pool(4);
+
+	uint32_t failures = 0;
+	auto check = [&](bool ok, std::string const &what) {
+		if (!ok) {
+			std::cout << "  FAILED: " << what << std::endl;
+			++failures;
+		}
+	};
+
+	{ //every index once:
+		bool ok = true;
+		for (uint32_t round = 0; round < rounds && ok; ++round) {
+			size_t count = 1 + round % 37;
+			std::vector< std::atomic< uint32_t > > visits(count);
+			pool.parallel_for(count, [&](size_t i) { visits[i] += 1; });
+			for (auto const &v : visits) ok = ok && (v == 1);
+		}
+		check(ok, "parallel_for visits every index exactly once");
+	}
+
+	{ //...also when called from inside a pool job:
+		std::vector< std::atomic< uint32_t > > visits(100);
+		std::atomic< bool > finished(false);
+		pool.run([&]() {
+			pool.parallel_for(visits.size(), [&](size_t i) { visits[i] += 1; });
+			finished = true;
+		});
+		while (!finished) std::this_thread::yield();
+		bool ok = true;
+		for (auto const &v : visits) ok = ok && (v == 1);
+		check(ok, "parallel_for from inside a job visits every index exactly once");
+	}
+
+	{ //exceptions wait for running calls, then reach the caller:
+		bool caught_all = true, joined = true, caller_threw = false, worker_threw = false;
+		for (uint32_t round = 0; round < rounds; ++round) {
+			size_t count = 16;
+			size_t throw_at = round % count;
+			std::thread::id caller = std::this_thread::get_id();
+			std::atomic< uint32_t > running(0);
+			bool caught = false;
+			try {
+				pool.parallel_for(count, [&, throw_at](size_t i) {
+					running += 1;
+					if (i == throw_at) {
+						(std::this_thread::get_id() == caller ? caller_threw : worker_threw) = true;
+						running -= 1;
+						throw std::runtime_error("work " + std::to_string(i));
+					}
+					//(slow enough that other calls are still running when one throws)
+					std::this_thread::sleep_for(std::chrono::microseconds(200));
+					running -= 1;
+				});
+			} catch (std::runtime_error &e) {
+				caught = (std::string(e.what()) == "work " + std::to_string(throw_at));
+			}
+			if (running != 0) joined = false;
+			caught_all = caught_all && caught;
+		}
+		check(caught_all, "the exception thrown by work reaches the caller of parallel_for");
+		check(joined, "parallel_for waits for running calls before rethrowing");
+		check(caller_threw && worker_threw, "exceptions were thrown both on the calling thread and on workers");
+	}
+
+	if (failures) {
+		std::cout << failures << " check(s) FAILED." << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed." << std::endl;
+	return 0;
+}
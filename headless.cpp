@@ -0,0 +1,256 @@
+#include "headless.hpp"
+
+#include "Mode.hpp"
+#include "GL.hpp"
+#include "gl_errors.hpp"
+#include "load_save_png.hpp"
+#include "Profiler.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+char const *Headless::usage =
+	"Headless options (render offscreen and print timings):\n"
+	"\t--headless <frames>  draw this many frames without a window\n"
+	"\t--size <w>x<h>       framebuffer size (default 800x800)\n"
+	"\t--png <prefix>       save frames as <prefix>NNNN.png\n"
+	"\t--png-every <n>      ...every nth frame (default: just the last)\n";
+
+void Headless::parse(std::vector< std::string > *args_) {
+	assert(args_);
+	auto &args = *args_;
+
+	std::vector< std::string > remaining;
+	for (uint32_t i = 0; i < args.size(); ++i) {
+		std::string const &arg = args[i];
+		if (arg != "--headless" && arg != "--size" && arg != "--png" && arg != "--png-every") {
+			remaining.emplace_back(arg);
+			continue;
+		}
+		if (i + 1 >= args.size()) throw std::runtime_error("option '" + arg + "' needs a value");
+		std::string const &value = args[++i];
+		if (arg == "--png") {
+			png_prefix = value;
+			continue;
+		}
+		std::istringstream str(value);
+		char x = '\0';
+		if (arg == "--headless") {
+			enabled = true;
+			if (!(str >> frames) || frames == 0) throw std::runtime_error("expected a (positive) frame count after --headless, got '" + value + "'");
+		} else if (arg == "--size") {
+			if (!(str >> size.x >> x >> size.y) || x != 'x' || size.x == 0 || size.y == 0) throw std::runtime_error("expected <w>x<h> after --size, got '" + value + "'");
+		} else if (arg == "--png-every") {
+			if (!(str >> png_every)) throw std::runtime_error("expected a frame count after --png-every, got '" + value + "'");
+		}
+		if (str >> x) throw std::runtime_error("trailing characters in '" + value + "'");
+	}
+	args = remaining;
+}
+
+void Headless::init_video_driver() const {
+	if (!enabled) return;
+	//(not overwriting, so a driver set in the environment wins)
+	SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+}
+
+void Headless::run(std::function< void(float t) > const &set_camera) const {
+	OffscreenFramebuffer framebuffer(size);
+	GL_ERRORS();
+
+	std::cout << "Renderer: " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")" << std::endl;
+
+	//one timer query per frame; results are read after the run so the GPU never has to catch up mid-run:
+	std::vector< GLuint > queries(frames, 0);
+	glGenQueries(GLsizei(queries.size()), queries.data());
+
+	std::vector< double > cpu_ms(frames, 0.0);
+	std::vector< double > gpu_ms(frames, 0.0);
+
+	auto save_frame = [&](uint32_t frame) {
+		std::ostringstream filename;
+		filename << png_prefix << std::setw(4) << std::setfill('0') << frame << ".png";
+		std::vector< glm::u8vec4 > data = framebuffer.read_pixels();
+		for (auto &px : data) {
+			px.a = 0xff;
+		}
+		save_png(filename.str(), size, data.data(), LowerLeftOrigin);
+	};
+
+	//--- warm-up ---
+	//one untimed frame first, so first-use costs (driver shader compiles, lazy uploads, the first timer query) don't land in frame 0:
+	if (Mode::current) {
+		GLuint warm_up = 0;
+		glGenQueries(1, &warm_up);
+		set_camera(0.0f);
+		glBeginQuery(GL_TIME_ELAPSED, warm_up);
+		Mode::current->draw(size);
+		glEndQuery(GL_TIME_ELAPSED);
+		glFinish();
+		glDeleteQueries(1, &warm_up);
+	}
+
+	//--- draw frames ---
+	uint32_t drawn = 0; //(can be less than 'frames' if the mode exits early)
+	struct CounterTotals {
+		char const *name;
+		uint64_t sum, max;
+	};
+	std::vector< CounterTotals > counters; //(in the order they were first seen)
+	for (uint32_t frame = 0; frame < frames && Mode::current; ++frame) {
+		set_camera(frame / float(frames));
+
+		auto before = std::chrono::high_resolution_clock::now();
+		profiler.begin_frame();
+		glBeginQuery(GL_TIME_ELAPSED, queries[frame]);
+
+		//fixed timestep, so runs are repeatable:
+		Mode::current->update(1.0f / 60.0f);
+		if (Mode::current) Mode::current->draw(size);
+
+		glEndQuery(GL_TIME_ELAPSED);
+		profiler.end_frame();
+		auto after = std::chrono::high_resolution_clock::now();
+		cpu_ms[frame] = std::chrono::duration< double, std::milli >(after - before).count();
+		drawn = frame + 1;
+
+		//gather the frame's counters (e.g., Scene::draw's draw calls and triangles):
+		for (auto const &counter : profiler.frames[profiler.frame_index % Profiler::FrameCount].counters) {
+			auto f = std::find_if(counters.begin(), counters.end(), [&](CounterTotals const &c) { return c.name == counter.first; });
+			if (f == counters.end()) {
+				counters.emplace_back(CounterTotals{ counter.first, 0, 0 });
+				f = counters.end() - 1;
+			}
+			f->sum += counter.second;
+			f->max = std::max(f->max, counter.second);
+		}
+
+		if (png_prefix != "" && (png_every ? frame % png_every == 0 : frame + 1 == frames)) {
+			save_frame(frame);
+		}
+	}
+	glFinish();
+
+	cpu_ms.resize(drawn);
+	gpu_ms.resize(drawn);
+	for (uint32_t frame = 0; frame < drawn; ++frame) {
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(queries[frame], GL_QUERY_RESULT, &ns);
+		gpu_ms[frame] = ns / 1.0e6;
+	}
+	GL_ERRORS();
+
+	glDeleteQueries(GLsizei(queries.size()), queries.data());
+
+	//--- report ---
+	std::cout << "frame,cpu_ms,gpu_ms\n";
+	std::cout << std::fixed << std::setprecision(3);
+	for (uint32_t frame = 0; frame < drawn; ++frame) {
+		std::cout << frame << "," << cpu_ms[frame] << "," << gpu_ms[frame] << "\n";
+	}
+
+	if (drawn == 0) return;
+	auto summarize = [](std::vector< double > ms) {
+		std::sort(ms.begin(), ms.end());
+		double sum = 0.0;
+		for (double t : ms) sum += t;
+		std::ostringstream str;
+		str << std::fixed << std::setprecision(3)
+		    << "mean " << sum / ms.size() << " ms, median " << ms[ms.size() / 2] << " ms, max " << ms.back() << " ms";
+		return str.str();
+	};
+	std::cout << "CPU: " << summarize(cpu_ms) << "\n";
+	std::cout << "GPU: " << summarize(gpu_ms) << "\n";
+	for (auto const &counter : counters) {
+		std::cout << counter.name << " per frame: mean " << std::setprecision(1) << counter.sum / double(drawn) << ", max " << counter.max << "\n";
+	}
+	std::cout.flush();
+}
+
+OffscreenContext::OffscreenContext() {
+	//(not overwriting, so a driver set in the environment wins)
+	SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+	if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+		throw std::runtime_error(std::string("Error initializing SDL: ") + SDL_GetError());
+	}
+
+	//same context as the viewers ask for:
+	SDL_GL_ResetAttributes();
+	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+	SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+	window = SDL_CreateWindow("offscreen", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	if (!window) {
+		std::string error = SDL_GetError();
+		SDL_Quit();
+		throw std::runtime_error("Error creating SDL window: " + error);
+	}
+	context = SDL_GL_CreateContext(window);
+	if (!context) {
+		std::string error = SDL_GetError();
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		throw std::runtime_error("Error creating OpenGL context: " + error);
+	}
+
+	//On windows, load OpenGL entrypoints: (does nothing on other platforms)
+	init_GL();
+}
+
+OffscreenContext::~OffscreenContext() {
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+}
+
+OffscreenFramebuffer::OffscreenFramebuffer(glm::uvec2 size_) : size(size_) {
+	glGenRenderbuffers(1, &color_rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+	glGenRenderbuffers(1, &depth_rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth_rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.x, size.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &fb);
+	glBindFramebuffer(GL_FRAMEBUFFER, fb);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rb);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_rb);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &fb);
+		glDeleteRenderbuffers(1, &depth_rb);
+		glDeleteRenderbuffers(1, &color_rb);
+		throw std::runtime_error("offscreen framebuffer is incomplete");
+	}
+	glViewport(0, 0, size.x, size.y);
+}
+
+OffscreenFramebuffer::~OffscreenFramebuffer() {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &fb);
+	glDeleteRenderbuffers(1, &depth_rb);
+	glDeleteRenderbuffers(1, &color_rb);
+}
+
+std::vector< glm::u8vec4 > OffscreenFramebuffer::read_pixels() const {
+	std::vector< glm::u8vec4 > data(size.x * size.y);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fb);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+	return data;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+/*
+ * Headless mode for the viewers (show-scene, show-meshes):
+ * renders a fixed number of frames into an offscreen framebuffer instead of a window,
+ * optionally saving them as PNGs, and prints per-frame CPU and GPU timings.
+ *
+ * This is meant for automated performance runs on machines without a display:
+ *   show-scene --headless 200 --size 1280x720 --png out/frame- city.scene city.pnct
+ *
+ * The OpenGL context still comes from SDL, but from its "offscreen" video driver
+ * (EGL -- e.g., Mesa's llvmpipe on a machine with no GPU). Set the SDL_VIDEODRIVER
+ * environment variable to override the driver (e.g., 'x11' when running under xvfb).
+ */
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+struct Headless {
+	bool enabled = false; //set by '--headless'
+	uint32_t frames = 100; //number of frames to draw
+	glm::uvec2 size = glm::uvec2(800, 800); //framebuffer size, in pixels
+	std::string png_prefix = ""; //if not empty, frames are saved as <png_prefix>NNNN.png
+	uint32_t png_every = 0; //save every Nth frame (0 means 'just the last frame')
+
+	//removes headless options from 'args', leaving any other arguments in place:
+	// --headless <frames>  -- turn on headless mode and draw <frames> frames
+	// --size <w>x<h>       -- framebuffer size
+	// --png <prefix>       -- save frames as <prefix>NNNN.png
+	// --png-every <n>      -- ...every nth frame
+	//NOTE: throws on malformed options
+	void parse(std::vector< std::string > *args);
+
+	//help text for the above:
+	static char const *usage;
+
+	//call before SDL_Init() to select a video driver that doesn't need a display:
+	void init_video_driver() const;
+
+	//draw frames with Mode::current into an offscreen framebuffer:
+	// 'set_camera' is called before each frame with the fraction of the run completed (in [0,1)),
+	// so the caller can move its camera along a fixed path.
+	//Prints timings to std::cout, along with per-frame profiler counters (e.g., Scene::draw's draw calls; see Profiler.hpp).
+	//NOTE: throws if the framebuffer can't be created
+	void run(std::function< void(float t) > const &set_camera) const;
+};
+
+//OpenGL without a visible window, for windowless programs (benchmarks, checks) that draw on their own:
+// creates a hidden window with an OpenGL 3.3 core context, using the same video driver as headless mode
+// (so SDL_VIDEODRIVER overrides it here, too); call_load_functions() is left to the caller.
+//NOTE: throws if SDL, the window, or the context can't be started
+struct SDL_Window;
+struct OffscreenContext {
+	OffscreenContext();
+	~OffscreenContext();
+
+	OffscreenContext(OffscreenContext const &) = delete;
+	OffscreenContext &operator=(OffscreenContext const &) = delete;
+
+	SDL_Window *window = nullptr;
+	void *context = nullptr; //(an SDL_GLContext)
+};
+
+//framebuffer with RGBA8 color and 24-bit depth (+ stencil) renderbuffers:
+// binds it and sets the viewport to cover it on creation; deletes it (leaving framebuffer 0 bound) on destruction
+//NOTE: throws if the framebuffer is incomplete
+struct OffscreenFramebuffer {
+	OffscreenFramebuffer(glm::uvec2 size);
+	~OffscreenFramebuffer();
+
+	OffscreenFramebuffer(OffscreenFramebuffer const &) = delete;
+	OffscreenFramebuffer &operator=(OffscreenFramebuffer const &) = delete;
+
+	//read the color buffer (rows bottom to top, as with LowerLeftOrigin in load_save_png.hpp):
+	std::vector< glm::u8vec4 > read_pixels() const;
+
+	glm::uvec2 size;
+	GLuint color_rb = 0;
+	GLuint depth_rb = 0;
+	GLuint fb = 0;
+};
@@ -0,0 +1,160 @@
+//index-meshes converts a '.pnct' mesh file to indexed geometry:
+// - identical vertices within each mesh are welded into one
+// - triangles are reordered for the GPU's post-transform vertex cache (see vertex_cache.hpp)
+// - vertices are reordered by first use, so vertex fetches also walk through memory in order
+//
+//Usage:
+// index-meshes <in.pnct> <out.pnct>
+//
+//The output has chunks:
+// "pnct" -- welded vertices
+// "ind0" -- uint32 indices (absolute positions in the vertex chunk)
+// "str0" -- copied from the input
+// "idx0" -- each mesh's (welded) vertex range
+// "ixr0" -- each idx0 entry's { index_begin, index_end } range in ind0
+//
+//The result can be passed through quantize-meshes as well.
+
+#include "read_write_chunk.hpp"
+#include "vertex_cache.hpp"
+
+#include <glm/glm.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Vertex {
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::u8vec4 Color;
+	glm::vec2 TexCoord;
+};
+static_assert(sizeof(Vertex) == 3*4+3*4+4*1+2*4, "Vertex is packed.");
+
+struct IndexEntry {
+	uint32_t name_begin, name_end;
+	uint32_t vertex_begin, vertex_end;
+};
+static_assert(sizeof(IndexEntry) == 16, "Index entry should be packed");
+
+struct IndexRange {
+	uint32_t index_begin, index_end;
+};
+static_assert(sizeof(IndexRange) == 8, "Index range should be packed");
+
+int main(int argc, char **argv) {
+	if (argc != 3) {
+		std::cerr << "Usage:\n\t" << argv[0] << " <in.pnct> <out.pnct>\nWrites an indexed, vertex-cache-optimized copy of a mesh file." << std::endl;
+		return 1;
+	}
+	std::string in_file = argv[1];
+	std::string out_file = argv[2];
+
+	try {
+		std::vector< Vertex > vertices;
+		std::vector< char > strings;
+		std::vector< IndexEntry > index;
+		{
+			std::ifstream file(in_file, std::ios::binary);
+			if (!file) throw std::runtime_error("failed to open '" + in_file + "'");
+			read_chunk(file, "pnct", &vertices);
+			read_chunk(file, "str0", &strings);
+			read_chunk(file, "idx0", &index);
+		}
+
+		std::vector< Vertex > out_vertices;
+		std::vector< uint32_t > out_indices;
+		std::vector< IndexEntry > out_index = index;
+		std::vector< IndexRange > out_ranges(index.size());
+
+		float acmr_welded = 0.0f; //(summed over triangles, before reordering)
+		float acmr_optimized = 0.0f; //(...and after)
+
+		//meshes that share a vertex range share the result:
+		std::map< std::pair< uint32_t, uint32_t >, uint32_t > converted;
+
+		for (uint32_t m = 0; m < index.size(); ++m) {
+			IndexEntry const &entry = index[m];
+			if (!(entry.vertex_begin <= entry.vertex_end && entry.vertex_end <= vertices.size())) {
+				throw std::runtime_error("index entry has out-of-range vertex start/count");
+			}
+			if ((entry.vertex_end - entry.vertex_begin) % 3 != 0) {
+				throw std::runtime_error("mesh vertex count isn't a multiple of three (not a triangle list?)");
+			}
+
+			auto f = converted.find(std::make_pair(entry.vertex_begin, entry.vertex_end));
+			if (f != converted.end()) {
+				out_index[m].vertex_begin = out_index[f->second].vertex_begin;
+				out_index[m].vertex_end = out_index[f->second].vertex_end;
+				out_ranges[m] = out_ranges[f->second];
+				continue;
+			}
+			converted.emplace(std::make_pair(entry.vertex_begin, entry.vertex_end), m);
+
+			//weld byte-identical vertices:
+			std::vector< Vertex > welded;
+			std::vector< uint32_t > indices;
+			{
+				std::unordered_map< std::string, uint32_t > lookup;
+				for (uint32_t v = entry.vertex_begin; v < entry.vertex_end; ++v) {
+					std::string key(reinterpret_cast< char const * >(&vertices[v]), sizeof(Vertex));
+					auto inserted = lookup.emplace(key, uint32_t(welded.size()));
+					if (inserted.second) welded.emplace_back(vertices[v]);
+					indices.emplace_back(inserted.first->second);
+				}
+			}
+
+			uint32_t triangles = uint32_t(indices.size() / 3);
+			acmr_welded += compute_acmr(indices.data(), indices.size()) * triangles;
+
+			optimize_vertex_cache(indices.data(), indices.size(), uint32_t(welded.size()));
+
+			acmr_optimized += compute_acmr(indices.data(), indices.size()) * triangles;
+
+			//store vertices in the order they are first used:
+			uint32_t base = uint32_t(out_vertices.size());
+			std::vector< uint32_t > remap(welded.size(), -1U);
+			for (auto &i : indices) {
+				if (remap[i] == -1U) {
+					remap[i] = uint32_t(out_vertices.size()) - base;
+					out_vertices.emplace_back(welded[i]);
+				}
+				i = base + remap[i];
+			}
+
+			out_index[m].vertex_begin = base;
+			out_index[m].vertex_end = uint32_t(out_vertices.size());
+			out_ranges[m].index_begin = uint32_t(out_indices.size());
+			out_indices.insert(out_indices.end(), indices.begin(), indices.end());
+			out_ranges[m].index_end = uint32_t(out_indices.size());
+		}
+
+		{
+			std::ofstream file(out_file, std::ios::binary);
+			write_chunk("pnct", out_vertices, &file);
+			write_chunk("ind0", out_indices, &file);
+			write_chunk("str0", strings, &file);
+			write_chunk("idx0", out_index, &file);
+			write_chunk("ixr0", out_ranges, &file);
+			if (!file) throw std::runtime_error("failed to write '" + out_file + "'");
+		}
+
+		float triangles = float(out_indices.size() / 3);
+		std::cout << "Indexed " << index.size() << " meshes:\n"
+		          << "  vertices: " << vertices.size() << " -> " << out_vertices.size() << " (+ " << out_indices.size() << " indices)\n"
+		          << "  bytes: " << vertices.size() * sizeof(Vertex) << " -> " << out_vertices.size() * sizeof(Vertex) + out_indices.size() * sizeof(uint32_t) << "\n"
+		          << "  ACMR (" << VertexCacheSize << "-entry FIFO): 3.00 unindexed, "
+		          << (triangles ? acmr_welded / triangles : 0.0f) << " welded, "
+		          << (triangles ? acmr_optimized / triangles : 0.0f) << " optimized" << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -1,10 +1,12 @@
 #include "load_save_png.hpp"
+#include "MappedFile.hpp"
 
 #include <png.h>
 
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <memory>
 #include <vector>
 
 #define LOG_ERROR( X ) std::cerr << X << std::endl
@@ -17,10 +19,14 @@ void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin) {
 	assert(size);
 
-	std::ifstream file(filename.c_str(), std::ios::binary);
-	if (!file) {
+	//(reading through MappedFile means the image may come from a mounted Pack)
+	std::unique_ptr< MappedFile > mapped;
+	try {
+		mapped.reset(new MappedFile(filename));
+	} catch (std::exception &) {
 		throw std::runtime_error("Failed to open PNG image file '" + filename + "'.");
 	}
+	MappedFileStream file(*mapped);
 	if (!load_png(file, &size->x, &size->y, data, origin)) {
 		throw std::runtime_error("Failed to read PNG image from '" + filename + "'.");
 	}
@@ -0,0 +1,429 @@
+//lod-meshes adds simplified levels of detail to an indexed '.pnct' mesh file (as written by index-meshes):
+// each mesh is simplified with quadric error metrics (Garland & Heckbert), by collapsing
+// edges onto existing vertices, so every level is just another range of indices into the same vertices.
+//
+//Usage:
+// lod-meshes <in.pnct> <out.pnct>
+//
+//The output has the chunks of the input, with:
+// "ind0" -- extended with the indices of every level
+// "lod0" -- { mesh, index_begin, index_end, error } for each level, finest first for each mesh
+//           (mesh is an idx0 entry; error is relative to the radius of the mesh's bounds)
+//
+//The result can be passed through quantize-meshes as well.
+
+#include "read_write_chunk.hpp"
+#include "vertex_cache.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+struct Vertex {
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::u8vec4 Color;
+	glm::vec2 TexCoord;
+};
+static_assert(sizeof(Vertex) == 3*4+3*4+4*1+2*4, "Vertex is packed.");
+
+struct IndexEntry {
+	uint32_t name_begin, name_end;
+	uint32_t vertex_begin, vertex_end;
+};
+static_assert(sizeof(IndexEntry) == 16, "Index entry should be packed");
+
+struct IndexRange {
+	uint32_t index_begin, index_end;
+};
+static_assert(sizeof(IndexRange) == 8, "Index range should be packed");
+
+struct LODEntry {
+	uint32_t mesh;
+	uint32_t index_begin, index_end;
+	float error;
+};
+static_assert(sizeof(LODEntry) == 16, "LOD entry should be packed");
+
+//levels to make (each has about half the triangles of the one before):
+constexpr uint32_t LODLevels = 3;
+//stop simplifying once collapses would move the surface more than this (relative to the radius of the mesh's bounds):
+constexpr double MaxError = 0.25;
+//how much more collapses that move open boundaries cost:
+constexpr double BoundaryWeight = 10.0;
+
+//sum of squared distances to a set of planes, stored as the upper triangle of a symmetric 4x4 matrix:
+struct Quadric {
+	double xx = 0.0, xy = 0.0, xz = 0.0, xw = 0.0;
+	double yy = 0.0, yz = 0.0, yw = 0.0;
+	double zz = 0.0, zw = 0.0;
+	double ww = 0.0;
+
+	//add plane dot(n, x) + d == 0 (n should be unit-length):
+	void add_plane(glm::dvec3 const &n, double d, double weight) {
+		xx += weight * n.x * n.x; xy += weight * n.x * n.y; xz += weight * n.x * n.z; xw += weight * n.x * d;
+		yy += weight * n.y * n.y; yz += weight * n.y * n.z; yw += weight * n.y * d;
+		zz += weight * n.z * n.z; zw += weight * n.z * d;
+		ww += weight * d * d;
+	}
+	Quadric &operator+=(Quadric const &o) {
+		xx += o.xx; xy += o.xy; xz += o.xz; xw += o.xw;
+		yy += o.yy; yz += o.yz; yw += o.yw;
+		zz += o.zz; zw += o.zw;
+		ww += o.ww;
+		return *this;
+	}
+	double error(glm::dvec3 const &p) const {
+		return xx * p.x * p.x + 2.0 * xy * p.x * p.y + 2.0 * xz * p.x * p.z + 2.0 * xw * p.x
+		     + yy * p.y * p.y + 2.0 * yz * p.y * p.z + 2.0 * yw * p.y
+		     + zz * p.z * p.z + 2.0 * zw * p.z
+		     + ww;
+	}
+};
+
+//simplify the triangles 'indices' (which use vertices [vertex_begin, vertex_end)) into up to LODLevels coarser versions:
+// appends the index list and (relative) error of each level to *levels / *errors
+static void make_lods(std::vector< Vertex > const &vertices, uint32_t vertex_begin, uint32_t vertex_end,
+	std::vector< uint32_t > const &indices, std::vector< std::vector< uint32_t > > *levels, std::vector< float > *errors) {
+
+	if (indices.size() < 3 * 8) return; //(not worth it)
+
+	//--- topology is tracked by position, so vertices split by normals or texcoords stay connected ---
+	std::vector< uint32_t > position_of(vertex_end - vertex_begin); //vertex => position id
+	std::vector< glm::dvec3 > positions; //position id => location
+	std::vector< std::vector< uint32_t > > position_vertices; //position id => vertices there
+	{
+		std::map< std::tuple< float, float, float >, uint32_t > lookup;
+		for (uint32_t v = vertex_begin; v < vertex_end; ++v) {
+			glm::vec3 const &p = vertices[v].Position;
+			auto inserted = lookup.emplace(std::make_tuple(p.x, p.y, p.z), uint32_t(positions.size()));
+			if (inserted.second) {
+				positions.emplace_back(p);
+				position_vertices.emplace_back();
+			}
+			position_of[v - vertex_begin] = inserted.first->second;
+			position_vertices[inserted.first->second].emplace_back(v);
+		}
+	}
+
+	double radius;
+	{
+		glm::dvec3 min = positions[0], max = positions[0];
+		for (auto const &p : positions) {
+			min = glm::min(min, p);
+			max = glm::max(max, p);
+		}
+		radius = 0.5 * glm::length(max - min);
+		if (radius == 0.0) return;
+	}
+
+	uint32_t triangle_count = uint32_t(indices.size() / 3);
+	std::vector< uint32_t > corners(indices.size()); //position id at each corner (updated by collapses)
+	for (size_t i = 0; i < indices.size(); ++i) {
+		corners[i] = position_of[indices[i] - vertex_begin];
+	}
+	std::vector< bool > triangle_alive(triangle_count, true);
+	std::vector< std::vector< uint32_t > > position_triangles(positions.size());
+	for (uint32_t t = 0; t < triangle_count; ++t) {
+		uint32_t const *c = &corners[3*t];
+		if (c[0] == c[1] || c[1] == c[2] || c[2] == c[0]) {
+			triangle_alive[t] = false; //already degenerate
+			continue;
+		}
+		for (uint32_t i = 0; i < 3; ++i) position_triangles[c[i]].emplace_back(t);
+	}
+	uint32_t alive_count = uint32_t(std::count(triangle_alive.begin(), triangle_alive.end(), true));
+
+	//--- quadrics: planes of adjacent triangles, plus planes that hold open boundaries in place ---
+	std::vector< Quadric > quadrics(positions.size());
+	std::map< std::pair< uint32_t, uint32_t >, uint32_t > edge_uses;
+	for (uint32_t t = 0; t < triangle_count; ++t) {
+		if (!triangle_alive[t]) continue;
+		uint32_t const *c = &corners[3*t];
+		glm::dvec3 n = glm::cross(positions[c[1]] - positions[c[0]], positions[c[2]] - positions[c[0]]);
+		if (glm::length(n) == 0.0) continue;
+		n = glm::normalize(n);
+		for (uint32_t i = 0; i < 3; ++i) {
+			quadrics[c[i]].add_plane(n, -glm::dot(n, positions[c[0]]), 1.0);
+			edge_uses[std::minmax(c[i], c[(i+1)%3])] += 1;
+		}
+	}
+	for (uint32_t t = 0; t < triangle_count; ++t) {
+		if (!triangle_alive[t]) continue;
+		uint32_t const *c = &corners[3*t];
+		glm::dvec3 n = glm::cross(positions[c[1]] - positions[c[0]], positions[c[2]] - positions[c[0]]);
+		for (uint32_t i = 0; i < 3; ++i) {
+			uint32_t a = c[i], b = c[(i+1)%3];
+			if (edge_uses[std::minmax(a, b)] != 1) continue;
+			glm::dvec3 perpendicular = glm::cross(positions[b] - positions[a], n);
+			if (glm::length(perpendicular) == 0.0) continue;
+			perpendicular = glm::normalize(perpendicular);
+			double d = -glm::dot(perpendicular, positions[a]);
+			quadrics[a].add_plane(perpendicular, d, BoundaryWeight);
+			quadrics[b].add_plane(perpendicular, d, BoundaryWeight);
+		}
+	}
+
+	//--- collapses, cheapest first ---
+	struct Collapse {
+		double cost;
+		uint32_t from, to;
+		uint32_t from_version, to_version; //(collapse is stale if either position has changed since)
+		bool operator>(Collapse const &o) const { return cost > o.cost; }
+	};
+	std::priority_queue< Collapse, std::vector< Collapse >, std::greater< Collapse > > queue;
+	std::vector< uint32_t > version(positions.size(), 0);
+	std::vector< bool > position_alive(positions.size(), true);
+
+	auto push = [&](uint32_t from, uint32_t to) {
+		Quadric q = quadrics[from];
+		q += quadrics[to];
+		queue.push(Collapse{ std::max(0.0, q.error(positions[to])), from, to, version[from], version[to] });
+	};
+	for (auto const &eu : edge_uses) {
+		push(eu.first.first, eu.first.second);
+		push(eu.first.second, eu.first.first);
+	}
+
+	//would collapsing 'from' onto 'to' flip (or squash) any remaining triangle?
+	auto flips = [&](uint32_t from, uint32_t to) {
+		for (uint32_t t : position_triangles[from]) {
+			if (!triangle_alive[t]) continue;
+			uint32_t const *c = &corners[3*t];
+			if (c[0] == to || c[1] == to || c[2] == to) continue; //(will be removed)
+			glm::dvec3 p[3], moved[3];
+			for (uint32_t i = 0; i < 3; ++i) {
+				p[i] = positions[c[i]];
+				moved[i] = (c[i] == from ? positions[to] : p[i]);
+			}
+			glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+			glm::dvec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+			if (glm::dot(before, after) <= 0.0) return true;
+		}
+		return false;
+	};
+
+	double max_cost = (MaxError * radius) * (MaxError * radius);
+	double reached_cost = 0.0;
+	uint32_t previous_count = alive_count;
+
+	for (uint32_t level = 0; level < LODLevels; ++level) {
+		uint32_t target = previous_count / 2;
+		bool exhausted = false;
+		while (alive_count > target) {
+			if (queue.empty()) {
+				exhausted = true;
+				break;
+			}
+			Collapse collapse = queue.top();
+			queue.pop();
+			uint32_t from = collapse.from, to = collapse.to;
+			if (!position_alive[from] || !position_alive[to]) continue;
+			if (version[from] != collapse.from_version || version[to] != collapse.to_version) continue;
+			if (collapse.cost > max_cost) {
+				exhausted = true;
+				break;
+			}
+			if (flips(from, to)) continue; //(may become possible later, in which case neighbors re-push it)
+
+			//collapse:
+			for (uint32_t t : position_triangles[from]) {
+				if (!triangle_alive[t]) continue;
+				uint32_t *c = &corners[3*t];
+				if (c[0] == to || c[1] == to || c[2] == to) {
+					triangle_alive[t] = false;
+					alive_count -= 1;
+				} else {
+					for (uint32_t i = 0; i < 3; ++i) {
+						if (c[i] == from) c[i] = to;
+					}
+					position_triangles[to].emplace_back(t);
+				}
+			}
+			position_triangles[from].clear();
+			position_alive[from] = false;
+			quadrics[to] += quadrics[from];
+			version[to] += 1;
+			reached_cost = std::max(reached_cost, collapse.cost);
+
+			//re-cost edges around 'to':
+			auto &around = position_triangles[to];
+			around.erase(std::remove_if(around.begin(), around.end(), [&](uint32_t t){ return !triangle_alive[t]; }), around.end());
+			std::vector< uint32_t > neighbors;
+			for (uint32_t t : around) {
+				for (uint32_t i = 0; i < 3; ++i) {
+					if (corners[3*t+i] != to) neighbors.emplace_back(corners[3*t+i]);
+				}
+			}
+			std::sort(neighbors.begin(), neighbors.end());
+			neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+			for (uint32_t n : neighbors) {
+				push(n, to);
+				push(to, n);
+			}
+		}
+
+		//not worth keeping a level that is barely simpler than the last:
+		if (alive_count == 0 || alive_count > previous_count * 9 / 10) break;
+		previous_count = alive_count;
+
+		//--- write out level, picking the closest-matching vertex at each corner's new position ---
+		std::vector< uint32_t > level_indices;
+		level_indices.reserve(3 * alive_count);
+		for (uint32_t t = 0; t < triangle_count; ++t) {
+			if (!triangle_alive[t]) continue;
+			for (uint32_t i = 0; i < 3; ++i) {
+				uint32_t original = indices[3*t+i];
+				uint32_t position = corners[3*t+i];
+				if (position_of[original - vertex_begin] == position) {
+					level_indices.emplace_back(original);
+					continue;
+				}
+				Vertex const &want = vertices[original];
+				uint32_t best = position_vertices[position][0];
+				float best_score = -std::numeric_limits< float >::infinity();
+				for (uint32_t v : position_vertices[position]) {
+					Vertex const &have = vertices[v];
+					float score = glm::dot(have.Normal, want.Normal) - glm::length(have.TexCoord - want.TexCoord)
+					            - glm::length(glm::vec4(have.Color) - glm::vec4(want.Color)) / 255.0f;
+					if (score > best_score) {
+						best_score = score;
+						best = v;
+					}
+				}
+				level_indices.emplace_back(best);
+			}
+		}
+
+		//order for the vertex cache (which works on indices relative to vertex_begin):
+		for (auto &i : level_indices) i -= vertex_begin;
+		optimize_vertex_cache(level_indices.data(), level_indices.size(), vertex_end - vertex_begin);
+		for (auto &i : level_indices) i += vertex_begin;
+
+		levels->emplace_back(std::move(level_indices));
+		errors->emplace_back(float(std::sqrt(reached_cost) / radius));
+
+		if (exhausted) break;
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc != 3) {
+		std::cerr << "Usage:\n\t" << argv[0] << " <in.pnct> <out.pnct>\nWrites a copy of an indexed mesh file (see index-meshes) with simplified levels of detail." << std::endl;
+		return 1;
+	}
+	std::string in_file = argv[1];
+	std::string out_file = argv[2];
+
+	try {
+		std::vector< Vertex > vertices;
+		std::vector< uint32_t > indices;
+		std::vector< char > strings;
+		std::vector< IndexEntry > index;
+		std::vector< IndexRange > ranges;
+		{
+			std::ifstream file(in_file, std::ios::binary);
+			if (!file) throw std::runtime_error("failed to open '" + in_file + "'");
+			read_chunk(file, "pnct", &vertices);
+			try {
+				read_chunk(file, "ind0", &indices);
+			} catch (std::runtime_error &) {
+				throw std::runtime_error("'" + in_file + "' doesn't have indices (run index-meshes on it first)");
+			}
+			read_chunk(file, "str0", &strings);
+			read_chunk(file, "idx0", &index);
+			read_chunk(file, "ixr0", &ranges);
+		}
+		if (ranges.size() != index.size()) {
+			throw std::runtime_error("index ranges don't match meshes");
+		}
+
+		std::vector< uint32_t > out_indices = indices;
+		std::vector< LODEntry > lods;
+
+		//meshes that share an index range share levels:
+		std::map< std::pair< uint32_t, uint32_t >, std::vector< LODEntry > > made;
+
+		uint64_t full_triangles = 0;
+		uint64_t level_triangles[LODLevels] = {0};
+		for (uint32_t m = 0; m < index.size(); ++m) {
+			IndexEntry const &entry = index[m];
+			IndexRange const &range = ranges[m];
+			if (!(entry.vertex_begin <= entry.vertex_end && entry.vertex_end <= vertices.size())) {
+				throw std::runtime_error("index entry has out-of-range vertex start/count");
+			}
+			if (!(range.index_begin <= range.index_end && range.index_end <= indices.size() && (range.index_end - range.index_begin) % 3 == 0)) {
+				throw std::runtime_error("index range has out-of-range begin/end");
+			}
+
+			auto key = std::make_pair(range.index_begin, range.index_end);
+			auto f = made.find(key);
+			if (f == made.end()) {
+				std::vector< uint32_t > mesh_indices(indices.begin() + range.index_begin, indices.begin() + range.index_end);
+				for (uint32_t i : mesh_indices) {
+					if (!(entry.vertex_begin <= i && i < entry.vertex_end)) {
+						throw std::runtime_error("index refers to a vertex outside of its mesh");
+					}
+				}
+				std::vector< std::vector< uint32_t > > levels;
+				std::vector< float > errors;
+				make_lods(vertices, entry.vertex_begin, entry.vertex_end, mesh_indices, &levels, &errors);
+
+				std::vector< LODEntry > entries;
+				for (uint32_t l = 0; l < levels.size(); ++l) {
+					LODEntry lod;
+					lod.index_begin = uint32_t(out_indices.size());
+					out_indices.insert(out_indices.end(), levels[l].begin(), levels[l].end());
+					lod.index_end = uint32_t(out_indices.size());
+					lod.error = errors[l];
+					entries.emplace_back(lod);
+				}
+				f = made.emplace(key, entries).first;
+
+				full_triangles += mesh_indices.size() / 3;
+				for (uint32_t l = 0; l < LODLevels; ++l) {
+					//(meshes that stop early count their coarsest level for the rest)
+					LODEntry const *lod = (entries.empty() ? nullptr : &entries[std::min< size_t >(l, entries.size() - 1)]);
+					level_triangles[l] += (lod ? (lod->index_end - lod->index_begin) : mesh_indices.size()) / 3;
+				}
+			}
+			for (LODEntry lod : f->second) {
+				lod.mesh = m;
+				lods.emplace_back(lod);
+			}
+		}
+
+		{
+			std::ofstream file(out_file, std::ios::binary);
+			write_chunk("pnct", vertices, &file);
+			write_chunk("ind0", out_indices, &file);
+			write_chunk("str0", strings, &file);
+			write_chunk("idx0", index, &file);
+			write_chunk("ixr0", ranges, &file);
+			write_chunk("lod0", lods, &file);
+			if (!file) throw std::runtime_error("failed to write '" + out_file + "'");
+		}
+
+		std::cout << "Made " << lods.size() << " levels of detail for " << index.size() << " meshes:\n"
+		          << "  full detail: " << full_triangles << " triangles\n";
+		for (uint32_t l = 0; l < LODLevels; ++l) {
+			std::cout << "  level " << (l + 1) << ": " << level_triangles[l] << " triangles\n";
+		}
+		std::cout << "  indices: " << indices.size() << " -> " << out_indices.size() << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
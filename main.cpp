@@ -7,17 +7,25 @@
 //For asset loading:
 #include "Load.hpp"
 
+//Packed assets are mounted at startup, if present:
+#include "Pack.hpp"
+#include "data_path.hpp"
+
 //GL.hpp will include a non-namespace-polluting set of opengl prototypes:
 #include "GL.hpp"
 
 //for screenshots:
 #include "load_save_png.hpp"
 
+//for frame timing (overlay on F3, trace dump on F4):
+#include "Profiler.hpp"
+
 //Includes for libSDL:
 #include <SDL.h>
 
 //...and for c++ standard library functions:
 #include <chrono>
+#include <fstream>
 #include <iostream>
 #include <stdexcept>
 #include <memory>
@@ -103,7 +111,12 @@ int main(int argc, char **argv) {
 	//SDL_ShowCursor(SDL_DISABLE);
 
 	//------------ load assets --------------
+	//if the assets have been packed (see pack-assets.cpp), read them from the pack instead of from separate files:
+	if (std::ifstream(data_path("assets.pack"))) {
+		Pack::mount(data_path("assets.pack"), data_path(""));
+	}
 	call_load_functions();
+	print_load_timings(std::cout);
 
 	//------------ create game mode + make current --------------
 	Mode::set_current(std::make_shared< PlayMode >());
@@ -129,8 +142,10 @@ int main(int argc, char **argv) {
 	while (Mode::current) {
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
+		profiler.begin_frame();
 
 		{ //(1) process any events that are pending
+			PROFILE_SCOPE("events");
 			static SDL_Event evt;
 			while (SDL_PollEvent(&evt) == 1) {
 				//handle resizing:
@@ -157,32 +172,78 @@ int main(int argc, char **argv) {
 						px.a = 0xff;
 					}
 					save_png(filename, glm::uvec2(w,h), data.data(), LowerLeftOrigin);
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F3) {
+					// --- profiler overlay key ---
+					profiler.show_overlay = !profiler.show_overlay;
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F4) {
+					// --- profiler trace key ---
+					std::string filename = "trace.json";
+					std::cout << "Saving last " << Profiler::FrameCount << " frames of timings to '" << filename << "'." << std::endl;
+					try {
+						profiler.write_trace(filename);
+					} catch (std::exception &e) {
+						std::cerr << "ERROR: " << e.what() << std::endl;
+					}
 				}
 			}
 			if (!Mode::current) break;
 		}
 
 		{ //(2) call the current mode's "update" function to deal with elapsed time:
+			PROFILE_SCOPE("update");
 			auto current_time = std::chrono::high_resolution_clock::now();
 			static auto previous_time = current_time;
 			float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
 			previous_time = current_time;
 
-			//if frames are taking a very long time to process,
-			//lag to avoid spiral of death:
-			elapsed = std::min(0.1f, elapsed);
+			if (Mode::current->fixed_timestep > 0.0f) {
+				//fixed-step mode: run as many steps as real time calls for, carrying the remainder to the next frame:
+				static Mode const *accumulating_mode = nullptr;
+				static float accumulator = 0.0f;
+				if (accumulating_mode != Mode::current.get()) {
+					//(new mode -- start fresh)
+					accumulating_mode = Mode::current.get();
+					accumulator = 0.0f;
+				}
+				float step = Mode::current->fixed_timestep;
 
-			Mode::current->update(elapsed);
-			if (!Mode::current) break;
+				//if frames are taking a very long time to process,
+				//lag to avoid spiral of death:
+				accumulator = std::min(accumulator + elapsed, step * Mode::current->max_steps_per_frame);
+
+				std::shared_ptr< Mode > mode = Mode::current; //(stop stepping if the mode changes)
+				while (accumulator >= step && Mode::current == mode) {
+					Mode::current->update(step);
+					accumulator -= step;
+				}
+				if (!Mode::current) break;
+				Mode::current->draw_alpha = (Mode::current == mode ? accumulator / step : 1.0f);
+			} else {
+				//if frames are taking a very long time to process,
+				//lag to avoid spiral of death:
+				elapsed = std::min(0.1f, elapsed);
+
+				Mode::current->update(elapsed);
+				if (!Mode::current) break;
+				Mode::current->draw_alpha = 1.0f;
+			}
 		}
 
 		{ //(3) call the current mode's "draw" function to produce output:
-		
+			PROFILE_GPU_SCOPE("draw");
 			Mode::current->draw(drawable_size);
 		}
 
-		//Wait until the recently-drawn frame is shown before doing it all again:
-		SDL_GL_SwapWindow(window);
+		if (profiler.show_overlay) {
+			PROFILE_SCOPE("profiler overlay");
+			profiler.draw_overlay(drawable_size);
+		}
+
+		{ //Wait until the recently-drawn frame is shown before doing it all again:
+			PROFILE_SCOPE("swap");
+			SDL_GL_SwapWindow(window);
+		}
+		profiler.end_frame();
 	}
 
 
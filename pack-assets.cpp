@@ -0,0 +1,72 @@
+//pack-assets gathers asset files into a single pack (see Pack.hpp), which the game mounts at startup
+// so that its assets load from one mapped file instead of many separate ones.
+//
+//Usage:
+// pack-assets [--deflate] <out.pack> <directory> <file> [file ...]
+//
+//Each file is read from <directory>/<file> and stored under the name <file> (use '/' between path components),
+// which is how it is found when the pack is mounted on <directory> -- e.g., for the game:
+//
+// pack-assets dist/assets.pack dist bird.pnct bird.scene
+//
+//By default, files are stored as-is, so they're used in place from the mapped pack.
+//With --deflate, files are compressed if that saves at least an eighth of their size -- which makes the pack
+// smaller (bird.pnct: 3.0MB -> 0.6MB), but inflating (~200MB/s) is slower than reading from a local disk,
+// so only use it when the pack's size matters more than load time (e.g., for downloads or slow storage).
+
+#include "Pack.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	bool deflate = false;
+	int first = 1;
+	if (argc > 1 && std::string(argv[1]) == "--deflate") {
+		deflate = true;
+		first = 2;
+	}
+	if (argc - first < 3) {
+		std::cerr << "Usage:\n\t" << argv[0] << " [--deflate] <out.pack> <directory> <file> [file ...]" << std::endl;
+		return 1;
+	}
+	std::string out_file = argv[first];
+	std::string directory = argv[first+1];
+
+	try {
+		std::vector< std::pair< std::string, std::vector< char > > > files;
+		for (int arg = first + 2; arg < argc; ++arg) {
+			std::string name = argv[arg];
+			std::string path = directory + "/" + name;
+			std::ifstream file(path, std::ios::binary);
+			if (!file) throw std::runtime_error("failed to open '" + path + "'.");
+			files.emplace_back(name, std::vector< char >((std::istreambuf_iterator< char >(file)), std::istreambuf_iterator< char >()));
+		}
+
+		std::vector< char > data = Pack::build(std::move(files), deflate);
+
+		std::ofstream out(out_file, std::ios::binary);
+		out.write(data.data(), std::streamsize(data.size()));
+		if (!out) throw std::runtime_error("failed to write '" + out_file + "'.");
+		out.close();
+
+		//(read the pack back to report what went into it)
+		Pack pack(out_file);
+		for (uint32_t i = 0; i < pack.entries_count; ++i) {
+			Pack::Entry const &entry = pack.entries[i];
+			std::cout << "  " << pack.name(entry) << ": " << entry.size << " bytes";
+			if (entry.compression == Pack::Deflate) std::cout << " (deflated to " << entry.stored_size << ")";
+			std::cout << std::endl;
+		}
+		std::cout << "Packed " << pack.entries_count << " files into '" << out_file << "' (" << data.size() << " bytes)." << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,225 @@
+//quantize-meshes converts a '.pnct' mesh file to the compact (quantized) vertex format MeshBuffer also reads:
+// - positions: 16-bit normalized integers, relative to the bounds of each mesh
+// - normals: octahedral encoding, 2 x 16-bit normalized integers
+// - colors: unchanged (4 x 8-bit)
+// - texcoords: half floats
+//
+//Usage:
+// quantize-meshes <in.pnct> <out.pnct>
+//
+//The output has chunks:
+// "pnq0" -- quantized vertices (20 bytes each, vs. 36 for "pnct")
+// "ind0" -- (if input is indexed) copied from the input
+// "str0", "idx0" -- copied from the input
+// "ixr0", "lod0" -- (if input has them) copied from the input
+// "qdc0" -- position decoding { vec3 offset, scale } for each idx0 entry (see Mesh::position_offset)
+
+#include "read_write_chunk.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct Vertex {
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::u8vec4 Color;
+	glm::vec2 TexCoord;
+};
+static_assert(sizeof(Vertex) == 3*4+3*4+4*1+2*4, "Vertex is packed.");
+
+//must match MeshBuffer's QuantizedVertex:
+struct QuantizedVertex {
+	glm::i16vec4 Position;
+	glm::i16vec2 Normal;
+	glm::u8vec4 Color;
+	glm::u16vec2 TexCoord;
+};
+static_assert(sizeof(QuantizedVertex) == 4*2+2*2+4*1+2*2, "QuantizedVertex is packed.");
+
+struct IndexEntry {
+	uint32_t name_begin, name_end;
+	uint32_t vertex_begin, vertex_end;
+};
+static_assert(sizeof(IndexEntry) == 16, "Index entry should be packed");
+
+struct Decode {
+	glm::vec3 offset;
+	glm::vec3 scale;
+};
+static_assert(sizeof(Decode) == 24, "Decode entry should be packed");
+
+//[-1,1] => 16-bit normalized integer (the way OpenGL decodes GL_SHORT with normalized = GL_TRUE):
+static int16_t to_snorm16(float value) {
+	return int16_t(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+static float from_snorm16(int16_t value) {
+	return std::max(value / 32767.0f, -1.0f);
+}
+
+//octahedral encoding of a unit vector (decoded by mesh_normal() in mesh_vertex_glsl):
+static glm::vec2 oct_encode(glm::vec3 n) {
+	n /= (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+	glm::vec2 e = glm::vec2(n.x, n.y);
+	if (n.z < 0.0f) {
+		e = glm::vec2(
+			(1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f)
+		);
+	}
+	return e;
+}
+static glm::vec3 oct_decode(glm::vec2 e) {
+	glm::vec3 n = glm::vec3(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+	if (n.z < 0.0f) {
+		n.x = (1.0f - std::abs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f);
+		n.y = (1.0f - std::abs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return glm::normalize(n);
+}
+
+int main(int argc, char **argv) {
+	if (argc != 3) {
+		std::cerr << "Usage:\n\t" << argv[0] << " <in.pnct> <out.pnct>\nWrites a quantized copy of a mesh file." << std::endl;
+		return 1;
+	}
+	std::string in_file = argv[1];
+	std::string out_file = argv[2];
+
+	try {
+		std::vector< Vertex > vertices;
+		std::vector< char > strings;
+		std::vector< IndexEntry > index;
+		//(indexed files, from index-meshes / lod-meshes, also have these -- which are passed through unchanged)
+		bool indexed = false;
+		std::vector< uint32_t > indices;
+		std::vector< glm::uvec2 > index_ranges;
+		bool has_lods = false;
+		std::vector< glm::uvec4 > lods;
+		{
+			std::ifstream file(in_file, std::ios::binary);
+			if (!file) throw std::runtime_error("failed to open '" + in_file + "'");
+			//is the next chunk in the file a 'magic' chunk?
+			auto next_is = [&file](std::string const &magic) {
+				char have[4];
+				bool is = (file.read(have, 4) && std::string(have, 4) == magic);
+				file.clear();
+				file.seekg(-std::streamoff(file.gcount()), std::ios::cur);
+				return is;
+			};
+			read_chunk(file, "pnct", &vertices);
+			indexed = next_is("ind0");
+			if (indexed) read_chunk(file, "ind0", &indices);
+			read_chunk(file, "str0", &strings);
+			read_chunk(file, "idx0", &index);
+			if (indexed) read_chunk(file, "ixr0", &index_ranges);
+			has_lods = indexed && next_is("lod0");
+			if (has_lods) read_chunk(file, "lod0", &lods);
+		}
+
+		//each vertex is quantized relative to the bounds of the mesh that contains it:
+		std::vector< uint32_t > vertex_mesh(vertices.size(), -1U);
+		std::vector< Decode > decode(index.size());
+		std::map< std::pair< uint32_t, uint32_t >, uint32_t > ranges; //meshes that share a vertex range share decoding
+		for (uint32_t m = 0; m < index.size(); ++m) {
+			IndexEntry const &entry = index[m];
+			if (!(entry.vertex_begin <= entry.vertex_end && entry.vertex_end <= vertices.size())) {
+				throw std::runtime_error("index entry has out-of-range vertex start/count");
+			}
+			auto f = ranges.find(std::make_pair(entry.vertex_begin, entry.vertex_end));
+			if (f != ranges.end()) {
+				decode[m] = decode[f->second];
+				continue;
+			}
+			ranges.emplace(std::make_pair(entry.vertex_begin, entry.vertex_end), m);
+			glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+			glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
+			for (uint32_t v = entry.vertex_begin; v < entry.vertex_end; ++v) {
+				if (vertex_mesh[v] != -1U) {
+					throw std::runtime_error("meshes with overlapping vertex ranges can't be quantized separately");
+				}
+				vertex_mesh[v] = m;
+				min = glm::min(min, vertices[v].Position);
+				max = glm::max(max, vertices[v].Position);
+			}
+			if (entry.vertex_begin == entry.vertex_end) {
+				decode[m].offset = glm::vec3(0.0f);
+				decode[m].scale = glm::vec3(0.0f);
+			} else {
+				decode[m].offset = 0.5f * (min + max);
+				decode[m].scale = 0.5f * (max - min);
+			}
+		}
+
+		std::vector< QuantizedVertex > quantized(vertices.size());
+		float max_position_error = 0.0f;
+		float max_normal_error = 0.0f; //(in radians)
+		float max_texcoord_error = 0.0f;
+		for (uint32_t v = 0; v < vertices.size(); ++v) {
+			Vertex const &in = vertices[v];
+			QuantizedVertex &out = quantized[v];
+
+			//vertices outside every mesh are never drawn, so they can be anything:
+			Decode d = (vertex_mesh[v] == -1U ? Decode{glm::vec3(0.0f), glm::vec3(0.0f)} : decode[vertex_mesh[v]]);
+			glm::vec3 position = glm::vec3(0.0f);
+			for (uint32_t c = 0; c < 3; ++c) {
+				out.Position[c] = (d.scale[c] == 0.0f ? 0 : to_snorm16((in.Position[c] - d.offset[c]) / d.scale[c]));
+				position[c] = d.offset[c] + d.scale[c] * from_snorm16(out.Position[c]);
+			}
+			out.Position.w = -32767; //flags octahedral normals for mesh_normal()
+
+			glm::vec3 normal = in.Normal;
+			float length = glm::length(normal);
+			normal = (length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f));
+			glm::vec2 oct = oct_encode(normal);
+			out.Normal = glm::i16vec2(to_snorm16(oct.x), to_snorm16(oct.y));
+			glm::vec3 decoded_normal = oct_decode(glm::vec2(from_snorm16(out.Normal.x), from_snorm16(out.Normal.y)));
+
+			out.Color = in.Color;
+
+			out.TexCoord = glm::u16vec2(glm::packHalf1x16(in.TexCoord.x), glm::packHalf1x16(in.TexCoord.y));
+			glm::vec2 texcoord = glm::vec2(glm::unpackHalf1x16(out.TexCoord.x), glm::unpackHalf1x16(out.TexCoord.y));
+
+			if (vertex_mesh[v] != -1U) {
+				max_position_error = std::max(max_position_error, glm::length(position - in.Position));
+				max_normal_error = std::max(max_normal_error, std::acos(glm::clamp(glm::dot(decoded_normal, normal), -1.0f, 1.0f)));
+				max_texcoord_error = std::max(max_texcoord_error, glm::length(texcoord - in.TexCoord));
+			}
+		}
+
+		{
+			std::ofstream file(out_file, std::ios::binary);
+			write_chunk("pnq0", quantized, &file);
+			if (indexed) write_chunk("ind0", indices, &file);
+			write_chunk("str0", strings, &file);
+			write_chunk("idx0", index, &file);
+			if (indexed) write_chunk("ixr0", index_ranges, &file);
+			if (has_lods) write_chunk("lod0", lods, &file);
+			write_chunk("qdc0", decode, &file);
+			if (!file) throw std::runtime_error("failed to write '" + out_file + "'");
+		}
+
+		size_t in_bytes = vertices.size() * sizeof(Vertex);
+		size_t out_bytes = quantized.size() * sizeof(QuantizedVertex);
+		std::cout << "Quantized " << vertices.size() << " vertices in " << index.size() << " meshes:\n"
+		          << "  vertex data: " << in_bytes << " bytes -> " << out_bytes << " bytes (" << (in_bytes ? 100.0f * out_bytes / in_bytes : 0.0f) << "%)\n"
+		          << "  max position error: " << max_position_error << "\n"
+		          << "  max normal error: " << glm::degrees(max_normal_error) << " degrees\n"
+		          << "  max texcoord error: " << max_texcoord_error << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
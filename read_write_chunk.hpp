@@ -4,6 +4,7 @@
 #include <vector>
 #include <stdexcept>
 #include <cassert>
+#include <cstring>
 
 //helper function that reads an array of structures preceded by a simple header:
 //Expected format:
@@ -41,6 +42,56 @@ void read_chunk(std::istream &from, std::string const &magic, std::vector< T > *
 }
 
 
+//helper function that finds a chunk (in the same format as read_chunk) in memory, without copying it:
+// advances *at_ past the chunk; returns a pointer to the chunk's data and sets *count_ to the number of T's in it
+// note: the data may not be aligned for T, so copy elements out (e.g., with memcpy) instead of dereferencing it as T's
+template< typename T >
+char const *find_chunk(char const **at_, char const *end, std::string const &magic, size_t *count_) {
+	assert(at_ && *at_ && *at_ <= end);
+	assert(count_);
+	char const *&at = *at_;
+
+	struct ChunkHeader {
+		char magic[4] = {'\0', '\0', '\0', '\0'};
+		uint32_t size = 0;
+	};
+	static_assert(sizeof(ChunkHeader) == 8, "header is packed");
+
+	ChunkHeader header;
+	if (size_t(end - at) < sizeof(header)) {
+		throw std::runtime_error("Failed to read chunk header");
+	}
+	std::memcpy(&header, at, sizeof(header));
+	if (std::string(header.magic,4) != magic) {
+		throw std::runtime_error("Unexpected magic number in chunk");
+	}
+
+	if (header.size % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+	if (size_t(end - at) - sizeof(header) < header.size) {
+		throw std::runtime_error("Failed to read chunk data.");
+	}
+
+	char const *data = at + sizeof(header);
+	at = data + header.size;
+	*count_ = header.size / sizeof(T);
+	return data;
+}
+
+//...and a version of read_chunk that copies a chunk out of memory:
+template< typename T >
+void read_chunk(char const **at_, char const *end, std::string const &magic, std::vector< T > *to_) {
+	assert(to_);
+	auto &to = *to_;
+
+	size_t count = 0;
+	char const *data = find_chunk< T >(at_, end, magic, &count);
+	to.resize(count);
+	if (count) std::memcpy(to.data(), data, count * sizeof(T));
+}
+
+
 //helper function to write a chunk of data in the same format as read_chunk:
 template< typename T >
 void write_chunk(std::string const &magic, std::vector< T > const &from, std::ostream *to_) {
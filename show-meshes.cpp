@@ -3,6 +3,7 @@
 #include "Load.hpp"
 #include "GL.hpp"
 #include "load_save_png.hpp"
+#include "headless.hpp"
 
 #include <SDL.h>
 
@@ -18,9 +19,22 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command line ------------
+
+	//(headless options are removed from args as they are parsed)
+	std::vector< std::string > args(argv + 1, argv + argc);
+	Headless headless;
+	try {
+		headless.parse(&args);
+	} catch (std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << "\n" << Headless::usage;
+		return 1;
+	}
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
+	headless.init_video_driver();
 	SDL_Init(SDL_INIT_VIDEO);
 
 	//Ask for an OpenGL context version 3.3, core profile, enable debug:
@@ -43,6 +57,7 @@ int main(int argc, char **argv) {
 		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
 		800, 800,
 		SDL_WINDOW_OPENGL
+		| (headless.enabled ? SDL_WINDOW_HIDDEN : 0) //(headless mode draws offscreen)
 		| SDL_WINDOW_RESIZABLE //uncomment to allow resizing
 		| SDL_WINDOW_ALLOW_HIGHDPI //uncomment for full resolution on high-DPI screens
 	);
@@ -68,7 +83,10 @@ int main(int argc, char **argv) {
 	init_GL();
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
-	if (SDL_GL_SetSwapInterval(-1) != 0) {
+	// (except in headless mode, which never swaps)
+	if (headless.enabled) {
+		//no vsync needed
+	} else if (SDL_GL_SetSwapInterval(-1) != 0) {
 		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
 		if (SDL_GL_SetSwapInterval(1) != 0) {
 			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
@@ -81,26 +99,37 @@ int main(int argc, char **argv) {
 	//------------ create game mode + make current --------------
 	bool usage = false;
 	MeshBuffer *buffer = nullptr;
-	if (argc == 2) {
+	if (args.size() == 1) {
 		try {
-			buffer = new MeshBuffer(argv[1]);
+			buffer = new MeshBuffer(args[0]);
 		} catch (std::exception &e) {
 			std::cerr << "ERROR: " << e.what() << std::endl;
 			usage = true;
 			buffer = nullptr;
 		}
 	}
+	std::shared_ptr< ShowMeshesMode > mode;
 	if (buffer) {
-		Mode::set_current(std::make_shared< ShowMeshesMode >(*buffer));
+		mode = std::make_shared< ShowMeshesMode >(*buffer);
+		Mode::set_current(mode);
 	}
 	if (!Mode::current) {
 		usage = true;
 	}
 	if (usage) {
-		std::cerr << "Usage:\n\t" << argv[0] << " [path/to/meshes.pnct]" << std::endl;
+		std::cerr << "Usage:\n\t" << argv[0] << " [headless options] [path/to/meshes.pnct]\n" << Headless::usage;
 		return 1;
 	}
 
+	if (headless.enabled) {
+		//fixed camera path: one orbit around the first mesh
+		float start_azimuth = mode->camera.azimuth;
+		headless.run([&](float t){
+			mode->camera.azimuth = start_azimuth + t * 2.0f * 3.1415926f;
+		});
+		Mode::set_current(nullptr); //(skips the main loop)
+	}
+
 	//------------ main loop ------------
 
 	//this inline function will be called whenever the window is resized,
@@ -3,7 +3,9 @@
 #include "Load.hpp"
 #include "GL.hpp"
 #include "load_save_png.hpp"
+#include "headless.hpp"
 #include "ShowSceneProgram.hpp"
+#include "BakedScene.hpp"
 
 #include <SDL.h>
 
@@ -19,9 +21,22 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command line ------------
+
+	//(headless options are removed from args as they are parsed)
+	std::vector< std::string > args(argv + 1, argv + argc);
+	Headless headless;
+	try {
+		headless.parse(&args);
+	} catch (std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << "\n" << Headless::usage;
+		return 1;
+	}
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
+	headless.init_video_driver();
 	SDL_Init(SDL_INIT_VIDEO);
 
 	//Ask for an OpenGL context version 3.3, core profile, enable debug:
@@ -44,6 +59,7 @@ int main(int argc, char **argv) {
 		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
 		800, 800,
 		SDL_WINDOW_OPENGL
+		| (headless.enabled ? SDL_WINDOW_HIDDEN : 0) //(headless mode draws offscreen)
 		| SDL_WINDOW_RESIZABLE //uncomment to allow resizing
 		| SDL_WINDOW_ALLOW_HIGHDPI //uncomment for full resolution on high-DPI screens
 	);
@@ -69,7 +85,10 @@ int main(int argc, char **argv) {
 	init_GL();
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
-	if (SDL_GL_SetSwapInterval(-1) != 0) {
+	// (except in headless mode, which never swaps)
+	if (headless.enabled) {
+		//no vsync needed
+	} else if (SDL_GL_SetSwapInterval(-1) != 0) {
 		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
 		if (SDL_GL_SetSwapInterval(1) != 0) {
 			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
@@ -83,11 +102,11 @@ int main(int argc, char **argv) {
 	bool usage = false;
 	std::string scene_file;
 	std::string meshes_file;
-	if (argc == 2) {
-		scene_file = argv[1];
-	} else if (argc == 3) {
-		scene_file = argv[1];
-		meshes_file = argv[2];
+	if (args.size() == 1) {
+		scene_file = args[0];
+	} else if (args.size() == 2) {
+		scene_file = args[0];
+		meshes_file = args[1];
 	} else {
 		usage = true;
 	}
@@ -107,21 +126,41 @@ int main(int argc, char **argv) {
 	if (scene_file != "") {
 		try {
 			scene = new Scene();
-			scene->load(scene_file, [&buffer,&buffer_vao](Scene &scene, Scene::Transform *transform, std::string const &mesh_name){
-				if (!buffer_vao) return;
-				Mesh const &mesh = buffer->lookup(mesh_name);
-
-				scene.drawables.emplace_back(transform);
-				Scene::Drawable &drawable = scene.drawables.back();
-
-				drawable.pipeline = show_scene_program_pipeline;
+			if (scene_file.size() >= 7 && scene_file.substr(scene_file.size() - 7) == ".bscene") {
+				//baked scenes (see bake-scene.cpp) already have their mesh ranges, so only need the vertex array:
+				// (with no meshes to draw with, everything but the drawables is shown)
+				BakedScene baked(scene_file);
+				Scene::Drawable::Pipeline pipeline = show_scene_program_pipeline;
+				pipeline.vao = buffer_vao;
+				baked.instantiate(scene, buffer_vao ? buffer : nullptr, pipeline);
+			} else {
+				scene->load(scene_file, [&buffer,&buffer_vao](Scene &scene, Scene::Transform *transform, std::string const &mesh_name){
+					if (!buffer_vao) return;
+					Mesh const &mesh = buffer->lookup(mesh_name);
+
+					scene.drawables.emplace_back(transform);
+					Scene::Drawable &drawable = scene.drawables.back();
+
+					drawable.pipeline = show_scene_program_pipeline;
+
+					drawable.pipeline.vao = buffer_vao;
+					drawable.pipeline.type = mesh.type;
+					drawable.pipeline.start = mesh.start;
+					drawable.pipeline.count = mesh.count;
+					drawable.pipeline.index_type = mesh.index_type;
+					for (uint32_t i = 0; i < Scene::Drawable::Pipeline::LODCount && i < mesh.lods.size(); ++i) {
+						drawable.pipeline.lods[i].start = mesh.lods[i].start;
+						drawable.pipeline.lods[i].count = mesh.lods[i].count;
+						drawable.pipeline.lods[i].error = mesh.lods[i].error;
+					}
+					drawable.pipeline.position_offset = mesh.position_offset;
+					drawable.pipeline.position_scale = mesh.position_scale;
 
-				drawable.pipeline.vao = buffer_vao;
-				drawable.pipeline.type = mesh.type;
-				drawable.pipeline.start = mesh.start;
-				drawable.pipeline.count = mesh.count;
+					drawable.min = mesh.min;
+					drawable.max = mesh.max;
 
-			});
+				});
+			}
 		} catch (std::exception &e) {
 			std::cerr << "ERROR loading scene '" << scene_file << "': " << e.what() << std::endl;
 			usage = true;
@@ -132,7 +171,7 @@ int main(int argc, char **argv) {
 		usage = true;
 	}
 	if (usage) {
-		std::cerr << "Usage:\n\t" << argv[0] << " <path/to/scene.scene> [path/to/meshes.pnct]" << std::endl;
+		std::cerr << "Usage:\n\t" << argv[0] << " [headless options] <path/to/scene.scene|scene.bscene> [path/to/meshes.pnct]\n" << Headless::usage;
 		return 1;
 	}
 	std::cout << "Showing scene from '" << scene_file << "' with";
@@ -141,7 +180,17 @@ int main(int argc, char **argv) {
 	} else {
 		std::cout << " no meshes -- consider passing a '.pnct' file as the second argument." << std::endl;
 	}
-	Mode::set_current(std::make_shared< ShowSceneMode >(*scene));
+	auto mode = std::make_shared< ShowSceneMode >(*scene);
+	Mode::set_current(mode);
+
+	if (headless.enabled) {
+		//fixed camera path: one orbit around the starting view
+		float start_azimuth = mode->camera.azimuth;
+		headless.run([&](float t){
+			mode->camera.azimuth = start_azimuth + t * 2.0f * 3.1415926f;
+		});
+		Mode::set_current(nullptr); //(skips the main loop)
+	}
 
 	//------------ main loop ------------
 
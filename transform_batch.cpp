@@ -0,0 +1,341 @@
+#include "transform_batch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TRANSFORM_BATCH_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+//the SIMD kernels read glm types directly as packed floats:
+static_assert(sizeof(glm::vec3) == 3*4, "vec3 is packed.");
+static_assert(sizeof(glm::quat) == 4*4, "quat is packed.");
+static_assert(sizeof(glm::mat4x3) == 4*3*4, "mat4x3 is packed.");
+static_assert(offsetof(glm::quat, x) == 0 && offsetof(glm::quat, w) == 3*4, "quat is stored xyzw.");
+
+//------------------------------------------------
+//Scalar kernel -- same math as Scene::Transform::make_local_to_parent() / make_parent_to_local():
+
+static void scalar_kernel(size_t count,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales,
+	glm::mat4x3 *local_to_parent, glm::mat4x3 *parent_to_local) {
+
+	for (size_t i = 0; i < count; ++i) {
+		glm::vec3 const &position = positions[i];
+		glm::quat const &rotation = rotations[i];
+		glm::vec3 const &scale = scales[i];
+
+		if (local_to_parent) {
+			glm::mat3 rot = glm::mat3_cast(rotation);
+			local_to_parent[i] = glm::mat4x3(
+				rot[0] * scale.x,
+				rot[1] * scale.y,
+				rot[2] * scale.z,
+				position
+			);
+		}
+
+		if (parent_to_local) {
+			glm::vec3 inv_scale;
+			inv_scale.x = (scale.x == 0.0f ? 0.0f : 1.0f / scale.x);
+			inv_scale.y = (scale.y == 0.0f ? 0.0f : 1.0f / scale.y);
+			inv_scale.z = (scale.z == 0.0f ? 0.0f : 1.0f / scale.z);
+
+			glm::mat3 inv_rot = glm::mat3_cast(glm::inverse(rotation));
+			inv_rot[0] *= inv_scale;
+			inv_rot[1] *= inv_scale;
+			inv_rot[2] *= inv_scale;
+
+			parent_to_local[i] = glm::mat4x3(
+				inv_rot[0],
+				inv_rot[1],
+				inv_rot[2],
+				inv_rot * -position
+			);
+		}
+	}
+}
+
+#ifdef TRANSFORM_BATCH_X86
+
+//------------------------------------------------
+//SSE helpers -- convert between four packed structures and structure-of-arrays registers:
+
+//read four vec3's into x, y, z registers:
+// NOTE: reads one float past the fourth vec3, so caller must make sure that is in-bounds
+static inline void load_vec3x4(float const *from, __m128 *x, __m128 *y, __m128 *z) {
+	__m128 r0 = _mm_loadu_ps(from + 0);
+	__m128 r1 = _mm_loadu_ps(from + 3);
+	__m128 r2 = _mm_loadu_ps(from + 6);
+	__m128 r3 = _mm_loadu_ps(from + 9);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	*x = r0; *y = r1; *z = r2;
+}
+
+//read four quats into x, y, z, w registers:
+static inline void load_quatx4(float const *from, __m128 *x, __m128 *y, __m128 *z, __m128 *w) {
+	__m128 r0 = _mm_loadu_ps(from + 0);
+	__m128 r1 = _mm_loadu_ps(from + 4);
+	__m128 r2 = _mm_loadu_ps(from + 8);
+	__m128 r3 = _mm_loadu_ps(from + 12);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	*x = r0; *y = r1; *z = r2; *w = r3;
+}
+
+//write twelve registers (one per matrix element, in column-major order) as four mat4x3's:
+static inline void store_mat4x3x4(__m128 const m[12], float *to) {
+	for (uint32_t g = 0; g < 3; ++g) {
+		__m128 r0 = m[4*g+0], r1 = m[4*g+1], r2 = m[4*g+2], r3 = m[4*g+3];
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(to + 0*12 + 4*g, r0);
+		_mm_storeu_ps(to + 1*12 + 4*g, r1);
+		_mm_storeu_ps(to + 2*12 + 4*g, r2);
+		_mm_storeu_ps(to + 3*12 + 4*g, r3);
+	}
+}
+
+//------------------------------------------------
+//SSE kernel -- four transforms at a time:
+
+static void sse_kernel(size_t count,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales,
+	glm::mat4x3 *local_to_parent, glm::mat4x3 *parent_to_local) {
+
+	__m128 const zero = _mm_setzero_ps();
+	__m128 const one = _mm_set1_ps(1.0f);
+	__m128 const two = _mm_set1_ps(2.0f);
+
+	size_t i = 0;
+	//(strictly less-than so that load_vec3x4's over-read stays in bounds)
+	for (; i + 4 < count; i += 4) {
+		__m128 px, py, pz, qx, qy, qz, qw, sx, sy, sz;
+		load_vec3x4(&positions[i].x, &px, &py, &pz);
+		load_quatx4(&rotations[i].x, &qx, &qy, &qz, &qw);
+		load_vec3x4(&scales[i].x, &sx, &sy, &sz);
+
+		//rotation matrix columns (same formula as glm::mat3_cast):
+		auto rotation = [&](__m128 x, __m128 y, __m128 z, __m128 w, __m128 c[9]) {
+			__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+			__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+			__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+			c[0] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+			c[1] = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+			c[2] = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+			c[3] = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+			c[4] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+			c[5] = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+			c[6] = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+			c[7] = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+			c[8] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+		};
+
+		if (local_to_parent) {
+			__m128 m[12];
+			rotation(qx, qy, qz, qw, m);
+			m[0] = _mm_mul_ps(m[0], sx); m[1] = _mm_mul_ps(m[1], sx); m[2] = _mm_mul_ps(m[2], sx);
+			m[3] = _mm_mul_ps(m[3], sy); m[4] = _mm_mul_ps(m[4], sy); m[5] = _mm_mul_ps(m[5], sy);
+			m[6] = _mm_mul_ps(m[6], sz); m[7] = _mm_mul_ps(m[7], sz); m[8] = _mm_mul_ps(m[8], sz);
+			m[9] = px; m[10] = py; m[11] = pz;
+			store_mat4x3x4(m, &local_to_parent[i][0][0]);
+		}
+
+		if (parent_to_local) {
+			//inverse rotation is conjugate / squared length (as in glm::inverse):
+			__m128 inv_len2 = _mm_div_ps(one, _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+				_mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw))));
+			__m128 neg = _mm_sub_ps(zero, inv_len2);
+
+			//inverse scale, with zero scale mapping to zero (not inf/NaN):
+			__m128 isx = _mm_and_ps(_mm_cmpneq_ps(sx, zero), _mm_div_ps(one, sx));
+			__m128 isy = _mm_and_ps(_mm_cmpneq_ps(sy, zero), _mm_div_ps(one, sy));
+			__m128 isz = _mm_and_ps(_mm_cmpneq_ps(sz, zero), _mm_div_ps(one, sz));
+
+			__m128 m[12];
+			rotation(_mm_mul_ps(qx, neg), _mm_mul_ps(qy, neg), _mm_mul_ps(qz, neg), _mm_mul_ps(qw, inv_len2), m);
+			for (uint32_t c = 0; c < 3; ++c) {
+				m[3*c+0] = _mm_mul_ps(m[3*c+0], isx);
+				m[3*c+1] = _mm_mul_ps(m[3*c+1], isy);
+				m[3*c+2] = _mm_mul_ps(m[3*c+2], isz);
+			}
+			for (uint32_t r = 0; r < 3; ++r) {
+				__m128 t = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(m[0+r], px),
+					_mm_mul_ps(m[3+r], py)),
+					_mm_mul_ps(m[6+r], pz));
+				m[9+r] = _mm_sub_ps(zero, t);
+			}
+			store_mat4x3x4(m, &parent_to_local[i][0][0]);
+		}
+	}
+
+	//leftovers:
+	scalar_kernel(count - i, positions + i, rotations + i, scales + i,
+		(local_to_parent ? local_to_parent + i : nullptr),
+		(parent_to_local ? parent_to_local + i : nullptr));
+}
+
+//------------------------------------------------
+//AVX2 kernel -- eight transforms at a time:
+// (loads and stores go through the SSE transposes above, two halves at a time)
+
+TARGET_AVX2 static inline __m256 combine(__m128 lo, __m128 hi) {
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+TARGET_AVX2 static inline void rotation8(__m256 x, __m256 y, __m256 z, __m256 w, __m256 c[9]) {
+	__m256 const one = _mm256_set1_ps(1.0f);
+	__m256 const two = _mm256_set1_ps(2.0f);
+	__m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+	__m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+	__m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+	c[0] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz)));
+	c[1] = _mm256_mul_ps(two, _mm256_add_ps(xy, wz));
+	c[2] = _mm256_mul_ps(two, _mm256_sub_ps(xz, wy));
+	c[3] = _mm256_mul_ps(two, _mm256_sub_ps(xy, wz));
+	c[4] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz)));
+	c[5] = _mm256_mul_ps(two, _mm256_add_ps(yz, wx));
+	c[6] = _mm256_mul_ps(two, _mm256_add_ps(xz, wy));
+	c[7] = _mm256_mul_ps(two, _mm256_sub_ps(yz, wx));
+	c[8] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy)));
+}
+
+TARGET_AVX2 static inline void store_mat4x3x8(__m256 const m[12], float *to) {
+	__m128 lo[12], hi[12];
+	for (uint32_t e = 0; e < 12; ++e) {
+		lo[e] = _mm256_castps256_ps128(m[e]);
+		hi[e] = _mm256_extractf128_ps(m[e], 1);
+	}
+	store_mat4x3x4(lo, to);
+	store_mat4x3x4(hi, to + 4*12);
+}
+
+TARGET_AVX2 static void avx2_kernel(size_t count,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales,
+	glm::mat4x3 *local_to_parent, glm::mat4x3 *parent_to_local) {
+
+	__m256 const zero = _mm256_setzero_ps();
+	__m256 const one = _mm256_set1_ps(1.0f);
+
+	size_t i = 0;
+	//(strictly less-than so that load_vec3x4's over-read stays in bounds)
+	for (; i + 8 < count; i += 8) {
+		__m256 px, py, pz, qx, qy, qz, qw, sx, sy, sz;
+		{
+			__m128 x[2], y[2], z[2], w[2];
+			for (uint32_t h = 0; h < 2; ++h) load_vec3x4(&positions[i+4*h].x, &x[h], &y[h], &z[h]);
+			px = combine(x[0], x[1]); py = combine(y[0], y[1]); pz = combine(z[0], z[1]);
+			for (uint32_t h = 0; h < 2; ++h) load_quatx4(&rotations[i+4*h].x, &x[h], &y[h], &z[h], &w[h]);
+			qx = combine(x[0], x[1]); qy = combine(y[0], y[1]); qz = combine(z[0], z[1]); qw = combine(w[0], w[1]);
+			for (uint32_t h = 0; h < 2; ++h) load_vec3x4(&scales[i+4*h].x, &x[h], &y[h], &z[h]);
+			sx = combine(x[0], x[1]); sy = combine(y[0], y[1]); sz = combine(z[0], z[1]);
+		}
+
+		if (local_to_parent) {
+			__m256 m[12];
+			rotation8(qx, qy, qz, qw, m);
+			m[0] = _mm256_mul_ps(m[0], sx); m[1] = _mm256_mul_ps(m[1], sx); m[2] = _mm256_mul_ps(m[2], sx);
+			m[3] = _mm256_mul_ps(m[3], sy); m[4] = _mm256_mul_ps(m[4], sy); m[5] = _mm256_mul_ps(m[5], sy);
+			m[6] = _mm256_mul_ps(m[6], sz); m[7] = _mm256_mul_ps(m[7], sz); m[8] = _mm256_mul_ps(m[8], sz);
+			m[9] = px; m[10] = py; m[11] = pz;
+			store_mat4x3x8(m, &local_to_parent[i][0][0]);
+		}
+
+		if (parent_to_local) {
+			//inverse rotation is conjugate / squared length (as in glm::inverse):
+			__m256 inv_len2 = _mm256_div_ps(one, _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(qx, qx), _mm256_mul_ps(qy, qy)),
+				_mm256_add_ps(_mm256_mul_ps(qz, qz), _mm256_mul_ps(qw, qw))));
+			__m256 neg = _mm256_sub_ps(zero, inv_len2);
+
+			//inverse scale, with zero scale mapping to zero (not inf/NaN):
+			__m256 isx = _mm256_and_ps(_mm256_cmp_ps(sx, zero, _CMP_NEQ_UQ), _mm256_div_ps(one, sx));
+			__m256 isy = _mm256_and_ps(_mm256_cmp_ps(sy, zero, _CMP_NEQ_UQ), _mm256_div_ps(one, sy));
+			__m256 isz = _mm256_and_ps(_mm256_cmp_ps(sz, zero, _CMP_NEQ_UQ), _mm256_div_ps(one, sz));
+
+			__m256 m[12];
+			rotation8(_mm256_mul_ps(qx, neg), _mm256_mul_ps(qy, neg), _mm256_mul_ps(qz, neg), _mm256_mul_ps(qw, inv_len2), m);
+			for (uint32_t c = 0; c < 3; ++c) {
+				m[3*c+0] = _mm256_mul_ps(m[3*c+0], isx);
+				m[3*c+1] = _mm256_mul_ps(m[3*c+1], isy);
+				m[3*c+2] = _mm256_mul_ps(m[3*c+2], isz);
+			}
+			for (uint32_t r = 0; r < 3; ++r) {
+				__m256 t = _mm256_add_ps(_mm256_add_ps(
+					_mm256_mul_ps(m[0+r], px),
+					_mm256_mul_ps(m[3+r], py)),
+					_mm256_mul_ps(m[6+r], pz));
+				m[9+r] = _mm256_sub_ps(zero, t);
+			}
+			store_mat4x3x8(m, &parent_to_local[i][0][0]);
+		}
+	}
+
+	//leftovers:
+	sse_kernel(count - i, positions + i, rotations + i, scales + i,
+		(local_to_parent ? local_to_parent + i : nullptr),
+		(parent_to_local ? parent_to_local + i : nullptr));
+}
+
+//------------------------------------------------
+
+static bool cpu_has_avx2() {
+	#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!(osxsave && avx)) return false;
+	//make sure the OS saves ymm registers:
+	if ((_xgetbv(0) & 0x6) != 0x6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+	#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+	#endif
+}
+
+#endif //TRANSFORM_BATCH_X86
+
+TransformBatchKernel transform_batch_kernel() {
+	#ifdef TRANSFORM_BATCH_X86
+	static TransformBatchKernel kernel = (cpu_has_avx2() ? TransformBatchAVX2 : TransformBatchSSE);
+	return kernel;
+	#else
+	return TransformBatchScalar;
+	#endif
+}
+
+void make_local_to_parent_batch(TransformBatchKernel kernel, size_t count,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales,
+	glm::mat4x3 *local_to_parent, glm::mat4x3 *parent_to_local) {
+
+	#ifdef TRANSFORM_BATCH_X86
+	if (kernel == TransformBatchAVX2 && transform_batch_kernel() == TransformBatchAVX2) {
+		avx2_kernel(count, positions, rotations, scales, local_to_parent, parent_to_local);
+		return;
+	}
+	if (kernel == TransformBatchSSE || kernel == TransformBatchAVX2) {
+		//(SSE2 is always present on x86-64)
+		sse_kernel(count, positions, rotations, scales, local_to_parent, parent_to_local);
+		return;
+	}
+	#endif
+	scalar_kernel(count, positions, rotations, scales, local_to_parent, parent_to_local);
+}
+
+void make_local_to_parent_batch(size_t count,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales,
+	glm::mat4x3 *local_to_parent, glm::mat4x3 *parent_to_local) {
+	make_local_to_parent_batch(transform_batch_kernel(), count, positions, rotations, scales, local_to_parent, parent_to_local);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+/*
+ * Batched versions of Scene::Transform::make_local_to_parent() and
+ * make_parent_to_local() that build many matrices at once from packed
+ * position / rotation / scale arrays.
+ *
+ * Uses AVX2 or SSE when the CPU supports them (checked once, at runtime),
+ * and falls back to scalar code otherwise.
+ *
+ */
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+
+//compute matrices for 'count' transforms:
+// local_to_parent[i] == make_local_to_parent() for (positions[i], rotations[i], scales[i])
+// parent_to_local[i] == make_parent_to_local() for the same
+// either output may be nullptr if it isn't wanted
+void make_local_to_parent_batch(size_t count,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales,
+	glm::mat4x3 *local_to_parent, glm::mat4x3 *parent_to_local = nullptr);
+
+//the different implementations of the above, for comparison:
+enum TransformBatchKernel {
+	TransformBatchScalar,
+	TransformBatchSSE,
+	TransformBatchAVX2,
+};
+
+//which kernel make_local_to_parent_batch() uses on this machine:
+TransformBatchKernel transform_batch_kernel();
+
+//run a specific kernel:
+// (if it isn't supported on this machine, the next-best supported kernel is used)
+void make_local_to_parent_batch(TransformBatchKernel kernel, size_t count,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales,
+	glm::mat4x3 *local_to_parent, glm::mat4x3 *parent_to_local);
@@ -0,0 +1,151 @@
+#include "vertex_cache.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+float compute_acmr(uint32_t const *indices, size_t count, uint32_t cache_size) {
+	if (count < 3) return 0.0f;
+
+	//FIFO cache, as a ring buffer of vertex indices:
+	std::vector< uint32_t > cache(cache_size, -1U);
+	uint32_t next = 0;
+	size_t misses = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if (std::find(cache.begin(), cache.end(), indices[i]) != cache.end()) continue;
+		misses += 1;
+		cache[next] = indices[i];
+		next = (next + 1) % cache_size;
+	}
+	return float(misses) / float(count / 3);
+}
+
+//scoring function from Forsyth's article (with his suggested constants):
+static float vertex_score(int32_t cache_position, uint32_t remaining_triangles) {
+	if (remaining_triangles == 0) return -1.0f; //no triangles left to draw; never chosen
+
+	float score = 0.0f;
+	if (cache_position < 0) {
+		//not in cache; no score from position
+	} else if (cache_position < 3) {
+		//used by the last triangle, so gets a fixed score (otherwise the triangle would just get re-chosen):
+		score = 0.75f;
+	} else {
+		//score falls off with position in cache:
+		float scaler = 1.0f / float(VertexCacheSize - 3);
+		score = std::pow(1.0f - float(cache_position - 3) * scaler, 1.5f);
+	}
+
+	//bonus for vertices with few triangles left, so they are finished off instead of lingering:
+	score += 2.0f * std::pow(float(remaining_triangles), -0.5f);
+
+	return score;
+}
+
+void optimize_vertex_cache(uint32_t *indices, size_t count, uint32_t vertex_count) {
+	assert(count % 3 == 0);
+	uint32_t triangle_count = uint32_t(count / 3);
+	if (triangle_count < 2) return;
+
+	//triangles using each vertex (as offsets into one big list):
+	std::vector< uint32_t > remaining(vertex_count, 0);
+	for (size_t i = 0; i < count; ++i) {
+		assert(indices[i] < vertex_count);
+		remaining[indices[i]] += 1;
+	}
+	std::vector< uint32_t > adjacency_begin(vertex_count + 1, 0);
+	for (uint32_t v = 0; v < vertex_count; ++v) {
+		adjacency_begin[v+1] = adjacency_begin[v] + remaining[v];
+	}
+	std::vector< uint32_t > adjacency(count);
+	{
+		std::vector< uint32_t > fill(adjacency_begin.begin(), adjacency_begin.end() - 1);
+		for (uint32_t t = 0; t < triangle_count; ++t) {
+			for (uint32_t c = 0; c < 3; ++c) {
+				adjacency[fill[indices[3*t+c]]++] = t;
+			}
+		}
+	}
+
+	std::vector< int32_t > cache_position(vertex_count, -1);
+	std::vector< float > score(vertex_count);
+	for (uint32_t v = 0; v < vertex_count; ++v) {
+		score[v] = vertex_score(-1, remaining[v]);
+	}
+
+	std::vector< bool > emitted(triangle_count, false);
+	std::vector< float > triangle_score(triangle_count);
+	for (uint32_t t = 0; t < triangle_count; ++t) {
+		triangle_score[t] = score[indices[3*t+0]] + score[indices[3*t+1]] + score[indices[3*t+2]];
+	}
+
+	//(cache has a few extra slots to hold the vertices pushed out by a triangle)
+	std::vector< uint32_t > cache, next_cache;
+	cache.reserve(VertexCacheSize + 3);
+	next_cache.reserve(VertexCacheSize + 3);
+
+	std::vector< uint32_t > output;
+	output.reserve(count);
+
+	uint32_t best = -1U;
+	uint32_t scan = 0; //triangles before 'scan' have all been emitted
+	while (output.size() < count) {
+		if (best == -1U) {
+			//nothing good in the cache, so take the best remaining triangle overall:
+			// (this is the slow path; it happens when a connected piece of the mesh is finished)
+			while (emitted[scan]) ++scan;
+			best = scan;
+			for (uint32_t t = scan + 1; t < triangle_count; ++t) {
+				if (!emitted[t] && triangle_score[t] > triangle_score[best]) best = t;
+			}
+		}
+
+		//emit triangle:
+		emitted[best] = true;
+		uint32_t const *tri = indices + 3 * best;
+		output.insert(output.end(), tri, tri + 3);
+
+		//remove it from its vertices' adjacency lists:
+		for (uint32_t c = 0; c < 3; ++c) {
+			uint32_t v = tri[c];
+			uint32_t *begin = adjacency.data() + adjacency_begin[v];
+			uint32_t *end = begin + remaining[v];
+			*std::find(begin, end, best) = *(end - 1);
+			remaining[v] -= 1;
+		}
+
+		//move triangle's vertices to the front of the cache:
+		next_cache.assign(tri, tri + 3);
+		for (uint32_t v : cache) {
+			if (v != tri[0] && v != tri[1] && v != tri[2]) next_cache.emplace_back(v);
+		}
+		std::swap(cache, next_cache);
+
+		//update scores of vertices in (or falling out of) the cache:
+		for (uint32_t i = 0; i < cache.size(); ++i) {
+			uint32_t v = cache[i];
+			cache_position[v] = (i < VertexCacheSize ? int32_t(i) : -1);
+			score[v] = vertex_score(cache_position[v], remaining[v]);
+		}
+
+		//rescore triangles touching the cache, and pick the best one for next time:
+		best = -1U;
+		float best_score = -1.0f;
+		for (uint32_t v : cache) {
+			for (uint32_t a = adjacency_begin[v]; a < adjacency_begin[v] + remaining[v]; ++a) {
+				uint32_t t = adjacency[a];
+				uint32_t const *other = indices + 3 * t;
+				triangle_score[t] = score[other[0]] + score[other[1]] + score[other[2]];
+				if (triangle_score[t] > best_score) {
+					best_score = triangle_score[t];
+					best = t;
+				}
+			}
+		}
+
+		if (cache.size() > VertexCacheSize) cache.resize(VertexCacheSize);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+/*
+ * Helpers for making indexed triangle lists friendly to the GPU's
+ * post-transform vertex cache.
+ *
+ * The cache is modelled as a FIFO (which is roughly how most hardware
+ * behaves); "ACMR" (average cache miss ratio) is the number of vertices
+ * transformed per triangle: 3.0 with no reuse, ~0.5-0.7 for well-ordered
+ * regular meshes.
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+//cache size assumed by the functions below:
+constexpr uint32_t VertexCacheSize = 32;
+
+//average cache miss ratio of drawing 'count' indices (count / 3 triangles) in order:
+float compute_acmr(uint32_t const *indices, size_t count, uint32_t cache_size = VertexCacheSize);
+
+//reorder the triangles in indices[0,count) for cache locality
+// (Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"):
+// indices must refer to vertices in [0, vertex_count)
+void optimize_vertex_cache(uint32_t *indices, size_t count, uint32_t vertex_count);